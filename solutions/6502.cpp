@@ -1,12 +1,50 @@
 #include "headers/cpu.h"
-#include "headers/table.h"
 #include "headers/input.h"
+#include "headers/romindex.h"
+#include "headers/rewind.h"
+#include "headers/netplay.h"
+#include "headers/movie.h"
+#include "headers/console.h"
+#include "headers/hash.h"
+#include "headers/fingerprint.h"
+#include "headers/threadpool.h"
+#include "headers/tracefile.h"
+#include "headers/tracerecorder.h"
+#include "headers/tracestore.h"
+#include "headers/profiler.h"
+#include "headers/heatmap.h"
+#include "headers/ppulog.h"
+#ifdef NES_HAS_GUI
+#include "headers/gui.h"
+#endif
 
+#include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#define BATCH_HAVE_SPAWN 1
+#else
+#define BATCH_HAVE_SPAWN 0
+#endif
 
 
 
@@ -14,97 +52,904 @@
 #include "headers/bus.h"
 
 
-struct ExpectedTrace {
-	uint16_t pc = 0;
-	uint8_t op1 = 0;
-	uint8_t op2 = 0;
-	uint8_t op3 = 0;
-	uint8_t a = 0;
-	uint8_t x = 0;
-	uint8_t y = 0;
-	uint8_t p = 0;
-	uint8_t sp = 0;
-	uint64_t cycles = 0;
+// Open a golden trace for comparison. Text logs are converted to a binary
+// file next to them ("<log>.ntr") on first use and whenever the log is newer.
+static bool OpenGoldenTrace(const std::string& path, TraceFileView& view) {
+	if (view.Open(path)) return true;
+	std::string binPath = path + ".ntr";
+	std::error_code textErr, binErr;
+	auto textTime = std::filesystem::last_write_time(path, textErr);
+	if (textErr) {
+		std::cerr << "Failed to open trace log: " << path << "\n";
+		return false;
+	}
+	auto binTime = std::filesystem::last_write_time(binPath, binErr);
+	if (!binErr && binTime >= textTime && view.Open(binPath)) return true;
+	int64_t records = ConvertTraceLog(path, binPath);
+	if (records < 0) return false;
+	std::cerr << "Converted " << path << " -> " << binPath << " (" << records << " instructions)\n";
+	return view.Open(binPath);
+}
+
+// Build/refresh the ROM library index for a directory and list its entries
+static int RunIndexMode(const std::string& dir, const std::string& indexPath) {
+	RomIndex index;
+	index.Load(indexPath);
+	size_t hashed = index.Scan(dir);
+	if (!index.Save(indexPath)) return 1;
+
+	for (const RomInfo& info : index.Entries()) {
+		const char* fmt = info.format == RomFormat::NES20 ? "NES2.0" : (info.format == RomFormat::INES ? "iNES" : "raw");
+		std::printf("%016llx  %-6s mapper %3u  PRG %4uK  CHR %4uK  %s\n",
+			static_cast<unsigned long long>(info.hash), fmt, unsigned(info.mapper),
+			info.prgSize / 1024, info.chrSize / 1024, info.path.c_str());
+	}
+	std::cout << index.Entries().size() << " ROMs indexed (" << hashed << " hashed) -> " << indexPath << std::endl;
+	return 0;
+}
+
+// Deterministic stand-in for a player's pad: a new button combination every 20 frames
+static uint8_t ScriptedInput(int player, uint32_t frame) {
+	uint32_t seg[2] = { static_cast<uint32_t>(player), frame / 20 };
+	return static_cast<uint8_t>(Hash64(seg, sizeof(seg)));
+}
+
+// Headless two-player rollback session over UDP with scripted inputs. Run one
+// process per player; both print the same state hash when they stay in sync.
+static int RunNetplayMode(int argc, char** argv) {
+	if (argc < 7) {
+		std::cerr << "Usage: netplay <rom> <player 0|1> <localPort> <remoteHost> <remotePort> [frames] [fps]\n";
+		return 1;
+	}
+	Console console;
+	if (!console.LoadROM(argv[2])) return 1;
+
+	int player = std::stoi(argv[3]) ? 1 : 0;
+	UdpSocket socket;
+	if (!socket.Bind(static_cast<uint16_t>(std::stoi(argv[4]))) ||
+		!socket.SetPeer(argv[5], static_cast<uint16_t>(std::stoi(argv[6])))) return 1;
+	uint32_t frames = argc > 7 ? static_cast<uint32_t>(std::stoul(argv[7])) : 600;
+	double fps = argc > 8 ? std::stod(argv[8]) : 0.0; // 0 = unthrottled
+
+	using Clock = std::chrono::steady_clock;
+	const auto timeout = std::chrono::seconds(10);
+	RollbackSession session(console.cpu, console.bus, console.cycles, socket, player);
+	auto start = Clock::now();
+	auto lastProgress = start;
+	while (session.Frame() < frames) {
+		uint32_t f = session.Frame();
+		if (fps > 0) std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(f / fps)));
+		if (session.AdvanceFrame(ScriptedInput(player, f))) {
+			lastProgress = Clock::now();
+		} else {
+			if (Clock::now() - lastProgress > timeout) { std::cerr << "Netplay: peer timed out\n"; return 1; }
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+	// Keep exchanging until both sides hold every input of the session
+	while (session.ConfirmedFrame() < int64_t(frames) - 1 || session.PeerAckedFrame() < int64_t(frames) - 1) {
+		if (Clock::now() - lastProgress > timeout) { std::cerr << "Netplay: peer timed out\n"; return 1; }
+		session.Poll();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	MachineState state{};
+	console.Snapshot(state);
+	double secs = std::chrono::duration<double>(Clock::now() - start).count();
+	std::fprintf(stderr, "Netplay: %u frames in %.2fs, %llu rollbacks, %llu frames re-simulated, %llu desyncs, state %016llx\n",
+		frames, secs, static_cast<unsigned long long>(session.Rollbacks()),
+		static_cast<unsigned long long>(session.ResimulatedFrames()),
+		static_cast<unsigned long long>(session.Desyncs()),
+		static_cast<unsigned long long>(Hash64(&state, sizeof(state))));
+	return session.Desyncs() == 0 ? 0 : 2;
+}
+
+// Headless movie playback at full speed: 'play <rom> <movie.nmv|movie.fm2> [frames]'
+static int RunPlayMode(int argc, char** argv) {
+	if (argc < 4) {
+		std::cerr << "Usage: play <rom> <movie.nmv|movie.fm2> [frames]\n";
+		return 1;
+	}
+	Console console;
+	if (!console.LoadROM(argv[2])) return 1;
+
+	std::string moviePath = argv[3];
+	bool fm2 = moviePath.size() > 4 && moviePath.compare(moviePath.size() - 4, 4, ".fm2") == 0;
+	Movie movie;
+	if (!(fm2 ? movie.ImportFM2(moviePath) : movie.Load(moviePath))) return 1;
+	if (!movie.StartPlayback(console.cpu, console.bus, console.cycles)) return 1;
+
+	size_t frames = movie.Frames();
+	if (argc > 4) frames = std::min(frames, static_cast<size_t>(std::stoul(argv[4])));
+	auto start = std::chrono::steady_clock::now();
+	for (size_t f = 0; f < frames; ++f) {
+		movie.ApplyFrame(f, console.bus);
+		console.RunFrame();
+	}
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	MachineState state{};
+	console.Snapshot(state);
+	std::fprintf(stderr, "Movie: %zu frames in %.2fs (%.0f fps), state %016llx\n", frames, secs,
+		secs > 0 ? frames / secs : 0.0, static_cast<unsigned long long>(Hash64(&state, sizeof(state))));
+	return 0;
+}
+
+// Emulation speed with and without pixel output: 'bench <rom> [frames]'.
+// Both runs start from the same state with the same scripted input and must
+// end in the same machine state, since skipping rendering may not change timing.
+static int RunBenchMode(int argc, char** argv) {
+	if (argc < 3) {
+		std::cerr << "Usage: bench <rom> [frames]\n";
+		return 1;
+	}
+	Console console;
+	if (!console.LoadROM(argv[2])) return 1;
+	uint32_t frames = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 1200;
+
+	MachineState start{};
+	console.Snapshot(start);
+	auto run = [&](bool render, uint64_t& hash) {
+		console.Restore(start);
+		auto t0 = std::chrono::steady_clock::now();
+		for (uint32_t f = 0; f < frames; ++f) {
+			console.SetInput(0, ScriptedInput(0, f));
+			console.RunFrame(render);
+		}
+		double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		MachineState end{};
+		console.Snapshot(end);
+		hash = Hash64(&end, sizeof(end));
+		return secs > 0 ? frames / secs : 0.0;
+	};
+
+	uint64_t drawnHash = 0, skippedHash = 0;
+	double drawnFps = run(true, drawnHash);
+	double skippedFps = run(false, skippedHash);
+	std::fprintf(stderr, "Bench: %u frames, rendered %.0f fps, render off %.0f fps (%.2fx), state %016llx %s\n",
+		frames, drawnFps, skippedFps, drawnFps > 0 ? skippedFps / drawnFps : 0.0,
+		static_cast<unsigned long long>(drawnHash), drawnHash == skippedHash ? "match" : "MISMATCH");
+	return drawnHash == skippedHash ? 0 : 2;
+}
+
+// Record a binary instruction trace of a headless run: 'tracerec <rom> <out.ntr> [frames]'
+static int RunTraceRecordMode(int argc, char** argv) {
+	if (argc < 4) {
+		std::cerr << "Usage: tracerec <rom> <out.ntr> [frames]\n";
+		return 1;
+	}
+	Console console;
+	if (!console.LoadROM(argv[2])) return 1;
+	uint32_t frames = argc > 4 ? static_cast<uint32_t>(std::stoul(argv[4])) : 600;
+
+	TraceRecorder recorder;
+	if (!recorder.Start(argv[3])) return 1;
+	console.cpu.traceSink = &recorder;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t f = 0; f < frames; ++f) {
+		console.SetInput(0, ScriptedInput(0, f));
+		console.RunFrame(false);
+	}
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	console.cpu.traceSink = nullptr;
+	if (!recorder.Stop()) return 1;
+	std::fprintf(stderr, "Trace: %u frames in %.2fs (%.0f fps), %llu instructions, %llu writer stalls -> %s\n",
+		frames, secs, secs > 0 ? frames / secs : 0.0, static_cast<unsigned long long>(recorder.Recorded()),
+		static_cast<unsigned long long>(recorder.Stalls()), argv[3]);
+	return 0;
+}
+
+// Binary trace to text, one nestest-style line per instruction: 'tracedump <trace.ntr> [first] [count]'
+static int RunTraceDumpMode(int argc, char** argv) {
+	if (argc < 3) {
+		std::cerr << "Usage: tracedump <trace.ntr> [first] [count]\n";
+		return 1;
+	}
+	TraceFileView trace;
+	if (!trace.Open(argv[2])) {
+		std::cerr << "Not a trace file: " << argv[2] << "\n";
+		return 1;
+	}
+	size_t first = argc > 3 ? static_cast<size_t>(std::stoull(argv[3])) : 0;
+	size_t count = argc > 4 ? static_cast<size_t>(std::stoull(argv[4])) : trace.Count();
+	char line[96];
+	for (size_t i = first; i < trace.Count() && i - first < count; ++i) {
+		FormatTraceRecord(trace[i], line, sizeof(line));
+		std::puts(line);
+	}
+	return 0;
+}
+
+// Record an indexed trace store of a headless run: 'tracestore <rom> <out.nts> [frames]'
+static int RunTraceStoreMode(int argc, char** argv) {
+	if (argc < 4) {
+		std::cerr << "Usage: tracestore <rom> <out.nts> [frames]\n";
+		return 1;
+	}
+	Console console;
+	if (!console.LoadROM(argv[2])) return 1;
+	uint32_t frames = argc > 4 ? static_cast<uint32_t>(std::stoul(argv[4])) : 600;
+
+	TraceStoreWriter store;
+	if (!store.Open(argv[3])) return 1;
+	store.Attach(console.cpu, console.bus);
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t f = 0; f < frames; ++f) {
+		console.SetInput(0, ScriptedInput(0, f));
+		console.RunFrame(false);
+	}
+	store.Detach();
+	if (!store.Close()) return 1;
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	uint64_t n = store.Instructions();
+	std::fprintf(stderr, "Store: %u frames in %.2fs (%.0f fps), %llu instructions, %llu bytes (%.2f bytes/instruction) -> %s\n",
+		frames, secs, secs > 0 ? frames / secs : 0.0, static_cast<unsigned long long>(n),
+		static_cast<unsigned long long>(store.Bytes()), n ? double(store.Bytes()) / double(n) : 0.0, argv[3]);
+	return 0;
+}
+
+// Query a trace store:
+//   'tracequery <store.nts> write <addr> [firstFrame] [lastFrame] [limit]'  every write to addr
+//   'tracequery <store.nts> pc <addr> [firstFrame]'                         first time pc runs
+static int RunTraceQueryMode(int argc, char** argv) {
+	if (argc < 5) {
+		std::cerr << "Usage: tracequery <store.nts> write <addr> [firstFrame] [lastFrame] [limit]\n"
+		             "       tracequery <store.nts> pc <addr> [firstFrame]\n";
+		return 1;
+	}
+	TraceStoreReader store;
+	if (!store.Open(argv[2])) {
+		std::cerr << "Not a trace store: " << argv[2] << "\n";
+		return 1;
+	}
+	std::string kind = argv[3];
+	uint16_t addr = static_cast<uint16_t>(std::stoul(argv[4], nullptr, 16));
+	uint64_t firstFrame = argc > 5 ? std::stoull(argv[5]) : 0;
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<TraceHit> hits;
+	if (kind == "write") {
+		uint64_t lastFrame = argc > 6 ? std::stoull(argv[6]) : UINT64_MAX;
+		size_t limit = argc > 7 ? static_cast<size_t>(std::stoull(argv[7])) : SIZE_MAX;
+		hits = store.FindWrites(addr, firstFrame, lastFrame, limit);
+	} else if (kind == "pc") {
+		TraceHit hit;
+		if (store.FindPC(addr, firstFrame, hit)) hits.push_back(hit);
+	} else {
+		std::cerr << "Unknown query: " << kind << "\n";
+		return 1;
+	}
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	char line[96];
+	for (const TraceHit& hit : hits) {
+		FormatTraceRecord(hit.record, line, sizeof(line));
+		if (kind == "write") {
+			std::printf("#%llu frame %llu  $%04X <- %02X  %s\n", static_cast<unsigned long long>(hit.instruction),
+				static_cast<unsigned long long>(hit.frame), hit.addr, hit.value, line);
+		} else {
+			std::printf("#%llu frame %llu  %s\n", static_cast<unsigned long long>(hit.instruction),
+				static_cast<unsigned long long>(hit.frame), line);
+		}
+	}
+	std::fprintf(stderr, "%zu hits, %zu/%zu chunks decoded, %llu instructions, %.3fs\n", hits.size(),
+		store.ChunksDecoded(), store.Chunks(), static_cast<unsigned long long>(store.Instructions()), secs);
+	return 0;
+}
+
+// Profile a headless run: 'profile <rom> [frames] [out.folded]'. Prints the
+// hottest PCs, subroutines and opcodes; the folded stacks go to a file.
+static int RunProfileMode(int argc, char** argv) {
+	if (argc < 3) {
+		std::cerr << "Usage: profile <rom> [frames] [out.folded]\n";
+		return 1;
+	}
+	Console console;
+	if (!console.LoadROM(argv[2])) return 1;
+	uint32_t frames = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 600;
+
+	Profiler profiler;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t f = 0; f < frames; ++f) {
+		console.SetInput(0, ScriptedInput(0, f));
+		console.cpu.RunFrameHooked(console.cycles, console.bus, profiler, false);
+	}
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double total = profiler.Cycles() ? double(profiler.Cycles()) : 1.0;
+
+	std::printf("%u frames in %.2fs (%.0f fps): %llu instructions, %llu cycles, %llu in OAM DMA\n", frames, secs,
+		secs > 0 ? frames / secs : 0.0, static_cast<unsigned long long>(profiler.Instructions()),
+		static_cast<unsigned long long>(profiler.Cycles()), static_cast<unsigned long long>(profiler.DmaCycles()));
+	std::printf("\nHot spots (bank:pc)     instructions         cycles      %%\n");
+	for (const Profiler::HotSpot& h : profiler.HotSpots(20)) {
+		std::printf("  %-12s %16llu %14llu %6.2f\n", Profiler::LocationName(h.pc, h.bank).c_str(),
+			static_cast<unsigned long long>(h.instructions), static_cast<unsigned long long>(h.cycles),
+			100.0 * double(h.cycles) / total);
+	}
+	std::printf("\nSubroutines                   calls      inclusive           self  incl %%\n");
+	for (const Profiler::Function& fn : profiler.Functions(20)) {
+		std::printf("  %-12s %16llu %14llu %14llu %6.2f\n", Profiler::LocationName(fn.pc, fn.bank).c_str(),
+			static_cast<unsigned long long>(fn.calls), static_cast<unsigned long long>(fn.inclusiveCycles),
+			static_cast<unsigned long long>(fn.selfCycles), 100.0 * double(fn.inclusiveCycles) / total);
+	}
+	std::vector<int> ops;
+	for (int op = 0; op < 256; ++op) {
+		if (profiler.OpcodeCount(uint8_t(op))) ops.push_back(op);
+	}
+	std::sort(ops.begin(), ops.end(), [&](int a, int b) { return profiler.OpcodeCount(uint8_t(a)) > profiler.OpcodeCount(uint8_t(b)); });
+	if (ops.size() > 16) ops.resize(16);
+	std::printf("\nOpcodes          count         cycles\n");
+	for (int op : ops) {
+		std::printf("  $%02X %14llu %14llu\n", op, static_cast<unsigned long long>(profiler.OpcodeCount(uint8_t(op))),
+			static_cast<unsigned long long>(profiler.OpcodeCycles(uint8_t(op))));
+	}
+	if (argc > 4) {
+		if (!profiler.WriteFoldedStacks(argv[4])) return 1;
+		std::printf("\nFolded stacks -> %s\n", argv[4]);
+	}
+	return 0;
+}
+
+// Parse "exec|read|write|ppuread|ppuwrite:<hex addr>[:<condition>]"
+static bool ParseBreakpoint(const std::string& spec, Debugger& debugger) {
+	static const char* const kinds[] = {"exec", "read", "write", "ppuread", "ppuwrite"};
+	size_t colon = spec.find(':');
+	if (colon == std::string::npos) return false;
+	std::string kind = spec.substr(0, colon);
+	std::string rest = spec.substr(colon + 1);
+	size_t condAt = rest.find(':');
+	std::string addrText = rest.substr(0, condAt);
+	if (addrText.empty() || addrText.find_first_not_of("0123456789abcdefABCDEF$") != std::string::npos) return false;
+	if (addrText[0] == '$') addrText.erase(0, 1);
+	uint16_t addr = static_cast<uint16_t>(std::stoul(addrText, nullptr, 16));
+	BreakCondition condition;
+	bool conditional = condAt != std::string::npos;
+	if (conditional && !BreakCondition::Parse(rest.substr(condAt + 1), condition)) return false;
+	for (int k = 0; k < Debugger::KIND_COUNT; ++k) {
+		if (kind == kinds[k]) {
+			debugger.Add(static_cast<Debugger::Kind>(k), addr, conditional ? &condition : nullptr);
+			return true;
+		}
+	}
+	return false;
+}
+
+// Run headless until breakpoints hit: 'break <rom> <frames> <kind:addr[:cond]>... [--hits N]'
+static int RunBreakMode(int argc, char** argv) {
+	if (argc < 5) {
+		std::cerr << "Usage: break <rom> <frames> <exec|read|write|ppuread|ppuwrite:addr[:condition]>... [--hits N]\n"
+		             "  condition: a|x|y|sp|p|value ==|!=|<|>|<=|>=|& number, e.g. write:075A:value==2\n";
+		return 1;
+	}
+	Console console;
+	if (!console.LoadROM(argv[2])) return 1;
+	uint32_t frames = static_cast<uint32_t>(std::stoul(argv[3]));
+	uint64_t maxHits = 10;
+	Debugger& debugger = console.cpu.debugger;
+	for (int i = 4; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--hits" && i + 1 < argc) {
+			maxHits = std::stoull(argv[++i]);
+		} else if (!ParseBreakpoint(arg, debugger)) {
+			std::cerr << "Bad breakpoint: " << arg << "\n";
+			return 1;
+		}
+	}
+
+	static const char* const kindNames[] = {"exec", "read", "write", "ppuread", "ppuwrite"};
+	uint32_t f = 0;
+	while (f < frames && debugger.Hits() < maxHits) {
+		uint64_t frame = console.FrameCount();
+		console.SetInput(0, ScriptedInput(0, f));
+		console.RunFrame(false);
+		if (debugger.pause) {
+			const Debugger::Hit& hit = debugger.LastHit();
+			const CPU& cpu = console.cpu;
+			std::printf("frame %llu  %-8s $%04X = %02X  pc %04X  A:%02X X:%02X Y:%02X P:%02X SP:%02X\n",
+				static_cast<unsigned long long>(console.FrameCount()), kindNames[hit.kind], hit.addr, hit.value, hit.pc,
+				cpu.A, cpu.X, cpu.Y, cpu.P, cpu.SP);
+			debugger.Resume(cpu.PC);
+		}
+		if (console.FrameCount() != frame) ++f;
+	}
+	std::fprintf(stderr, "%llu hits in %u frames\n", static_cast<unsigned long long>(debugger.Hits()), f);
+	return 0;
+}
+
+// Memory access heatmap: 'heatmap <rom> [frames] [out.bin]'
+static int RunHeatmapMode(int argc, char** argv) {
+	if (argc < 3) {
+		std::cerr << "Usage: heatmap <rom> [frames] [out.bin]\n";
+		return 1;
+	}
+	Console console;
+	if (!console.LoadROM(argv[2])) return 1;
+	uint32_t frames = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 600;
+
+	Heatmap heatmap;
+	heatmap.Attach(console.bus, console.ppu);
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t f = 0; f < frames; ++f) {
+		console.SetInput(0, ScriptedInput(0, f));
+		console.cpu.RunFrameHooked(console.cycles, console.bus, heatmap, false);
+		heatmap.EndFrame(console.FrameCount());
+	}
+	heatmap.Detach();
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%u frames in %.2fs (%.0f fps)\n", frames, secs, secs > 0 ? frames / secs : 0.0);
+
+	// Per-page totals over the whole run
+	uint64_t cpuPages[Heatmap::CPU_ACCESS_COUNT][Heatmap::CPU_PAGES] = {};
+	uint64_t ppuPages[Heatmap::PPU_ACCESS_COUNT][Heatmap::PPU_PAGES] = {};
+	for (uint32_t addr = 0; addr < 0x10000; ++addr) {
+		for (int a = 0; a < Heatmap::CPU_ACCESS_COUNT; ++a)
+			cpuPages[a][addr >> 8] += heatmap.Cpu(static_cast<Heatmap::CpuAccess>(a), static_cast<uint16_t>(addr));
+	}
+	for (uint32_t addr = 0; addr < 0x4000; ++addr) {
+		for (int a = 0; a < Heatmap::PPU_ACCESS_COUNT; ++a)
+			ppuPages[a][addr >> 8] += heatmap.Ppu(static_cast<Heatmap::PpuAccess>(a), static_cast<uint16_t>(addr));
+	}
+	std::vector<int> pages;
+	for (int p = 0; p < int(Heatmap::CPU_PAGES); ++p) {
+		if (cpuPages[0][p] || cpuPages[1][p] || cpuPages[2][p]) pages.push_back(p);
+	}
+	auto total = [&](int p) { return cpuPages[0][p] + cpuPages[1][p]; };
+	std::sort(pages.begin(), pages.end(), [&](int a, int b) { return total(a) > total(b); });
+	if (pages.size() > 16) pages.resize(16);
+	std::printf("\nCPU page            reads         writes       executes\n");
+	for (int p : pages) {
+		std::printf("  $%02Xxx %14llu %14llu %14llu\n", p, static_cast<unsigned long long>(cpuPages[0][p]),
+			static_cast<unsigned long long>(cpuPages[1][p]), static_cast<unsigned long long>(cpuPages[2][p]));
+	}
+	struct Region { const char* name; int first, last; };
+	static const Region regions[] = {{"CHR $0000", 0x00, 0x0F}, {"CHR $1000", 0x10, 0x1F},
+		{"VRAM $2000-$2FFF", 0x20, 0x2F}, {"$3000-$3EFF", 0x30, 0x3E}, {"palette $3F00", 0x3F, 0x3F}};
+	std::printf("\nPPU region                reads         writes\n");
+	for (const Region& r : regions) {
+		uint64_t reads = 0, writes = 0;
+		for (int p = r.first; p <= r.last; ++p) {
+			reads += ppuPages[0][p];
+			writes += ppuPages[1][p];
+		}
+		std::printf("  %-17s %14llu %14llu\n", r.name, static_cast<unsigned long long>(reads), static_cast<unsigned long long>(writes));
+	}
+	if (argc > 4) {
+		if (!heatmap.Export(argv[4])) return 1;
+		std::printf("\nHeatmap -> %s\n", argv[4]);
+	}
+	return 0;
+}
+
+// PPU register timeline: 'ppulog <rom> [frames] [out.csv]'
+static int RunPPULogMode(int argc, char** argv) {
+	if (argc < 3) {
+		std::cerr << "Usage: ppulog <rom> [frames] [out.csv]\n";
+		return 1;
+	}
+	Console console;
+	if (!console.LoadROM(argv[2])) return 1;
+	uint32_t frames = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 600;
+	std::ofstream csv;
+	if (argc > 4) {
+		csv.open(argv[4], std::ios::trunc);
+		if (!csv) {
+			std::cerr << "Failed to create " << argv[4] << "\n";
+			return 1;
+		}
+		PPURegisterLog::WriteHeader(csv);
+	}
+
+	PPURegisterLog log;
+	log.Attach(console.ppu, console.bus, console.cpu);
+	uint32_t midFrame = 0;
+	uint64_t events = 0, dropped = 0;
+	size_t busiest = 0;
+	uint64_t firstMidFrame = 0;
+	for (uint32_t f = 0; f < frames; ++f) {
+		console.SetInput(0, ScriptedInput(0, f));
+		console.RunFrame(false);
+		if (log.MidFrameChanges()) {
+			if (!midFrame) firstMidFrame = log.Frame();
+			++midFrame;
+		}
+		events += log.Events().size();
+		dropped += log.Dropped();
+		busiest = std::max(busiest, log.Events().size());
+		if (csv) log.WriteFrame(csv);
+	}
+	log.Detach();
+
+	std::printf("%u frames: %llu events (busiest frame %zu, %llu dropped)\n", frames,
+		static_cast<unsigned long long>(events), busiest, static_cast<unsigned long long>(dropped));
+	if (midFrame) {
+		std::printf("%u frames change PPU or mapper state on visible scanlines (first: frame %llu)\n", midFrame,
+			static_cast<unsigned long long>(firstMidFrame));
+	} else {
+		std::printf("No PPU or mapper changes on visible scanlines\n");
+	}
+	if (argc > 4) std::printf("Timeline -> %s\n", argv[4]);
+	return 0;
+}
+
+// Outcome of one ROM in a batch sweep
+struct BatchResult {
+	explicit BatchResult(std::string p) : path(std::move(p)) {}
+
+	std::string path;
+	const char* status = "ok";   // one of BATCH_STATUSES
+	std::string error;
+	int mapper = -1;             // set only for unsupported_mapper
+	int opcode = -1;             // set only for unknown_opcode
+	uint64_t frames = 0;
+	double fps = 0.0;
+	uint64_t stateHash = 0;
+	uint64_t frameHash = 0;
 };
 
-static int HexVal(char c) {
-	if (c >= '0' && c <= '9') return c - '0';
-	if (c >= 'a' && c <= 'f') return 10 + (c - 'a');
-	if (c >= 'A' && c <= 'F') return 10 + (c - 'A');
-	return -1;
+static std::string JsonString(const std::string& s) {
+	std::string out = "\"";
+	for (unsigned char c : s) {
+		if (c == '"' || c == '\\') { out += '\\'; out += char(c); }
+		else if (c < 0x20) { char buf[8]; std::snprintf(buf, sizeof(buf), "\\u%04x", c); out += buf; }
+		else out += char(c);
+	}
+	return out + "\"";
+}
+
+static const char* const BATCH_STATUSES[] = {
+	"ok", "load_failed", "movie_mismatch", "crash", "timeout", "unsupported_mapper", "unknown_opcode",
+};
+
+// Swallows std::cout while the batch runs, so the per-cartridge load log
+// from many threads does not end up in the JSON on stdout
+struct NullBuffer : std::streambuf {
+	int overflow(int c) override { return c; }
+};
+
+static void RunBatchRom(BatchResult& r, const Movie* movie, uint32_t frames) {
+	auto console = std::make_unique<Console>();
+	if (!console->LoadROM(r.path)) { r.status = "load_failed"; return; }
+	// Nothing useful to emulate on the naive mapping
+	if (console->bus.missingMapper >= 0) {
+		r.status = "unsupported_mapper";
+		r.mapper = console->bus.missingMapper;
+		return;
+	}
+	// A sweep meets ROMs the movie was not recorded on; that is not a load failure
+	if (movie && movie->romHash != 0 && movie->romHash != console->bus.romHash) { r.status = "movie_mismatch"; return; }
+	try {
+		if (movie) {
+			if (!movie->StartPlayback(console->cpu, console->bus, console->cycles)) { r.status = "load_failed"; return; }
+			frames = static_cast<uint32_t>(movie->Frames());
+		}
+		auto start = std::chrono::steady_clock::now();
+		// Only the last frame is drawn; it is the one the screenshot hash covers
+		for (uint32_t f = 0; f < frames; ++f) {
+			if (movie) movie->ApplyFrame(f, console->bus);
+			console->RunFrame(f + 1 == frames);
+		}
+		double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		r.frames = frames;
+		r.fps = secs > 0 ? frames / secs : 0.0;
+	} catch (const std::exception& e) {
+		r.status = "crash";
+		r.error = e.what();
+		return;
+	}
+	MachineState state{};
+	console->Snapshot(state);
+	r.stateHash = Hash64(&state, sizeof(state));
+	const std::vector<uint32_t>& fb = console->GetFramebuffer();
+	r.frameHash = HashFrame(fb.data(), fb.size()).lo;
+	if (console->cpu.warnedUnknownOpcode) {
+		r.status = "unknown_opcode";
+		r.opcode = console->cpu.unknownOpcode;
+	}
 }
 
-static bool ParseByteAt(const std::string& s, size_t pos, uint8_t& out) {
-	if (pos + 1 >= s.size()) return false;
-	int hi = HexVal(s[pos]);
-	int lo = HexVal(s[pos + 1]);
-	if (hi < 0 || lo < 0) return false;
-	out = static_cast<uint8_t>((hi << 4) | lo);
+// Frame count or movie for a batch run (batch argv[3], or the worker's argv[3])
+static bool LoadBatchInput(const std::string& arg, uint32_t& frames, Movie& movie, bool& useMovie) {
+	if (!arg.empty() && std::all_of(arg.begin(), arg.end(), [](unsigned char c) { return std::isdigit(c); })) {
+		frames = static_cast<uint32_t>(std::stoul(arg));
+		return true;
+	}
+	bool fm2 = arg.size() > 4 && arg.compare(arg.size() - 4, 4, ".fm2") == 0;
+	if (!(fm2 ? movie.ImportFM2(arg) : movie.Load(arg))) return false;
+	useMovie = true;
 	return true;
 }
 
-static bool ParseWordAt(const std::string& s, size_t pos, uint16_t& out) {
-	if (pos + 3 >= s.size()) return false;
-	int h1 = HexVal(s[pos]);
-	int h2 = HexVal(s[pos + 1]);
-	int h3 = HexVal(s[pos + 2]);
-	int h4 = HexVal(s[pos + 3]);
-	if (h1 < 0 || h2 < 0 || h3 < 0 || h4 < 0) return false;
-	out = static_cast<uint16_t>((h1 << 12) | (h2 << 8) | (h3 << 4) | h4);
+// One result line between a batch-rom worker and the sweep:
+// "<status> <mapper> <opcode> <frames> <fps> <state> <screen> <error...>"
+static void WriteBatchRecord(const BatchResult& r) {
+	std::string error = r.error;
+	std::replace(error.begin(), error.end(), '\n', ' ');
+	std::printf("%s %d %d %llu %.3f %016llx %016llx %s\n", r.status, r.mapper, r.opcode,
+		static_cast<unsigned long long>(r.frames), r.fps, static_cast<unsigned long long>(r.stateHash),
+		static_cast<unsigned long long>(r.frameHash), error.c_str());
+}
+
+static bool ReadBatchRecord(const std::string& output, BatchResult& r) {
+	// The record is the worker's last line; the core may have printed before it
+	size_t end = output.find_last_not_of('\n');
+	if (end == std::string::npos) return false;
+	size_t begin = output.rfind('\n', end);
+	std::istringstream in(output.substr(begin == std::string::npos ? 0 : begin + 1));
+	std::string status;
+	unsigned long long frames = 0, state = 0, screen = 0;
+	if (!(in >> status >> r.mapper >> r.opcode >> frames >> r.fps >> std::hex >> state >> screen)) return false;
+	const char* const* known = std::find_if(std::begin(BATCH_STATUSES), std::end(BATCH_STATUSES),
+		[&](const char* s) { return status == s; });
+	if (known == std::end(BATCH_STATUSES)) return false;
+	r.status = *known;
+	r.frames = frames;
+	r.stateHash = state;
+	r.frameHash = screen;
+	std::getline(in >> std::ws, r.error);
 	return true;
 }
 
-static bool ParseExpectedTraceLine(const std::string& line, ExpectedTrace& out) {
-	if (line.size() < 4 || !std::isxdigit(static_cast<unsigned char>(line[0]))) return false;
-	if (!ParseWordAt(line, 0, out.pc)) return false;
+// Worker for one ROM of a sweep: 'batch-rom <rom> <frames|movie>'. Prints a
+// batch record on stdout; the sweep runs one per ROM so a ROM that brings the
+// emulator down only takes its own process with it.
+static int RunBatchWorkerMode(int argc, char** argv) {
+	if (argc < 4) {
+		std::cerr << "Usage: batch-rom <rom.nes> <frames|movie.nmv|movie.fm2>\n";
+		return 1;
+	}
+	uint32_t frames = 0;
+	Movie movie;
+	bool useMovie = false;
+	if (!LoadBatchInput(argv[3], frames, movie, useMovie)) return 1;
+	BatchResult r(argv[2]);
+	NullBuffer sink;
+	std::streambuf* coutBuf = std::cout.rdbuf(&sink);
+	RunBatchRom(r, useMovie ? &movie : nullptr, frames);
+	std::cout.rdbuf(coutBuf);
+	WriteBatchRecord(r);
+	return 0;
+}
 
-	// Byte columns in nestest log are fixed-width.
-	ParseByteAt(line, 6, out.op1);
-	ParseByteAt(line, 9, out.op2);
-	ParseByteAt(line, 12, out.op3);
+#if BATCH_HAVE_SPAWN
+// Runs 'self batch-rom <rom> <input>' and fills r from its record: crash when
+// it dies on a signal or exits without one, timeout (and killed) when it is
+// still running after timeoutSecs
+static void RunBatchRomIsolated(BatchResult& r, const std::string& self, const std::string& input, double timeoutSecs) {
+	// Other workers spawn concurrently; only this child may hold the write end
+	int out[2];
+#ifdef __linux__
+	int piped = pipe2(out, O_CLOEXEC);
+#else
+	int piped = pipe(out);
+	if (piped == 0) {
+		fcntl(out[0], F_SETFD, FD_CLOEXEC);
+		fcntl(out[1], F_SETFD, FD_CLOEXEC);
+	}
+#endif
+	if (piped != 0) {
+		r.status = "crash";
+		r.error = std::string("pipe: ") + std::strerror(errno);
+		return;
+	}
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+	posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+	std::string mode = "batch-rom";
+	char* args[] = {const_cast<char*>(self.c_str()), &mode[0], const_cast<char*>(r.path.c_str()),
+		const_cast<char*>(input.c_str()), nullptr};
+	pid_t pid = 0;
+	int rc = posix_spawn(&pid, self.c_str(), &actions, nullptr, args, environ);
+	posix_spawn_file_actions_destroy(&actions);
+	close(out[1]);
+	if (rc != 0) {
+		close(out[0]);
+		r.status = "crash";
+		r.error = std::string("spawn: ") + std::strerror(rc);
+		return;
+	}
 
-	auto findByte = [&](const char* tag, uint8_t& value) {
-		size_t pos = line.find(tag);
-		if (pos == std::string::npos) return false;
-		pos += std::strlen(tag);
-		return ParseByteAt(line, pos, value);
-	};
+	std::string output;
+	bool timedOut = false;
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeoutSecs);
+	for (;;) {
+		auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+		if (left <= 0) {
+			timedOut = true;
+			kill(pid, SIGKILL);
+			break;
+		}
+		pollfd p{out[0], POLLIN, 0};
+		int ready = poll(&p, 1, static_cast<int>(std::min<long long>(left, 1000)));
+		if (ready < 0 && errno != EINTR) break;
+		if (ready <= 0) continue;
+		char buf[512];
+		ssize_t got = read(out[0], buf, sizeof(buf));
+		if (got <= 0) break;
+		output.append(buf, static_cast<size_t>(got));
+	}
+	close(out[0]);
+	int wstatus = 0;
+	while (waitpid(pid, &wstatus, 0) < 0 && errno == EINTR) {}
+
+	if (timedOut) {
+		r.status = "timeout";
+		char buf[48];
+		std::snprintf(buf, sizeof(buf), "no result after %g s", timeoutSecs);
+		r.error = buf;
+	} else if (WIFSIGNALED(wstatus)) {
+		r.status = "crash";
+		r.error = "signal " + std::to_string(WTERMSIG(wstatus)) + " (" + strsignal(WTERMSIG(wstatus)) + ")";
+	} else if (!ReadBatchRecord(output, r)) {
+		r.status = "crash";
+		r.error = "exit code " + std::to_string(WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : -1) + " without a result";
+	}
+}
 
-	findByte("A:", out.a);
-	findByte("X:", out.x);
-	findByte("Y:", out.y);
-	findByte("P:", out.p);
-	findByte("SP:", out.sp);
+// Path to run workers from: the running binary itself where the OS says so
+static std::string BatchSelfPath(const char* argv0) {
+	std::error_code ec;
+	std::filesystem::path self = std::filesystem::read_symlink("/proc/self/exe", ec);
+	if (!ec) return self.string();
+	return std::filesystem::absolute(argv0, ec).string();
+}
+#endif
 
-	size_t cycPos = line.find("CYC:");
-	if (cycPos != std::string::npos) {
-		cycPos += 4;
-		while (cycPos < line.size() && line[cycPos] == ' ') ++cycPos;
-		out.cycles = std::strtoull(line.c_str() + cycPos, nullptr, 10);
+// Compatibility/speed sweep: 'batch <dir|rom|list.txt> [frames|movie] [threads] [timeout_s]'.
+// Every ROM runs in its own worker process (see RunBatchWorkerMode) from a
+// work-stealing pool, so crashes and hangs are reported per ROM instead of
+// ending the sweep; a worker still running after timeout_s (default 10 s
+// plus 50 ms per frame) is killed. Without process spawning (Windows) ROMs
+// run in-process and only exceptions are caught. One JSON object per ROM
+// is printed to stdout in input order.
+static int RunBatchMode(int argc, char** argv) {
+	if (argc < 3) {
+		std::cerr << "Usage: batch <dir|rom.nes|list.txt> [frames|movie.nmv|movie.fm2] [threads] [timeout_s]\n";
+		return 1;
+	}
+	std::vector<BatchResult> results;
+	std::string source = argv[2];
+	std::error_code ec;
+	if (std::filesystem::is_directory(source, ec)) {
+		for (std::string& path : ListRomFiles(source)) results.emplace_back(std::move(path));
+	} else if (source.size() > 4 && source.compare(source.size() - 4, 4, ".txt") == 0) {
+		std::ifstream list(source);
+		if (!list) { std::cerr << "Failed to open ROM list: " << source << std::endl; return 1; }
+		for (std::string line; std::getline(list, line);) {
+			while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back()))) line.pop_back();
+			if (!line.empty() && line[0] != '#') results.emplace_back(line);
+		}
+	} else {
+		results.emplace_back(source);
 	}
 
-	return true;
+	uint32_t frames = 600;
+	Movie movie;
+	bool useMovie = false;
+	std::string input = argc > 3 ? argv[3] : std::to_string(frames);
+	if (!LoadBatchInput(input, frames, movie, useMovie)) return 1;
+	size_t threads = argc > 4 ? static_cast<size_t>(std::stoul(argv[4])) : 0;
+	double timeoutSecs = argc > 5 ? std::stod(argv[5])
+		: 10.0 + 0.05 * static_cast<double>(useMovie ? movie.Frames() : frames);
+
+	NullBuffer sink;
+	std::streambuf* coutBuf = std::cout.rdbuf(&sink);
+	auto start = std::chrono::steady_clock::now();
+	ThreadPool pool(threads);
+#if BATCH_HAVE_SPAWN
+	std::string self = BatchSelfPath(argv[0]);
+	pool.ParallelFor(results.size(), [&](size_t i) { RunBatchRomIsolated(results[i], self, input, timeoutSecs); });
+#else
+	(void)timeoutSecs;
+	pool.ParallelFor(results.size(), [&](size_t i) { RunBatchRom(results[i], useMovie ? &movie : nullptr, frames); });
+#endif
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout.rdbuf(coutBuf);
+
+	size_t ok = 0;
+	for (const BatchResult& r : results) {
+		if (std::strcmp(r.status, "ok") == 0) ++ok;
+		std::printf("{\"rom\":%s,\"status\":\"%s\"", JsonString(r.path).c_str(), r.status);
+		if (r.mapper >= 0) std::printf(",\"mapper\":%d", r.mapper);
+		if (r.opcode >= 0) std::printf(",\"opcode\":%d", r.opcode);
+		if (!r.error.empty()) std::printf(",\"error\":%s", JsonString(r.error).c_str());
+		std::printf(",\"frames\":%llu,\"fps\":%.1f,\"state\":\"%016llx\",\"screen\":\"%016llx\"}\n",
+			static_cast<unsigned long long>(r.frames), r.fps,
+			static_cast<unsigned long long>(r.stateHash), static_cast<unsigned long long>(r.frameHash));
+	}
+	std::fflush(stdout);
+	std::fprintf(stderr, "Batch: %zu ROMs (%zu ok) in %.2fs on %zu threads, %llu steals\n",
+		results.size(), ok, secs, pool.Size(), static_cast<unsigned long long>(pool.Steals()));
+	return 0;
 }
 
 // New main: supports 'gui' mode (./proiectPC gui [rom]) when GUI is available; otherwise REPL mode
 int main(int argc, char** argv)
 {
-	Bus bus{};
-	CPU cpu{};
-	u32 Cycles = 0;
+	// The GUI, REPL and trace compare all run on one console
+	Console console;
+	Bus& bus = console.bus;
+	CPU& cpu = console.cpu;
+	u32& Cycles = console.cycles;
 	std::string filePath;
 
 	bool traceCompare = false;
 	std::string traceLogPath = "nesTests/goodlog.txt";
-	int traceMaxLines = 5000;
+	size_t traceMaxLines = 5000;    // 0 = the whole log
+	size_t traceContext = 16;
 
-	// Detect trace compare mode first: 'trace' as first arg
+	// Detect trace compare mode first: 'trace [rom] [log] [maxLines] [context]'
 	if (argc > 1 && std::string(argv[1]) == "trace") {
 		traceCompare = true;
 		if (argc > 2) filePath = argv[2];
 		else filePath = "nesTests/nestest.nes";
 		if (argc > 3) traceLogPath = argv[3];
-		if (argc > 4) traceMaxLines = std::max(1, std::stoi(argv[4]));
+		if (argc > 4) traceMaxLines = static_cast<size_t>(std::stoul(argv[4]));
+		if (argc > 5) traceContext = std::max<size_t>(1, std::stoul(argv[5]));
+	}
+
+	// ROM library index mode: 'index <dir> [indexFile]'
+	if (argc > 2 && std::string(argv[1]) == "index") {
+		return RunIndexMode(argv[2], argc > 3 ? argv[3] : RomIndex::DEFAULT_PATH);
+	}
+
+	// Rollback netplay: 'netplay <rom> <player> <localPort> <remoteHost> <remotePort> [frames] [fps]'
+	if (argc > 1 && std::string(argv[1]) == "netplay") {
+		return RunNetplayMode(argc, argv);
+	}
+
+	// Render-off speed check: 'bench <rom> [frames]'
+	if (argc > 1 && std::string(argv[1]) == "bench") {
+		return RunBenchMode(argc, argv);
+	}
+
+	// Binary instruction traces: 'tracerec <rom> <out.ntr> [frames]', 'tracedump <trace.ntr> [first] [count]'
+	if (argc > 1 && std::string(argv[1]) == "tracerec") {
+		return RunTraceRecordMode(argc, argv);
+	}
+	if (argc > 1 && std::string(argv[1]) == "tracedump") {
+		return RunTraceDumpMode(argc, argv);
+	}
+
+	// Indexed trace store: 'tracestore <rom> <out.nts> [frames]', 'tracequery <store.nts> write|pc <addr> ...'
+	if (argc > 1 && std::string(argv[1]) == "tracestore") {
+		return RunTraceStoreMode(argc, argv);
+	}
+	if (argc > 1 && std::string(argv[1]) == "tracequery") {
+		return RunTraceQueryMode(argc, argv);
+	}
+
+	// Execution profile: 'profile <rom> [frames] [out.folded]'
+	if (argc > 1 && std::string(argv[1]) == "profile") {
+		return RunProfileMode(argc, argv);
+	}
+
+	// Headless breakpoints: 'break <rom> <frames> <kind:addr[:condition]>... [--hits N]'
+	if (argc > 1 && std::string(argv[1]) == "break") {
+		return RunBreakMode(argc, argv);
+	}
+
+	// Memory access heatmap: 'heatmap <rom> [frames] [out.bin]'
+	if (argc > 1 && std::string(argv[1]) == "heatmap") {
+		return RunHeatmapMode(argc, argv);
+	}
+
+	// PPU register timeline: 'ppulog <rom> [frames] [out.csv]'
+	if (argc > 1 && std::string(argv[1]) == "ppulog") {
+		return RunPPULogMode(argc, argv);
+	}
+
+	// Batch sweep: 'batch <dir|rom|list.txt> [frames|movie] [threads] [timeout_s]'
+	if (argc > 1 && std::string(argv[1]) == "batch") {
+		return RunBatchMode(argc, argv);
+	}
+	if (argc > 1 && std::string(argv[1]) == "batch-rom") {
+		return RunBatchWorkerMode(argc, argv);
+	}
+
+	// Movie playback: 'play <rom> <movie> [frames]'
+	if (argc > 1 && std::string(argv[1]) == "play") {
+		return RunPlayMode(argc, argv);
 	}
 
 	// Detect GUI mode first: 'gui' as first arg
@@ -112,6 +957,8 @@ int main(int argc, char** argv)
 	if (!traceCompare && argc > 1 && std::string(argv[1]) == "gui") {
 		wantGui = true;
 		if (argc > 2) filePath = argv[2];
+	} else if (traceCompare) {
+		// ROM path already taken from the trace arguments
 	} else if (argc > 1) {
 		filePath = argv[1];
 	} else {
@@ -139,8 +986,6 @@ int main(int argc, char** argv)
 	// Trace-compare mode (nestest)
 	if (traceCompare) {
 		if (!filePath.empty()) loadFile(filePath);
-		InitializeInstructionTable();
-		bus.AttachCPU(&cpu);
 
 		// Force nestest initial state (matches goodlog.txt)
 		cpu.PC = 0xC000;
@@ -151,49 +996,44 @@ int main(int argc, char** argv)
 		cpu.P = 0x24;
 		Cycles = 7;
 
-		std::ifstream goodlog(traceLogPath);
-		if (!goodlog.is_open()) {
-			std::cerr << "Failed to open trace log: " << traceLogPath << "\n";
+		TraceFileView golden;
+		if (!OpenGoldenTrace(traceLogPath, golden)) return 1;
+
+		size_t limit = golden.Count();
+		if (traceMaxLines > 0) limit = std::min(limit, traceMaxLines);
+		if (limit == 0) {
+			std::cerr << "Golden trace " << traceLogPath << " has no records to compare\n";
 			return 1;
 		}
+		TraceHistory history(traceContext);
+		size_t matched = 0;
+		for (; matched < limit; ++matched) {
+			const TraceRecord& expected = golden[matched];
+			TraceRecord actual = cpu.CaptureTrace(bus, Cycles);
+			// Compare as many instruction bytes as the golden line has
+			actual.length = expected.length;
+			for (uint8_t i = 1; i < expected.length; ++i) actual.bytes[i] = bus.peek(static_cast<uint16_t>(cpu.PC + i));
+			actual.flags = expected.flags;
 
-		std::string line;
-		int lineNo = 0;
-		int matched = 0;
-		while (std::getline(goodlog, line)) {
-			ExpectedTrace expected;
-			if (!ParseExpectedTraceLine(line, expected)) continue;
-			lineNo++;
-
-			uint8_t op1 = bus.read(cpu.PC);
-			uint8_t op2 = bus.read(cpu.PC + 1);
-			uint8_t op3 = bus.read(cpu.PC + 2);
-
-			bool mismatch = false;
-			if (cpu.PC != expected.pc) mismatch = true;
-			if (cpu.A != expected.a || cpu.X != expected.x || cpu.Y != expected.y) mismatch = true;
-			if (cpu.P != expected.p || cpu.SP != expected.sp) mismatch = true;
-			if (op1 != expected.op1 || op2 != expected.op2 || op3 != expected.op3) mismatch = true;
-			if (expected.cycles != 0 && Cycles != expected.cycles) mismatch = true;
-
+			bool mismatch = actual.pc != expected.pc || actual.a != expected.a || actual.x != expected.x ||
+				actual.y != expected.y || actual.p != expected.p || actual.sp != expected.sp ||
+				std::memcmp(actual.bytes, expected.bytes, expected.length) != 0 ||
+				((expected.flags & TraceRecord::FLAG_CYCLES) && actual.cycles != expected.cycles);
 			if (mismatch) {
-				std::cerr << "Trace mismatch at line " << lineNo << "\n";
-				std::cerr << "Expected PC=0x" << std::hex << expected.pc
-					<< " A=" << int(expected.a) << " X=" << int(expected.x)
-					<< " Y=" << int(expected.y) << " P=" << int(expected.p)
-					<< " SP=" << int(expected.sp) << " CYC=" << std::dec << expected.cycles << "\n";
-				std::cerr << "Actual   PC=0x" << std::hex << cpu.PC
-					<< " A=" << int(cpu.A) << " X=" << int(cpu.X)
-					<< " Y=" << int(cpu.Y) << " P=" << int(cpu.P)
-					<< " SP=" << int(cpu.SP) << " CYC=" << std::dec << Cycles << "\n";
-				std::cerr << "Bytes    exp=" << std::hex << int(expected.op1) << " " << int(expected.op2)
-					<< " " << int(expected.op3) << " act=" << int(op1) << " " << int(op2) << " " << int(op3) << std::dec << "\n";
+				char line[96];
+				std::cerr << "Trace mismatch at line " << matched + 1 << ", last " << history.Size() << " instructions:\n";
+				for (size_t i = 0; i < history.Size(); ++i) {
+					FormatTraceRecord(history.At(i), line, sizeof(line));
+					std::cerr << "         " << line << "\n";
+				}
+				FormatTraceRecord(expected, line, sizeof(line));
+				std::cerr << "Expected " << line << "\n";
+				FormatTraceRecord(actual, line, sizeof(line));
+				std::cerr << "Actual   " << line << "\n";
 				return 1;
 			}
-
+			history.Push(actual);
 			cpu.Execute(Cycles, bus);
-			matched++;
-			if (traceMaxLines > 0 && matched >= traceMaxLines) break;
 		}
 
 		std::cout << "Trace compare passed for " << matched << " lines." << std::endl;
@@ -201,17 +1041,11 @@ int main(int argc, char** argv)
 	}
 
 	// If GUI requested and available, start it (and optionally pre-load ROM)
-	#if __has_include("gui.h")
-	#include "gui.h"
+	#ifdef NES_HAS_GUI
 	if (wantGui) {
 		if (!filePath.empty()) loadFile(filePath);
-		InitializeInstructionTable();
-		// Attach CPU to bus for mapper IRQs and other interactions
-		bus.AttachCPU(&cpu);
-		cpu.Reset(bus);
-		// SANITY CHECK — REMOVE AFTER TEST
-
-		RunGUI(cpu, bus);
+		console.Reset();
+		RunGUI(console);
 		return 0;
 	}
 	#else
@@ -222,19 +1056,25 @@ int main(int argc, char** argv)
 
 	// Non-GUI / REPL mode
 	if (!filePath.empty()) loadFile(filePath);
+	console.Reset();
 
-	InitializeInstructionTable();
-	// Attach CPU to bus so mappers can signal IRQs even in non-GUI runs
-	bus.AttachCPU(&cpu);
-	cpu.Reset(bus);
-
-	std::cerr << "Commands: r=run, s=step, p=print regs, q=quit\n";
+	RewindBuffer rewind;
+	MachineState state{};
+	std::cerr << "Commands: r=run, f=run frame, b=rewind frame, p=print regs, q=quit\n";
 	while (true) {
 		std::cerr << "> ";
 		char cmd = 0;
 		if (!(std::cin >> cmd)) break;
 		if (cmd == 'q') break;
 		else if (cmd == 'r') cpu.Execute(Cycles, bus);
+		else if (cmd == 'f') {
+			Snapshot(cpu, bus, Cycles, state);
+			rewind.Push(state);
+			cpu.RunFrame(Cycles, bus);
+		}
+		else if (cmd == 'b') {
+			if (!rewind.Pop(state) || !Restore(cpu, bus, Cycles, state)) std::cerr << "Nothing to rewind\n";
+		}
 		else if (cmd == 'p') {
 			cpu.printReg('A'); cpu.printReg('X'); cpu.printReg('Y');
 			std::cerr << "PC: 0x" << std::hex << cpu.PC << std::dec << " SP: 0x" << std::hex << int(cpu.SP) << std::dec << std::endl;
@@ -3,10 +3,13 @@
 #include "headers/bus.h"
 #include "headers/ppu.h"
 #include "headers/mapper.h"
+#include "headers/hash.h"
+#include "headers/ppulog.h"
 
 #include <fstream>
 #include <iostream>
 
+
 Bus::Bus() {
     ram.Initialise();
     prgRom.clear();
@@ -21,7 +24,33 @@ Bus::Bus() {
 
 
 
-uint8_t Bus::read(uint16_t addr)  {
+void Bus::AddTap(BusTap* t) {
+    for (BusTap* it = tap; it; it = it->nextTap) {
+        if (it == t) return;
+    }
+    t->nextTap = tap;
+    tap = t;
+}
+
+void Bus::RemoveTap(BusTap* t) {
+    for (BusTap** link = &tap; *link; link = &(*link)->nextTap) {
+        if (*link == t) {
+            *link = t->nextTap;
+            t->nextTap = nullptr;
+            return;
+        }
+    }
+}
+
+uint8_t Bus::read(uint16_t addr) {
+    uint8_t value = readMemory(addr);
+    if (tap) {
+        for (BusTap* t = tap; t; t = t->nextTap) t->OnCPURead(addr, value);
+    }
+    return value;
+}
+
+uint8_t Bus::readMemory(uint16_t addr) {
     // RAM and mirrors
     if (addr <= 0x1FFF) {
         return ram.Data[addr & RAM_MASK];
@@ -69,6 +98,16 @@ uint8_t Bus::read(uint16_t addr)  {
     return 0; // or open bus
 }
 
+uint8_t Bus::peek(uint16_t addr) const {
+    if (addr <= 0x1FFF) return ram.Data[addr & RAM_MASK];
+    if (addr < 0x6000) return 0;
+    if (mapper) return mapper->CPURead(addr);
+    if (!prgRom.empty() && addr >= 0x8000) {
+        return prgRom[prgRom.size() == 0x4000 ? (addr - 0x8000) & 0x3FFF : addr - 0x8000];
+    }
+    return 0;
+}
+
 uint8_t Bus::ReadCHR(uint16_t addr) const {
     if (mapper) {
         return mapper->CHRRead(addr);
@@ -98,7 +137,9 @@ void Bus::NotifyPPUAddr(uint16_t addr) {
 }
 
 void Bus::write(uint16_t addr, uint8_t value) {
-
+    if (tap) {
+        for (BusTap* t = tap; t; t = t->nextTap) t->OnCPUWrite(addr, value);
+    }
 
     // RAM and mirrors
     if (addr <= 0x1FFF) {
@@ -132,6 +173,7 @@ void Bus::write(uint16_t addr, uint8_t value) {
     if (mapper) {
         if (addr >= 0x6000) {
             mapper->CPUWrite(addr, value);
+            if (addr >= 0x8000 && ppu && ppu->registerLog) ppu->registerLog->OnMapperWrite();
             return;
         }
     }
@@ -202,7 +244,7 @@ bool Bus::LoadPRGFromFile(const std::string& filename) {
             file.read(reinterpret_cast<char*>(chrRom.data()), chrSize);
             std::cout << "Loaded iNES CHR ROM: " << chrSize << " bytes (" << int(chrBanks) << " x 8KB banks)\n";
             chrIsRam = false;
-            if (!chrRom.empty()) {
+            if (verbose && !chrRom.empty()) {
                 uint32_t sum = 0;
                 for (uint8_t b : chrRom) sum += b;
                 std::cout << "CHR sum: 0x" << std::hex << sum << std::dec << "\n";
@@ -227,11 +269,13 @@ bool Bus::LoadPRGFromFile(const std::string& filename) {
             std::cout << "No CHR ROM present in iNES file: allocated 8KB CHR RAM.\n";
             chrIsRam = true;
         }
+        romHash = HashRomData(prgRom.data(), prgRom.size(), chrIsRam ? nullptr : chrRom.data(), chrIsRam ? 0 : chrRom.size());
 
         // Create mapper if one is supported
         uint8_t flags7 = static_cast<uint8_t>(header[7]);
         uint8_t mapper = ((flags7 & 0xF0) | (flags6 >> 4));
         Mapper* m = CreateMapperFor(this, mapper, prgRom.size(), chrRom.size());
+        missingMapper = (m || mapper == 0) ? -1 : int(mapper);
         if (m) {
             AttachMapper(m);
             m->mirroring = cartMirroring;
@@ -252,7 +296,9 @@ bool Bus::LoadPRGFromFile(const std::string& filename) {
     file.read(reinterpret_cast<char*>(prgRom.data()), size);
 
     std::cout << "Loaded raw PRG file: " << size << " bytes\n";
+    missingMapper = -1;
     chrIsRam = false;
+    romHash = HashRomData(prgRom.data(), prgRom.size(), nullptr, 0);
     return true;
 }
 
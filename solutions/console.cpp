@@ -0,0 +1,44 @@
+#include "headers/console.h"
+
+Console::Console() : ppu(bus), framebuffer(WIDTH * HEIGHT, 0xFF000000u) {
+    bus.AttachPPU(&ppu);
+    bus.AttachCPU(&cpu);
+    ppu.SetFrameTarget(framebuffer.data());
+}
+
+bool Console::LoadROM(const std::string& path) {
+    if (!bus.LoadPRGFromFile(path)) return false;
+    Reset();
+    return true;
+}
+
+void Console::Reset() {
+    cycles = 0;
+    cpu.Reset(bus);
+    ppu.Reset();
+}
+
+void Console::RunFrame(bool render) {
+    cpu.RunFrame(cycles, bus, render);
+    ppu.frameReady = false;
+}
+
+void Console::RunFrame(uint32_t* pixels) {
+    ppu.SetFrameTarget(pixels);
+    RunFrame();
+    ppu.SetFrameTarget(framebuffer.data());
+}
+
+void Console::RunFrameIndexed(uint8_t* indices) {
+    ppu.SetIndexTarget(indices);
+    RunFrame();
+    ppu.SetIndexTarget(nullptr);
+}
+
+void Console::Snapshot(MachineState& out) const {
+    ::Snapshot(cpu, bus, cycles, out);
+}
+
+bool Console::Restore(const MachineState& state) {
+    return ::Restore(cpu, bus, cycles, state);
+}
@@ -1,29 +1,10 @@
 #include "headers/cpu.h"
 #include "headers/ppu.h"
 #include "headers/mapper.h"
-#include "headers/debugger.h"
+#include "headers/profiler.h"
+#include "headers/heatmap.h"
 
-
-
-Debugger debugger;
 // 6502 proccesor emulation,
-void PrintTrace(const CPU::CPUTrace& t) {
-    std::ofstream file("nesTests/log.txt");
-
-if (!file.is_open()) {
-    // handle error
-    return;
-}
-    file<<
-        "%04X  %02X %02X %02X  "
-        "A:%02X X:%02X Y:%02X P:%02X SP:%02X CYC:%llu\n",
-        t.pc,
-        t.opcode, t.op1, t.op2,
-        t.A, t.X, t.Y, t.P, int(t.SP),
-        t.cycles;
-
-}
-
 void PrintStartupDebug(Bus& bus) {
     // Print values at $FFFC/$FFFD (reset vector)
     uint8_t resetLow = bus.read(0xFFFC);
@@ -41,7 +22,6 @@ void PrintStartupDebug(Bus& bus) {
     }
     std::cout << std::dec << std::endl;
 }
-CPU::InstructionHandler CPU::instructionTable[256] = { nullptr };
 void CPU::printReg(char reg) {
     if ((unsigned char)reg == 0xFF) {
         std::cout << "Register is NULL (uninitialized)" << std::endl;
@@ -87,10 +67,11 @@ Word CPU::FetchWord(u32& Cycles, Bus& bus) {
 
 void CPU::Reset(Bus& bus) {
     PC = bus.read(0xFFFC) | (bus.read(0xFFFD) << 8);
-    printf("Memory[0xFFFC]: 0x%X\n", bus.read(0xFFFC));
-    printf("Memory[0xFFFD]: 0x%X\n", bus.read(0xFFFD));
-
-    printf("Reset Vector: 0x%X\n", PC);
+    if (verbose) {
+        printf("Memory[0xFFFC]: 0x%X\n", bus.read(0xFFFC));
+        printf("Memory[0xFFFD]: 0x%X\n", bus.read(0xFFFD));
+        printf("Reset Vector: 0x%X\n", PC);
+    }
     SP = 0xFD;
     P = FLAG_U;
     A = X = Y = 0;
@@ -130,15 +111,6 @@ void CPU::SBCSetStatus(Byte Value)
     A = Result & 0xFF;
 }
 
-bool g_verboseCpu = false;
-
-// Loop detector / hotspot diagnostics: disabled by default to avoid automatic yielding
-bool g_loopDetect = false;
-uint16_t g_loopLastPage = 0;
-uint32_t g_loopStreak = 0;
-uint32_t g_loopReportThreshold = 1000; // report every N iterations
-uint32_t g_loopSleepThreshold = 50000; // start yielding when extremely hot
-
 void CPU::ExecuteBranch(u32& Cycles, Bus& bus, bool Condition) {
     Byte Offset = FetchByte(Cycles, bus);
 
@@ -149,12 +121,12 @@ void CPU::ExecuteBranch(u32& Cycles, Bus& bus, bool Condition) {
         if ((oldPC & 0xFF00) != (PC & 0xFF00)) {
             Cycles += 1;
         }
-        if (g_verboseCpu) {
+        if (verbose) {
             std::cout << "Branch Condition: "<<Condition
                 << ", New PC: " << PC << std::endl;
         }
     } else {
-        if (g_verboseCpu) {
+        if (verbose) {
             std::cout << "Branch not taken" << std::endl;
         }
     }
@@ -255,10 +227,10 @@ void CPU::InvokeInstruction(Byte opcode, u32& Cycles, Bus& bus) {
         handler(*this, Cycles, bus);
     }
     else {
-        static bool warnedOnce = false;
-        if (!warnedOnce) {
+        if (!warnedUnknownOpcode) {
             std::cout << "Warning: no handler for opcode 0x" << std::hex << std::uppercase << static_cast<int>(opcode) << std::dec << " - treating as NOP" << std::endl;
-            warnedOnce = true;
+            warnedUnknownOpcode = true;
+            unknownOpcode = opcode;
         }
         // Treat missing/illegal opcode as a single-byte NOP (best-effort to continue execution)
         // Note: This hides real errors; once things are stable we may want to fail instead.
@@ -393,8 +365,33 @@ if (bus.nmiLine) {
        if (bus.ppu) bus.ppu->StepCycles(delta * 3);
     }*/
 
-    void CPU::Execute(u32& Cycles, Bus& bus) {
+void CPU::Execute(u32& Cycles, Bus& bus) {
+    if (debugger.Active()) {
+        debugger.Attach(*this, bus);
+        DebugHooks hooks{debugger};
+        ExecuteHooked(Cycles, bus, hooks);
+        debugger.Detach();
+        return;
+    }
+    NoExecuteHooks hooks;
+    ExecuteHooked(Cycles, bus, hooks);
+}
+
+template <class Hooks>
+bool CPU::ExecuteHooked(u32& Cycles, Bus& bus, Hooks& hooks) {
+        // A watchpoint can pause mid-instruction; stop before DMA or an interrupt runs
+        if constexpr (Hooks::enabled) {
+            if (hooks.Paused()) return false;
+        }
         u32 before = Cycles;
+        // In flight until this returns; accesses made between instructions
+        // (memory views, tools) see no offset
+        instructionCycles = &Cycles;
+        instructionStart = before;
+        struct InFlight {
+            const u32*& counter;
+            ~InFlight() { counter = nullptr; }
+        } inFlight{instructionCycles};
 
         if (bus.oamDmaActive) {
             // OAM DMA stalls the CPU; no instruction executes.
@@ -417,46 +414,104 @@ if (bus.nmiLine) {
                 }
             }
             u32 delta = Cycles - before;
+            if constexpr (Hooks::enabled) hooks.Stall(delta);
             if (bus.ppu) bus.ppu->StepCycles(delta * 3);
-            return;
+            return true;
         }
 
         if (bus.nmiLine) {
             bus.nmiLine = false;
             HandleNMI(Cycles, bus);
             u32 delta = Cycles - before;
+            if constexpr (Hooks::enabled) hooks.Interrupt(*this, bus, true, delta);
             if (bus.ppu) bus.ppu->StepCycles(delta * 3);
-            return;
+            return true;
         }
 
         if (bus.cpu && bus.cpu->Interrupt && !GetFlag(FLAG_I)) {
             IRQ_Handler(Cycles, bus, true);
             bus.cpu->Interrupt = false;
             u32 delta = Cycles - before;
+            if constexpr (Hooks::enabled) hooks.Interrupt(*this, bus, false, delta);
             if (bus.ppu) bus.ppu->StepCycles(delta * 3);
-            return;
+            return true;
         }
 
         if (bus.irqEnable && !GetFlag(FLAG_I)) {
             IRQ_Handler(Cycles, bus, true);
             bus.irqEnable = false;
             u32 delta = Cycles - before;
+            if constexpr (Hooks::enabled) hooks.Interrupt(*this, bus, false, delta);
             if (bus.ppu) bus.ppu->StepCycles(delta * 3);
-            return;
+            return true;
         }
 
+        if constexpr (Hooks::enabled) {
+            if (!hooks.BeforeInstruction(*this, bus)) return false;
+        }
+        if (traceSink) traceSink->OnInstruction(CaptureTrace(bus, Cycles));
+        Word pc = PC;
         int opcode = FetchByte(Cycles, bus);
         InvokeInstruction(opcode, Cycles, bus);
 
         u32 delta = Cycles - before;
+        if constexpr (Hooks::enabled) hooks.Instruction(*this, bus, pc, static_cast<Byte>(opcode), delta);
         if (bus.ppu) bus.ppu->StepCycles(delta * 3);
+        return true;
     }
 
+void CPU::RunFrame(u32& Cycles, Bus& bus, bool render) {
+    if (debugger.Active()) {
+        debugger.Attach(*this, bus);
+        DebugHooks hooks{debugger};
+        RunFrameHooked(Cycles, bus, hooks, render);
+        debugger.Detach();
+        return;
+    }
+    NoExecuteHooks hooks;
+    RunFrameHooked(Cycles, bus, hooks, render);
+}
 
+template <class Hooks>
+void CPU::RunFrameWith(u32& Cycles, Bus& bus, Hooks& hooks, bool render) {
+    if (debugger.Active()) {
+        debugger.Attach(*this, bus);
+        DebugHooks debug{debugger};
+        ChainedHooks<DebugHooks, Hooks> chained{debug, hooks};
+        RunFrameHooked(Cycles, bus, chained, render);
+        debugger.Detach();
+        return;
+    }
+    RunFrameHooked(Cycles, bus, hooks, render);
+}
 
+// Frames end at the start of VBlank (PPU frameCount increments). Without a PPU
+// attached, run one NTSC frame worth of CPU cycles instead.
+template <class Hooks>
+void CPU::RunFrameHooked(u32& Cycles, Bus& bus, Hooks& hooks, bool render) {
+    if (bus.ppu) {
+        uint64_t frame = bus.ppu->frameCount;
+        bool draw = bus.ppu->drawFrame;
+        bus.ppu->drawFrame = render;
+        while (bus.ppu->frameCount == frame) {
+            if (!ExecuteHooked(Cycles, bus, hooks)) break;
+        }
+        bus.ppu->drawFrame = draw;
+        return;
+    }
+    u32 start = Cycles;
+    while (Cycles - start < CYCLES_PER_FRAME) {
+        if (!ExecuteHooked(Cycles, bus, hooks)) break;
+    }
+}
 
-
-
-
-
-
+template bool CPU::ExecuteHooked<NoExecuteHooks>(u32&, Bus&, NoExecuteHooks&);
+template void CPU::RunFrameHooked<NoExecuteHooks>(u32&, Bus&, NoExecuteHooks&, bool);
+template bool CPU::ExecuteHooked<Profiler>(u32&, Bus&, Profiler&);
+template void CPU::RunFrameHooked<Profiler>(u32&, Bus&, Profiler&, bool);
+template bool CPU::ExecuteHooked<DebugHooks>(u32&, Bus&, DebugHooks&);
+template void CPU::RunFrameHooked<DebugHooks>(u32&, Bus&, DebugHooks&, bool);
+template bool CPU::ExecuteHooked<Heatmap>(u32&, Bus&, Heatmap&);
+template void CPU::RunFrameHooked<Heatmap>(u32&, Bus&, Heatmap&, bool);
+template void CPU::RunFrameWith<Profiler>(u32&, Bus&, Profiler&, bool);
+template void CPU::RunFrameWith<Heatmap>(u32&, Bus&, Heatmap&, bool);
@@ -0,0 +1,203 @@
+#include "headers/debugger.h"
+#include "headers/cpu.h"
+#include "headers/ppu.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+const char* const SOURCE_NAMES[] = {"a", "x", "y", "sp", "p", "value"};
+const char* const OP_NAMES[] = {"==", "!=", "<", ">", "<=", ">=", "&"};
+
+uint32_t Key(Debugger::Kind kind, uint16_t addr) {
+    return uint32_t(kind) << 16 | addr;
+}
+}
+
+bool BreakCondition::Parse(const std::string& text, BreakCondition& out) {
+    std::string s;
+    for (char c : text) {
+        if (!std::isspace(static_cast<unsigned char>(c))) s += char(std::tolower(static_cast<unsigned char>(c)));
+    }
+    size_t i = 0;
+    while (i < s.size() && std::isalpha(static_cast<unsigned char>(s[i]))) ++i;
+    std::string source = s.substr(0, i);
+    BreakCondition c;
+    bool known = false;
+    for (int k = 0; k <= Value; ++k) {
+        if (source == SOURCE_NAMES[k]) {
+            c.source = static_cast<Source>(k);
+            known = true;
+        }
+    }
+    if (!known) return false;
+
+    // Two-character operators first so "<=" is not read as "<"
+    static const Op order[] = {Equal, NotEqual, LessEqual, GreaterEqual, Less, Greater, BitsSet};
+    known = false;
+    for (Op op : order) {
+        std::string name = OP_NAMES[op];
+        if (s.compare(i, name.size(), name) == 0) {
+            c.op = op;
+            i += name.size();
+            known = true;
+            break;
+        }
+    }
+    if (!known || i >= s.size()) return false;
+
+    int base = 10;
+    if (s[i] == '$') {
+        base = 16;
+        ++i;
+    } else if (s.compare(i, 2, "0x") == 0) {
+        base = 16;
+        i += 2;
+    }
+    char* end = nullptr;
+    unsigned long v = std::strtoul(s.c_str() + i, &end, base);
+    if (end == s.c_str() + i || *end != '\0' || v > 0xFF) return false;
+    c.operand = static_cast<uint8_t>(v);
+    out = c;
+    return true;
+}
+
+std::string BreakCondition::ToString() const {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%s %s $%02X", SOURCE_NAMES[source], OP_NAMES[op], operand);
+    return buf;
+}
+
+bool BreakCondition::Test(uint8_t lhs) const {
+    switch (op) {
+    case Equal:        return lhs == operand;
+    case NotEqual:     return lhs != operand;
+    case Less:         return lhs < operand;
+    case Greater:      return lhs > operand;
+    case LessEqual:    return lhs <= operand;
+    case GreaterEqual: return lhs >= operand;
+    case BitsSet:      return (lhs & operand) == operand;
+    }
+    return false;
+}
+
+void Debugger::Add(Kind kind, uint16_t addr, const BreakCondition* condition) {
+    if (!Has(kind, addr)) {
+        bits[kind][addr >> 6] |= uint64_t(1) << (addr & 63);
+        ++count;
+    }
+    if (condition) conditions[Key(kind, addr)] = *condition;
+    else conditions.erase(Key(kind, addr));
+}
+
+void Debugger::Remove(Kind kind, uint16_t addr) {
+    if (!Has(kind, addr)) return;
+    bits[kind][addr >> 6] &= ~(uint64_t(1) << (addr & 63));
+    conditions.erase(Key(kind, addr));
+    --count;
+}
+
+void Debugger::Clear() {
+    for (auto& b : bits) b.fill(0);
+    conditions.clear();
+    count = 0;
+}
+
+std::vector<Debugger::Breakpoint> Debugger::List() const {
+    std::vector<Breakpoint> out;
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        for (size_t w = 0; w < WORDS; ++w) {
+            if (!bits[k][w]) continue;
+            for (int b = 0; b < 64; ++b) {
+                if (!((bits[k][w] >> b) & 1)) continue;
+                uint16_t addr = static_cast<uint16_t>(w * 64 + b);
+                Breakpoint bp{static_cast<Kind>(k), addr, false, {}};
+                auto it = conditions.find(Key(bp.kind, addr));
+                if (it != conditions.end()) {
+                    bp.conditional = true;
+                    bp.condition = it->second;
+                }
+                out.push_back(bp);
+            }
+        }
+    }
+    return out;
+}
+
+void Debugger::Resume(uint16_t pc) {
+    pause = false;
+    skipOnce = true;
+    skipPc = pc;
+}
+
+void Debugger::Attach(const CPU& c, Bus& b) {
+    cpu = &c;
+    bus = &b;
+    b.AddTap(this);
+}
+
+void Debugger::Detach() {
+    if (bus) bus->RemoveTap(this);
+}
+
+bool Debugger::Check(Kind kind, uint16_t addr, uint8_t value) {
+    if (!enabled || !Has(kind, addr)) return false;
+    if (!conditions.empty()) {
+        auto it = conditions.find(Key(kind, addr));
+        if (it != conditions.end()) {
+            const BreakCondition& c = it->second;
+            uint8_t lhs = value;
+            switch (c.source) {
+            case BreakCondition::A:  lhs = cpu->A; break;
+            case BreakCondition::X:  lhs = cpu->X; break;
+            case BreakCondition::Y:  lhs = cpu->Y; break;
+            case BreakCondition::SP: lhs = cpu->SP; break;
+            case BreakCondition::P:  lhs = cpu->P; break;
+            case BreakCondition::Value: break;
+            }
+            if (!c.Test(lhs)) return false;
+        }
+    }
+    pause = true;
+    lastHit = {kind, addr, value, fetchStart};
+    ++hits;
+    return true;
+}
+
+bool Debugger::BeforeInstruction(const CPU& c, const Bus& b) {
+    if (pause) return false;
+    uint16_t pc = c.PC;
+    uint8_t opcode = b.peek(pc);
+    fetchStart = pc;
+    fetchLength = CPU::InstructionLength(opcode);
+    if (skipOnce) {
+        skipOnce = false;
+        if (pc == skipPc) return true;
+    }
+    return !Check(EXECUTE, pc, opcode);
+}
+
+void Debugger::CheckPPU(Kind kind, uint8_t value) {
+    const PPU* ppu = bus->ppu;
+    if (!ppu) return;
+    uint16_t addr = ppu->GetVRAMAddr();
+    if (kind == PPU_READ) {
+        // Reported after the read, so the address has already been stepped
+        addr = (addr - ((ppu->GetPPUCTRL() & 0x04) ? 32 : 1)) & 0x3FFF;
+        value = ppu->PeekVRAM(addr);
+    }
+    Check(kind, addr, value);
+}
+
+void Debugger::OnCPURead(uint16_t addr, uint8_t value) {
+    // Opcode and operand fetches of the running instruction are not data reads
+    if (uint16_t(addr - fetchStart) < fetchLength) return;
+    Check(READ, addr, value);
+    if (addr >= 0x2000 && addr <= 0x3FFF && (addr & 7) == 7) CheckPPU(PPU_READ, 0);
+}
+
+void Debugger::OnCPUWrite(uint16_t addr, uint8_t value) {
+    Check(WRITE, addr, value);
+    if (addr >= 0x2000 && addr <= 0x3FFF && (addr & 7) == 7) CheckPPU(PPU_WRITE, value);
+}
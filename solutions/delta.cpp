@@ -0,0 +1,111 @@
+#include "headers/delta.h"
+#include <cstring>
+
+namespace {
+// Zero runs shorter than this are cheaper to keep inside a literal block
+constexpr size_t MIN_ZERO_RUN = 4;
+
+void PutVarint(std::vector<uint8_t>& out, size_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+bool GetVarint(const uint8_t*& p, const uint8_t* end, size_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) return false;
+        uint8_t b = *p++;
+        v |= size_t(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+size_t CountZeros(const uint8_t* in, size_t i, size_t n) {
+    size_t start = i;
+    while (i + 8 <= n) {
+        uint64_t w;
+        std::memcpy(&w, in + i, 8);
+        if (w != 0) break;
+        i += 8;
+    }
+    while (i < n && in[i] == 0) ++i;
+    return i - start;
+}
+}
+
+void XorBytes(const uint8_t* a, const uint8_t* b, uint8_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t x, y;
+        std::memcpy(&x, a + i, 8);
+        std::memcpy(&y, b + i, 8);
+        x ^= y;
+        std::memcpy(out + i, &x, 8);
+    }
+    for (; i < n; ++i) out[i] = a[i] ^ b[i];
+}
+
+size_t ZeroRleEncode(const uint8_t* in, size_t n, std::vector<uint8_t>& out) {
+    size_t before = out.size();
+    size_t i = 0;
+    while (i < n) {
+        size_t zeros = CountZeros(in, i, n);
+        i += zeros;
+
+        // Literal block runs until the next zero run worth encoding
+        size_t litStart = i;
+        size_t run = 0;
+        while (i < n) {
+            if (in[i] == 0) {
+                if (++run >= MIN_ZERO_RUN) break;
+            } else {
+                run = 0;
+            }
+            ++i;
+        }
+        size_t litEnd = (i < n) ? i + 1 - run : i;
+        if (i < n) i = litEnd;
+
+        PutVarint(out, zeros);
+        PutVarint(out, litEnd - litStart);
+        out.insert(out.end(), in + litStart, in + litEnd);
+    }
+    return out.size() - before;
+}
+
+bool ZeroRleDecode(const uint8_t* in, size_t len, uint8_t* out, size_t n) {
+    const uint8_t* p = in;
+    const uint8_t* end = in + len;
+    size_t pos = 0;
+    while (p < end) {
+        size_t zeros, lits;
+        if (!GetVarint(p, end, zeros) || !GetVarint(p, end, lits)) return false;
+        if (zeros > n - pos || lits > n - pos - zeros || lits > size_t(end - p)) return false;
+        std::memset(out + pos, 0, zeros);
+        pos += zeros;
+        std::memcpy(out + pos, p, lits);
+        pos += lits;
+        p += lits;
+    }
+    return pos == n;
+}
+
+bool ZeroRleDecodeXor(const uint8_t* in, size_t len, uint8_t* out, size_t n) {
+    const uint8_t* p = in;
+    const uint8_t* end = in + len;
+    size_t pos = 0;
+    while (p < end) {
+        size_t zeros, lits;
+        if (!GetVarint(p, end, zeros) || !GetVarint(p, end, lits)) return false;
+        if (zeros > n - pos || lits > n - pos - zeros || lits > size_t(end - p)) return false;
+        pos += zeros;
+        for (size_t k = 0; k < lits; ++k) out[pos + k] ^= p[k];
+        pos += lits;
+        p += lits;
+    }
+    return pos == n;
+}
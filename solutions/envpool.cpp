@@ -0,0 +1,255 @@
+#include "headers/envpool.h"
+#include "headers/console.h"
+#include "headers/threadpool.h"
+#include "headers/observation.h"
+#include "headers/ramsearch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <new>
+
+static_assert(NES_ENV_RAM_BYTES == Bus::RAM_SIZE, "RAM observation is the internal 2KB");
+
+namespace {
+// Consoles live in one array of cache-line aligned slots, so neighbouring
+// instances stepped by different workers never share a line
+struct alignas(64) EnvSlot {
+    Console console;
+    uint32_t episodeFrames = 0;
+    // Processed observations only
+    std::unique_ptr<ObservationPipeline> observation;
+    std::vector<uint8_t> indices;
+    // Created by the first nes_env_ramsearch_* call on the slot
+    std::unique_ptr<RamSearch> ramSearch;
+};
+}
+
+struct NesEnvPool {
+    std::unique_ptr<EnvSlot[]> slots;
+    int count = 0;
+    int frameSkip = 1;
+    uint32_t maxFrames = 0;
+    int doneAddr = -1;
+    uint8_t doneValue = 0;
+    MachineState start{};
+    std::unique_ptr<ThreadPool> workers;
+    bool processed = false;
+    int observationBytes = 0;
+};
+
+static void ResetSlot(NesEnvPool& pool, EnvSlot& slot) {
+    slot.console.Restore(pool.start);
+    slot.episodeFrames = 0;
+    if (slot.observation) slot.observation->Reset();
+}
+
+// Frames of one step with the action held; the last ones are drawn by drawLast,
+// which receives how many final frames it must render
+template <typename Draw>
+static void RunStep(NesEnvPool& pool, EnvSlot& slot, uint8_t action, int drawFrames, Draw drawLast) {
+    Console& console = slot.console;
+    console.SetInput(0, action);
+    drawFrames = std::min(drawFrames, pool.frameSkip);
+    for (int f = 0; f < pool.frameSkip - drawFrames; ++f) console.RunFrame(false);
+    drawLast(drawFrames);
+    slot.episodeFrames += uint32_t(pool.frameSkip);
+}
+
+// Copy RAM out, evaluate the end conditions and restart finished episodes
+static void FinishStep(NesEnvPool& pool, EnvSlot& slot, size_t i, uint8_t* ram, uint8_t* done) {
+    const uint8_t* mem = slot.console.bus.ram.Data;
+    if (ram) std::memcpy(ram + i * NES_ENV_RAM_BYTES, mem, NES_ENV_RAM_BYTES);
+    bool over = (pool.maxFrames && slot.episodeFrames >= pool.maxFrames) ||
+                (pool.doneAddr >= 0 && mem[pool.doneAddr] == pool.doneValue);
+    if (done) done[i] = over ? 1 : 0;
+    if (over) ResetSlot(pool, slot);
+}
+
+// Run fn on the RAM search of one slot, or of every slot for slot < 0
+template <typename Fn>
+static bool ForRamSearch(NesEnvPool* pool, int slot, Fn fn) {
+    if (!pool || slot >= pool->count) return false;
+    for (int i = slot < 0 ? 0 : slot; i < (slot < 0 ? pool->count : slot + 1); ++i) {
+        EnvSlot& s = pool->slots[i];
+        if (!s.ramSearch) s.ramSearch.reset(new RamSearch());
+        fn(s);
+    }
+    return true;
+}
+
+extern "C" {
+
+NesEnvPool* nes_env_create(const char* romPath, int count, int threads, int frameSkip) {
+    if (!romPath || count <= 0) {
+        std::cerr << "nes_env_create: need a ROM path and at least one console\n";
+        return nullptr;
+    }
+    try {
+        std::unique_ptr<NesEnvPool> pool(new NesEnvPool());
+        pool->count = count;
+        pool->frameSkip = std::max(1, frameSkip);
+        pool->slots.reset(new EnvSlot[count]);
+        for (int i = 0; i < count; ++i) {
+            if (!pool->slots[i].console.LoadROM(romPath)) return nullptr;
+        }
+        pool->slots[0].console.Snapshot(pool->start);
+        pool->workers.reset(new ThreadPool(threads > 0 ? size_t(threads) : 0, threads <= 0));
+        return pool.release();
+    } catch (const std::bad_alloc&) {
+        std::cerr << "nes_env_create: out of memory for " << count << " consoles\n";
+        return nullptr;
+    } catch (const std::exception& e) {
+        std::cerr << "nes_env_create: " << e.what() << "\n";
+        return nullptr;
+    } catch (...) {
+        // Nothing may unwind into a C or ctypes caller
+        std::cerr << "nes_env_create: failed to create the pool\n";
+        return nullptr;
+    }
+}
+
+void nes_env_destroy(NesEnvPool* pool) {
+    delete pool;
+}
+
+int nes_env_count(const NesEnvPool* pool) {
+    return pool ? pool->count : 0;
+}
+
+void nes_env_set_max_frames(NesEnvPool* pool, uint32_t frames) {
+    if (pool) pool->maxFrames = frames;
+}
+
+int nes_env_set_done_ram(NesEnvPool* pool, int addr, int value) {
+    if (!pool) return -1;
+    if (addr >= NES_ENV_RAM_BYTES) {
+        std::cerr << "nes_env_set_done_ram: address $" << std::hex << addr << std::dec
+                  << " is outside the 2KB internal RAM\n";
+        return -1;
+    }
+    pool->doneAddr = addr < 0 ? -1 : addr;
+    pool->doneValue = static_cast<uint8_t>(value);
+    return 0;
+}
+
+int nes_env_reset(NesEnvPool* pool, uint32_t* obs, uint8_t* ram) {
+    if (!pool) return -1;
+    pool->workers->ParallelFor(size_t(pool->count), [&](size_t i) {
+        EnvSlot& slot = pool->slots[i];
+        ResetSlot(*pool, slot);
+        // Nothing has been drawn at power-on
+        if (obs) std::fill_n(obs + i * NES_ENV_OBS_PIXELS, NES_ENV_OBS_PIXELS, 0xFF000000u);
+        if (ram) std::memcpy(ram + i * NES_ENV_RAM_BYTES, slot.console.bus.ram.Data, NES_ENV_RAM_BYTES);
+    });
+    return 0;
+}
+
+int nes_env_step(NesEnvPool* pool, const uint8_t* actions, uint32_t* obs, uint8_t* ram, uint8_t* done) {
+    if (!pool) return -1;
+    pool->workers->ParallelFor(size_t(pool->count), [&](size_t i) {
+        EnvSlot& slot = pool->slots[i];
+        RunStep(*pool, slot, actions ? actions[i] : 0, 1, [&](int) {
+            if (obs) slot.console.RunFrame(obs + i * NES_ENV_OBS_PIXELS);
+            else slot.console.RunFrame(false);
+        });
+        FinishStep(*pool, slot, i, ram, done);
+    });
+    return 0;
+}
+
+int nes_env_set_observation(NesEnvPool* pool, const NesEnvObservation* config) {
+    if (!pool || !config) return -1;
+    ObservationConfig oc;
+    oc.cropTop = config->cropTop;
+    oc.cropBottom = config->cropBottom;
+    oc.cropLeft = config->cropLeft;
+    oc.cropRight = config->cropRight;
+    oc.width = config->width;
+    oc.height = config->height;
+    oc.area = config->area != 0;
+    oc.maxPool = config->maxPool != 0;
+    oc.stack = config->stack;
+    if (!ObservationPipeline(oc).Valid()) {
+        std::cerr << "nes_env_set_observation: crop/size leave an empty observation\n";
+        return -1;
+    }
+    for (int i = 0; i < pool->count; ++i) {
+        EnvSlot& slot = pool->slots[i];
+        slot.observation.reset(new ObservationPipeline(oc));
+        slot.indices.assign(NES_ENV_OBS_PIXELS, PPU::BLACK_INDEX);
+    }
+    pool->processed = true;
+    pool->observationBytes = int(pool->slots[0].observation->ObservationBytes());
+    return pool->observationBytes;
+}
+
+int nes_env_reset_processed(NesEnvPool* pool, uint8_t* obs, uint8_t* ram) {
+    if (!pool || !pool->processed) return -1;
+    pool->workers->ParallelFor(size_t(pool->count), [&](size_t i) {
+        EnvSlot& slot = pool->slots[i];
+        ResetSlot(*pool, slot);
+        if (obs) slot.observation->Observe(obs + i * size_t(pool->observationBytes));
+        if (ram) std::memcpy(ram + i * NES_ENV_RAM_BYTES, slot.console.bus.ram.Data, NES_ENV_RAM_BYTES);
+    });
+    return 0;
+}
+
+int nes_env_step_processed(NesEnvPool* pool, const uint8_t* actions, uint8_t* obs, uint8_t* ram, uint8_t* done) {
+    if (!pool || !pool->processed) return -1;
+    pool->workers->ParallelFor(size_t(pool->count), [&](size_t i) {
+        EnvSlot& slot = pool->slots[i];
+        ObservationPipeline& observation = *slot.observation;
+        int pooledFrames = observation.Config().maxPool ? 2 : 1;
+        RunStep(*pool, slot, actions ? actions[i] : 0, pooledFrames, [&](int frames) {
+            for (int f = 0; f < frames; ++f) {
+                slot.console.RunFrameIndexed(slot.indices.data());
+                observation.AddFrame(slot.indices.data());
+            }
+        });
+        if (obs) observation.Observe(obs + i * size_t(pool->observationBytes));
+        FinishStep(*pool, slot, i, ram, done);
+    });
+    return 0;
+}
+
+int nes_env_ramsearch_reset(NesEnvPool* pool, int slot, int includePrgRam) {
+    return ForRamSearch(pool, slot, [&](EnvSlot& s) { s.ramSearch->Reset(includePrgRam != 0); }) ? 0 : -1;
+}
+
+int nes_env_ramsearch_capture(NesEnvPool* pool, int slot) {
+    return ForRamSearch(pool, slot, [&](EnvSlot& s) { s.ramSearch->Capture(s.console.bus); }) ? 0 : -1;
+}
+
+int nes_env_ramsearch_filter(NesEnvPool* pool, int slot, const NesEnvRamQuery* query) {
+    if (!query || query->op < RamQuery::Equal || query->op > RamQuery::ChangedBy) return -1;
+    RamQuery q;
+    q.op = static_cast<RamQuery::Op>(query->op);
+    q.vsPrevious = query->vsPrevious != 0;
+    q.value = static_cast<uint16_t>(query->value);
+    q.high = static_cast<uint16_t>(query->high);
+    q.word = query->word != 0;
+    q.bigEndian = query->bigEndian != 0;
+    size_t left = 0;
+    bool ok = ForRamSearch(pool, slot, [&](EnvSlot& s) {
+        left += s.ramSearch->Filter(q);
+    });
+    return ok ? int(left) : -1;
+}
+
+int nes_env_ramsearch_candidates(NesEnvPool* pool, int slot, int word, int bigEndian,
+                                 uint16_t* addrs, uint16_t* values, int max) {
+    if (!pool || slot < 0 || slot >= pool->count || !addrs || max < 0) return -1;
+    EnvSlot& s = pool->slots[slot];
+    if (!s.ramSearch) return 0;
+    std::vector<uint32_t> found = s.ramSearch->Candidates(size_t(max));
+    for (size_t i = 0; i < found.size(); ++i) {
+        addrs[i] = RamSearch::Address(found[i]);
+        if (values) values[i] = s.ramSearch->Snapshots() ? s.ramSearch->Value(found[i], word != 0, bigEndian != 0) : 0;
+    }
+    return int(found.size());
+}
+
+}
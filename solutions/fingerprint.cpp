@@ -0,0 +1,177 @@
+#include "headers/fingerprint.h"
+#include "headers/cpu.h"
+#include "headers/hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FINGERPRINT_SSE2 1
+#else
+#define FINGERPRINT_SSE2 0
+#endif
+
+namespace {
+constexpr size_t STRIPE = 64;               // bytes consumed per accumulate step
+constexpr size_t STRIPES_PER_BLOCK = 16;    // accumulators are scrambled after each block
+constexpr uint64_t PRIME32 = 0x9E3779B1ULL;
+
+// Per-lane keys: stripe s of a block uses KEYS[s..s+7], scrambling uses
+// KEYS[24..31] and the finalizer reads pairs from the start of the table
+struct KeyTable {
+    uint64_t k[32];
+};
+
+constexpr KeyTable MakeKeys() {
+    KeyTable t{};
+    uint64_t x = 0x243F6A8885A308D3ULL;
+    for (int i = 0; i < 32; ++i) {
+        x += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = x;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        t.k[i] = z ^ (z >> 31);
+    }
+    return t;
+}
+
+constexpr KeyTable KEYS = MakeKeys();
+
+inline void AccumulateScalar(uint64_t* acc, const uint8_t* p, const uint64_t* key) {
+    for (int i = 0; i < 8; ++i) {
+        uint64_t dv = HashDetail::Read64(p + 8 * i);
+        uint64_t dk = dv ^ key[i];
+        acc[i ^ 1] += dv;
+        acc[i] += (dk & 0xFFFFFFFFULL) * (dk >> 32);
+    }
+}
+
+inline void ScrambleScalar(uint64_t* acc, const uint64_t* key) {
+    for (int i = 0; i < 8; ++i) {
+        uint64_t a = acc[i];
+        acc[i] = (a ^ (a >> 47) ^ key[i]) * PRIME32;
+    }
+}
+
+}
+
+namespace FingerprintDetail {
+void AccumulateStripesScalar(uint64_t* acc, const uint8_t* p, size_t stripes) {
+    for (size_t s = 0; s < stripes; ++s, p += STRIPE) {
+        AccumulateScalar(acc, p, KEYS.k + (s % STRIPES_PER_BLOCK));
+        if (s % STRIPES_PER_BLOCK == STRIPES_PER_BLOCK - 1) ScrambleScalar(acc, KEYS.k + 24);
+    }
+}
+
+void AccumulateStripes(uint64_t* accOut, const uint8_t* p, size_t stripes) {
+#if FINGERPRINT_SSE2
+    // Same arithmetic as the scalar path, two lanes per register
+    __m128i acc[4];
+    for (int j = 0; j < 4; ++j) acc[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accOut + 2 * j));
+    const __m128i prime = _mm_set1_epi32(static_cast<int>(PRIME32));
+
+    for (size_t s = 0; s < stripes; ++s, p += STRIPE) {
+        const uint64_t* key = KEYS.k + (s % STRIPES_PER_BLOCK);
+        for (int j = 0; j < 4; ++j) {
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * j));
+            __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 2 * j));
+            __m128i dk = _mm_xor_si128(d, k);
+            __m128i product = _mm_mul_epu32(dk, _mm_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1)));
+            __m128i swapped = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+            acc[j] = _mm_add_epi64(acc[j], _mm_add_epi64(product, swapped));
+        }
+        if (s % STRIPES_PER_BLOCK == STRIPES_PER_BLOCK - 1) {
+            for (int j = 0; j < 4; ++j) {
+                __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(KEYS.k + 24 + 2 * j));
+                __m128i v = _mm_xor_si128(_mm_xor_si128(acc[j], _mm_srli_epi64(acc[j], 47)), k);
+                __m128i lo = _mm_mul_epu32(v, prime);
+                __m128i hi = _mm_mul_epu32(_mm_srli_epi64(v, 32), prime);
+                acc[j] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+            }
+        }
+    }
+    for (int j = 0; j < 4; ++j) _mm_storeu_si128(reinterpret_cast<__m128i*>(accOut + 2 * j), acc[j]);
+#else
+    AccumulateStripesScalar(accOut, p, stripes);
+#endif
+}
+}
+
+namespace {
+// 64x64 -> 128 multiply, folded to 64 bits
+inline uint64_t MulFold64(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#else
+    uint64_t aLo = a & 0xFFFFFFFFULL, aHi = a >> 32;
+    uint64_t bLo = b & 0xFFFFFFFFULL, bHi = b >> 32;
+    uint64_t ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+    uint64_t cross = (ll >> 32) + (lh & 0xFFFFFFFFULL) + hl;
+    uint64_t lo = (cross << 32) | (ll & 0xFFFFFFFFULL);
+    uint64_t hi = hh + (lh >> 32) + (cross >> 32);
+    return lo ^ hi;
+#endif
+}
+}
+
+Hash128 HashBytes128(const void* data, size_t len, uint64_t seed) {
+    using namespace HashDetail;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+
+    uint64_t acc[8];
+    for (int i = 0; i < 8; ++i) acc[i] = KEYS.k[8 + i] ^ seed;
+
+    size_t stripes = len / STRIPE;
+    FingerprintDetail::AccumulateStripes(acc, p, stripes);
+    if (size_t rest = len % STRIPE) {
+        uint8_t tail[STRIPE] = {0};
+        std::memcpy(tail, p + stripes * STRIPE, rest);
+        AccumulateScalar(acc, tail, KEYS.k + (stripes % STRIPES_PER_BLOCK));
+    }
+
+    Hash128 h;
+    h.lo = static_cast<uint64_t>(len) * P1 ^ seed;
+    h.hi = ~(static_cast<uint64_t>(len) * P2) ^ seed;
+    for (int i = 0; i < 4; ++i) {
+        h.lo += MulFold64(acc[2 * i] ^ KEYS.k[2 * i], acc[2 * i + 1] ^ KEYS.k[2 * i + 1]);
+        h.hi += MulFold64(acc[2 * i] ^ KEYS.k[16 + 2 * i], acc[2 * i + 1] ^ KEYS.k[17 + 2 * i]);
+    }
+    h.lo = Avalanche(h.lo);
+    h.hi = Avalanche(h.hi);
+    return h;
+}
+
+Hash128 StateFingerprint::Update(const CPU& cpu, const Bus& bus, u32 cycles) {
+    Snapshot(cpu, bus, cycles, states[latest ^ 1]);
+    return Commit();
+}
+
+Hash128 StateFingerprint::Update(const MachineState& state) {
+    states[latest ^ 1] = state;
+    return Commit();
+}
+
+Hash128 StateFingerprint::Commit() {
+    MachineState& next = states[latest ^ 1];
+    if (excludeCounters) {
+        next.cpu.cycles = 0;
+        next.ppu.frameCount = 0;
+    }
+
+    const uint8_t* cur = reinterpret_cast<const uint8_t*>(&next);
+    const uint8_t* prev = reinterpret_cast<const uint8_t*>(&states[latest]);
+    rehashed = 0;
+    for (size_t i = 0; i < PAGE_COUNT; ++i) {
+        size_t off = i * PAGE_SIZE;
+        size_t n = std::min(PAGE_SIZE, sizeof(MachineState) - off);
+        if (valid && std::memcmp(cur + off, prev + off, n) == 0) continue;
+        pageHash[i] = HashBytes128(cur + off, n, i).lo;
+        ++rehashed;
+    }
+    latest ^= 1;
+    valid = true;
+    value = HashBytes128(pageHash, sizeof(pageHash));
+    return value;
+}
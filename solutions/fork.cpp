@@ -0,0 +1,73 @@
+#include "headers/fork.h"
+#include <cstring>
+
+namespace {
+size_t PageBytes(size_t i) {
+    size_t start = i * ForkedState::PAGE_SIZE;
+    size_t end = start + ForkedState::PAGE_SIZE;
+    return (end > sizeof(MachineState) ? sizeof(MachineState) : end) - start;
+}
+}
+
+ForkedState::ForkedState(const MachineState& state) {
+    Commit(state, nullptr, nullptr);
+}
+
+void ForkedState::Commit(const MachineState& state, const ForkedState* base, size_t* copiedPages) {
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(&state);
+    auto next = std::make_shared<PageTable>();
+    size_t copied = 0;
+    for (size_t i = 0; i < PAGE_COUNT; ++i) {
+        const uint8_t* bytes = src + i * PAGE_SIZE;
+        size_t n = PageBytes(i);
+        if (base && base->table && std::memcmp(base->PageData(i), bytes, n) == 0) {
+            (*next)[i] = (*base->table)[i];
+            continue;
+        }
+        auto page = std::make_shared<Page>();
+        std::memcpy(page->data(), bytes, n);
+        std::memset(page->data() + n, 0, PAGE_SIZE - n);
+        (*next)[i] = std::move(page);
+        copied++;
+    }
+    table = std::move(next);
+    if (copiedPages) *copiedPages = copied;
+}
+
+void ForkedState::Materialize(MachineState& out) const {
+    uint8_t* dst = reinterpret_cast<uint8_t*>(&out);
+    for (size_t i = 0; i < PAGE_COUNT; ++i) {
+        std::memcpy(dst + i * PAGE_SIZE, PageData(i), PageBytes(i));
+    }
+}
+
+size_t ForkedState::DistinctPages(const ForkedState& other) const {
+    if (table == other.table) return 0;
+    if (!table || !other.table) return PAGE_COUNT;
+    size_t n = 0;
+    for (size_t i = 0; i < PAGE_COUNT; ++i) {
+        if ((*table)[i] != (*other.table)[i]) n++;
+    }
+    return n;
+}
+
+bool ForkRunner::Load(const ForkedState& s) {
+    if (s.Empty()) return false;
+    if (resident.table != s.table) {
+        uint8_t* dst = reinterpret_cast<uint8_t*>(&scratch);
+        for (size_t i = 0; i < ForkedState::PAGE_COUNT; ++i) {
+            if (resident.table && (*resident.table)[i] == (*s.table)[i]) continue;
+            std::memcpy(dst + i * ForkedState::PAGE_SIZE, s.PageData(i), PageBytes(i));
+        }
+        resident = s;
+    }
+    return Restore(cpu, bus, cycles, scratch);
+}
+
+ForkedState ForkRunner::Capture(const ForkedState& parent) {
+    Snapshot(cpu, bus, cycles, scratch);
+    ForkedState child;
+    child.Commit(scratch, &parent, &lastCopied);
+    resident = child;
+    return child;
+}
@@ -4,14 +4,44 @@
 #include "backends/imgui_impl_opengl3.h"
 #include "headers/ppu.h"
 #include "headers/cpu.h"
+#include "headers/romindex.h"
+#include "headers/savestate.h"
+#include "headers/rewind.h"
+#include "headers/movie.h"
+#include "headers/reverse.h"
+#include "headers/statefile.h"
+#include "headers/runahead.h"
+#include "headers/ramsearch.h"
+#include "headers/profiler.h"
+#include "headers/heatmap.h"
+#include "headers/ppulog.h"
 #include <GLFW/glfw3.h> 
 #include <GL/gl.h>
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
 #include <thread>
 
+// Keyboard polling lives with the GUI so the core stays free of GLFW.
+// Controller 1 bits (A, B, Select, Start, Up, Down, Left, Right):
+// Z -> A, X -> B, Right Shift or A -> Select, Enter -> Start
+// Arrow keys -> D-Pad
+static uint8_t PollKeyboard(GLFWwindow* window) {
+    static const int keys[8] = {GLFW_KEY_Z, GLFW_KEY_X, GLFW_KEY_RIGHT_SHIFT, GLFW_KEY_ENTER,
+                                GLFW_KEY_UP, GLFW_KEY_DOWN, GLFW_KEY_LEFT, GLFW_KEY_RIGHT};
+    uint8_t joy = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (glfwGetKey(window, keys[i]) == GLFW_PRESS) joy |= uint8_t(1 << i);
+    }
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) joy |= 1 << Input::BTN_SELECT;
+    return joy;
+}
+
 // Simple memory hex viewer helper
 static void DrawMemoryView(Bus& bus, uint32_t baseAddr, int rows = 16, int cols = 16) {
     ImGui::Begin("Memory");
@@ -55,7 +85,12 @@ static bool HasNonBlackPixel(const std::vector<uint32_t>& pixels) {
     return false;
 }
 
-void RunGUI(CPU& cpu, Bus& bus) {
+void RunGUI(Console& console) {
+    CPU& cpu = console.cpu;
+    Bus& bus = console.bus;
+    PPU& ppu = console.ppu;
+    u32& cycles = console.cycles;
+
     // Setup GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -83,12 +118,7 @@ void RunGUI(CPU& cpu, Bus& bus) {
     // Setup Platform/Renderer bindings
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init(glsl_version);
-    // PPU + texture for pattern table/frame view
-    PPU ppu(bus);
-    //ppu.Reset();
-    bus.AttachPPU(&ppu);
-    // Attach CPU ptr to bus so mappers can request IRQs
-    bus.AttachCPU(&cpu);
+    // Textures for the frame and pattern table views
     unsigned int ppuTex = 0;
     unsigned int patternTex = 0;
     std::vector<uint32_t> ppuPixels;
@@ -113,10 +143,86 @@ void RunGUI(CPU& cpu, Bus& bus) {
     bool running = true; // auto-start to measure emulation speed
     bool liveRender = true; // Enable live per-frame updates from PPU
     int patternPaletteGroup = 0; // palette group (0..3) used for pattern table viewer
-    u32 cycles = 0;
     char filePath[512] = "";
     uint32_t memBase = 0x0000;
 
+    // ROM library: cached index so the list is available without touching the files
+    RomIndex romIndex;
+    romIndex.Load(RomIndex::DEFAULT_PATH);
+    char libraryDir[512] = "nesTests";
+    int librarySelected = -1;
+
+    // In-memory quick save slot
+    MachineState quickState{};
+    bool hasQuickState = false;
+    char statePath[512] = "quick.nst";
+    bool compressStateFile = false;
+
+    // Rewind: a state is recorded at the start of every frame; hold Backspace to step back
+    RewindBuffer rewind;
+    bool rewindEnabled = true;
+    MachineState rewindState{};
+
+    // Run-ahead (frames emulated past the real frame each host frame)
+    RunAhead runAhead;
+
+    // Input movie: recorded from the current state, or played back over the keyboard
+    enum class MovieMode { Off, Recording, Playing };
+    Movie movie;
+    MovieMode movieMode = MovieMode::Off;
+    size_t movieFrame = 0;
+    char moviePath[512] = "movie.nmv";
+
+    // Reverse debugger: while recording, all emulation goes through it so history can be replayed
+    ReverseDebugger reverse(cpu, bus, cycles);
+    bool reverseEnabled = false;
+    char watchAddr[8] = "0000";
+
+    // RAM search: candidates narrowed across captured snapshots
+    RamSearch ramSearch;
+    RamQuery ramQuery;
+    int ramOp = 0;
+    int ramValue = 0;
+    int ramHigh = 0;
+
+    // Breakpoints: while any is set, the CPU runs its checking loop
+    int bpKind = 0;
+    char bpAddr[8] = "8000";
+    char bpCondition[32] = "";
+
+    // Profiler: while enabled, frames run through the instrumented CPU loop
+    Profiler profiler;
+    bool profiling = false;
+    char foldedPath[512] = "profile.folded";
+
+    // Memory heatmap: while enabled, frames run with the bus and PPU taps attached
+    Heatmap heatmap;
+    bool heatmapping = false;
+    uint64_t heatmapFrame = 0;
+    int heatmapKind = 0;
+    char heatmapPath[512] = "heatmap.bin";
+
+    // PPU register timeline, drawn over the PPU picture while attached
+    PPURegisterLog ppuLog;
+    bool registerTimeline = false;
+    char ppuLogPath[512] = "ppu_timeline.csv";
+
+    auto loadRom = [&](const char* path) {
+        if (!bus.LoadPRGFromFile(path)) {
+            std::cerr << "Falling back to RAM load for: " << path << std::endl;
+            bus.ram.LoadMachineCodeFromFile(path);
+        }
+        cpu.Reset(bus);
+        rewind.Clear();
+        hasQuickState = false;
+        movieMode = MovieMode::Off;
+        reverseEnabled = false;
+        ramSearch.Reset();
+        profiler.Reset();
+        heatmap.Reset();
+        if (registerTimeline) ppuLog.Attach(ppu, bus, cpu);
+    };
+
     // Emulation speed measurement
     const double NES_CPU_FREQ = 1789773.0; // NTSC 6502 cycles/sec
     auto measureStart = std::chrono::steady_clock::now();
@@ -131,29 +237,40 @@ void RunGUI(CPU& cpu, Bus& bus) {
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
         // Map keyboard to NES controller and update bus controller state
-        uint8_t joy = 0;
-        if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS) joy |= (1 << 0); // A
-        if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS) joy |= (1 << 1); // B
-        if (glfwGetKey(window, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) joy |= (1 << 2); // Select
-        if (glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS) joy |= (1 << 3); // Start
-        if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) joy |= (1 << 4); // Up
-        if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) joy |= (1 << 5); // Down
-        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) joy |= (1 << 6); // Left
-        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) joy |= (1 << 7); // Right
+        uint8_t joy = PollKeyboard(window);
         bus.SetControllerButtons(joy);
 
-        if (running) {
-
-
-            // Run enough cycles for one NES frame (about 29780 cycles)
-            uint32_t targetCycles = 29780;
-            uint32_t executed = 0;
-            while (executed < targetCycles) {
-                u32 before = cycles;
-                cpu.Execute(cycles, bus);
-                executed += (cycles - before);
+        bool rewinding = rewindEnabled && !reverseEnabled && glfwGetKey(window, GLFW_KEY_BACKSPACE) == GLFW_PRESS;
+        if (rewinding) {
+            // Step back one frame; re-run it once so the PPU shows the picture, then return to it
+            if (rewind.Pop(rewindState) && Restore(cpu, bus, cycles, rewindState)) {
+                cpu.RunFrame(cycles, bus);
+                Restore(cpu, bus, cycles, rewindState);
+                if (movieMode == MovieMode::Recording) movie.Truncate(movie.Frames() - 1);
+                if (movieMode == MovieMode::Playing && movieFrame > 0) --movieFrame;
             }
-
+            cyclesAtLastMeasure = cycles;
+        } else if (running) {
+            if (rewindEnabled) {
+                Snapshot(cpu, bus, cycles, rewindState);
+                rewind.Push(rewindState);
+            }
+            if (movieMode == MovieMode::Playing) {
+                if (movieFrame < movie.Frames()) movie.ApplyFrame(movieFrame++, bus);
+                else movieMode = MovieMode::Off;
+            } else if (movieMode == MovieMode::Recording) {
+                movie.RecordFrame(bus);
+            }
+            // Run one NES frame (about 29780 cycles), plus any run-ahead frames
+            if (reverseEnabled) reverse.RunFrame();
+            else if (profiling) cpu.RunFrameWith(cycles, bus, profiler);
+            else if (heatmapping) {
+                heatmap.Attach(bus, ppu);
+                cpu.RunFrameWith(cycles, bus, heatmap);
+                heatmap.Detach();
+                heatmap.EndFrame(heatmapFrame++);
+            }
+            else runAhead.RunFrame(cpu, bus, cycles);
         }
 
       
@@ -164,11 +281,7 @@ void RunGUI(CPU& cpu, Bus& bus) {
         ImGui::Begin("Controls");
         ImGui::InputText("ROM Path", filePath, sizeof(filePath));
         if (ImGui::Button("Load PRG (iNES)")) {
-            if (!bus.LoadPRGFromFile(filePath)) {
-                std::cerr << "Falling back to RAM load for: " << filePath << std::endl;
-                bus.ram.LoadMachineCodeFromFile(filePath);
-            }
-            cpu.Reset(bus);
+            loadRom(filePath);
         }
         ImGui::SameLine();
         if (ImGui::Button("Load CHR (raw)")) {
@@ -191,6 +304,20 @@ void RunGUI(CPU& cpu, Bus& bus) {
         }
         ImGui::SameLine();
 
+        ImGui::SameLine();
+        if (ImGui::Button("Snapshot")) {
+            Snapshot(cpu, bus, cycles, quickState);
+            hasQuickState = true;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Restore") && hasQuickState) {
+            if (!Restore(cpu, bus, cycles, quickState)) {
+                std::cerr << "Snapshot does not match the loaded cartridge" << std::endl;
+            } else if (reverseEnabled) {
+                reverse.Reset();
+            }
+            cyclesAtLastMeasure = cycles;
+        }
         ImGui::SameLine();
         if (ImGui::Button(running ? "Pause" : "Run")) {
             running = !running;
@@ -202,7 +329,71 @@ void RunGUI(CPU& cpu, Bus& bus) {
         ImGui::SameLine();
         ImGui::Checkbox("Show ImGui Demo", &show_demo_window);
 
+        ImGui::InputText("State File", statePath, sizeof(statePath));
+        ImGui::SameLine();
+        if (ImGui::Button("Save State")) {
+            MachineState fileState;
+            Snapshot(cpu, bus, cycles, fileState);
+            SaveStateFile(statePath, fileState, bus.romHash, compressStateFile);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Load State")) {
+            StateFileView view;
+            if (!view.Open(statePath) || view.Header()->romHash != bus.romHash) {
+                std::cerr << "Cannot load state file for this ROM: " << statePath << std::endl;
+            } else if (const MachineState* mapped = view.State()) {
+                Restore(cpu, bus, cycles, *mapped);
+            } else {
+                MachineState fileState;
+                if (view.Decode(fileState)) Restore(cpu, bus, cycles, fileState);
+            }
+            if (reverseEnabled) reverse.Reset();
+            cyclesAtLastMeasure = cycles;
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("Compress", &compressStateFile);
+
+        ImGui::InputText("Movie File", moviePath, sizeof(moviePath));
+        ImGui::SameLine();
+        if (movieMode == MovieMode::Off) {
+            if (ImGui::Button("Record")) {
+                movie.StartRecording(cpu, bus, cycles);
+                movieMode = MovieMode::Recording;
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Play")) {
+                std::string path = moviePath;
+                bool fm2 = path.size() > 4 && path.compare(path.size() - 4, 4, ".fm2") == 0;
+                if (fm2 ? movie.ImportFM2(path) : movie.Load(path)) {
+                    // Power-on movies start from a freshly loaded cartridge
+                    if (!movie.fromSnapshot) loadRom(filePath);
+                    if (movie.StartPlayback(cpu, bus, cycles)) {
+                        rewind.Clear();
+                        movieFrame = 0;
+                        movieMode = MovieMode::Playing;
+                        if (reverseEnabled) reverse.Reset();
+                    }
+                    cyclesAtLastMeasure = cycles;
+                }
+            }
+        } else if (ImGui::Button("Stop")) {
+            if (movieMode == MovieMode::Recording) movie.Save(moviePath);
+            movieMode = MovieMode::Off;
+        }
+        ImGui::SameLine();
+        if (movieMode == MovieMode::Recording) ImGui::Text("Recording: %zu frames", movie.Frames());
+        else if (movieMode == MovieMode::Playing) ImGui::Text("Playing: %zu / %zu", movieFrame, movie.Frames());
+        else ImGui::Text("%zu frames", movie.Frames());
+
         ImGui::Text("Cycles last step: %u", cycles);
+        if (ImGui::Checkbox("Rewind (hold Backspace)", &rewindEnabled) && !rewindEnabled) {
+            rewind.Clear();
+        }
+        ImGui::SameLine();
+        ImGui::Text("%zu frames, %.1f / %.0f MB", rewind.Frames(),
+                    rewind.Bytes() / (1024.0 * 1024.0), rewind.MaxBytes() / (1024.0 * 1024.0));
+        ImGui::SetNextItemWidth(80.0f);
+        ImGui::SliderInt("Run-ahead frames", &runAhead.frames, 0, 3);
 
         // Update emulation speed sampler
         auto now = std::chrono::steady_clock::now();
@@ -240,6 +431,42 @@ void RunGUI(CPU& cpu, Bus& bus) {
             (buttons>>4)&1, (buttons>>5)&1, (buttons>>6)&1, (buttons>>7)&1);
         ImGui::End();
 
+        // ROM library window: list indexed ROMs, double-click to load
+        ImGui::Begin("ROM Library");
+        ImGui::InputText("Directory", libraryDir, sizeof(libraryDir));
+        ImGui::SameLine();
+        if (ImGui::Button("Scan")) {
+            size_t hashed = romIndex.Scan(libraryDir);
+            romIndex.Save(RomIndex::DEFAULT_PATH);
+            std::cout << "ROM index: " << romIndex.Entries().size() << " entries (" << hashed << " hashed)\n";
+        }
+        if (ImGui::BeginTable("roms", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+            ImGui::TableSetupColumn("Path");
+            ImGui::TableSetupColumn("Mapper");
+            ImGui::TableSetupColumn("PRG");
+            ImGui::TableSetupColumn("CHR");
+            ImGui::TableSetupColumn("Hash");
+            ImGui::TableHeadersRow();
+            const std::vector<RomInfo>& roms = romIndex.Entries();
+            for (int i = 0; i < static_cast<int>(roms.size()); ++i) {
+                const RomInfo& info = roms[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                if (ImGui::Selectable(info.path.c_str(), librarySelected == i,
+                                      ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick)) {
+                    librarySelected = i;
+                    std::snprintf(filePath, sizeof(filePath), "%s", info.path.c_str());
+                    if (ImGui::IsMouseDoubleClicked(0)) loadRom(filePath);
+                }
+                ImGui::TableNextColumn(); ImGui::Text("%u", unsigned(info.mapper));
+                ImGui::TableNextColumn(); ImGui::Text("%uK", info.prgSize / 1024);
+                ImGui::TableNextColumn(); ImGui::Text("%uK", info.chrSize / 1024);
+                ImGui::TableNextColumn(); ImGui::Text("%016llx", static_cast<unsigned long long>(info.hash));
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+
         // Registers window
         ImGui::Begin("Registers");
         ImGui::Text("PC: %04X", cpu.PC);
@@ -257,6 +484,283 @@ void RunGUI(CPU& cpu, Bus& bus) {
             cpu.GetFlag(CPU::FLAG_C));
         ImGui::End();
 
+        // Reverse debugger window
+        ImGui::Begin("Reverse Debugger");
+        if (ImGui::Checkbox("Record history", &reverseEnabled) && reverseEnabled) {
+            reverse.Reset();
+        }
+        ImGui::SliderInt("Checkpoint every N frames", &reverse.checkpointInterval, 1, 60);
+        if (reverseEnabled) {
+            ImGui::Text("Instruction %llu / %llu (oldest %llu)", (unsigned long long)reverse.Position(),
+                        (unsigned long long)reverse.Head(), (unsigned long long)reverse.Oldest());
+            ImGui::Text("%zu checkpoints, %.1f KB, last seek %.2f ms", reverse.Checkpoints(),
+                        reverse.Bytes() / 1024.0, reverse.LastSeekMs());
+            if (ImGui::Button("Step")) {
+                running = false;
+                reverse.Step();
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Step Back")) {
+                running = false;
+                reverse.StepBack(1);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Frame Back")) {
+                running = false;
+                reverse.StepBackFrame();
+            }
+            ImGui::SetNextItemWidth(60.0f);
+            ImGui::InputText("##watch", watchAddr, sizeof(watchAddr), ImGuiInputTextFlags_CharsHexadecimal);
+            ImGui::SameLine();
+            if (ImGui::Button("Back to Write")) {
+                running = false;
+                if (!reverse.StepBackToWrite(static_cast<uint16_t>(std::strtoul(watchAddr, nullptr, 16)))) {
+                    std::cerr << "No earlier write to $" << watchAddr << " in history" << std::endl;
+                }
+            }
+            if (reverse.Position() < reverse.Head()) {
+                ImGui::TextUnformatted("Replaying history");
+                ImGui::SameLine();
+                if (ImGui::Button("Diverge here")) reverse.Diverge();
+            }
+        }
+        ImGui::End();
+
+        // RAM search window
+        ImGui::Begin("RAM Search");
+        if (ImGui::Button("Capture")) ramSearch.Capture(bus);
+        ImGui::SameLine();
+        if (ImGui::Button("Reset")) ramSearch.Reset();
+        ImGui::SameLine();
+        ImGui::Text("%zu snapshots, %zu candidates", ramSearch.Snapshots(), ramSearch.Count());
+        static const char* const ramOps[] = {"==", "!=", "<", ">", "<=", ">=", "in range", "changed by"};
+        ImGui::SetNextItemWidth(120.0f);
+        ImGui::Combo("##op", &ramOp, ramOps, IM_ARRAYSIZE(ramOps));
+        ImGui::SameLine();
+        ImGui::Checkbox("vs previous", &ramQuery.vsPrevious);
+        ImGui::SameLine();
+        ImGui::Checkbox("16-bit", &ramQuery.word);
+        if (ramQuery.word) {
+            ImGui::SameLine();
+            ImGui::Checkbox("big endian", &ramQuery.bigEndian);
+        }
+        ImGui::SetNextItemWidth(120.0f);
+        ImGui::InputInt("value", &ramValue);
+        if (ramOp == RamQuery::InRange) {
+            ImGui::SetNextItemWidth(120.0f);
+            ImGui::InputInt("high", &ramHigh);
+        }
+        bool filter = ImGui::Button("Filter");
+        ImGui::SameLine();
+        if (ImGui::Button("Capture + Filter")) {
+            ramSearch.Capture(bus);
+            filter = true;
+        }
+        if (filter) {
+            ramQuery.op = static_cast<RamQuery::Op>(ramOp);
+            ramQuery.value = static_cast<uint16_t>(ramValue);
+            ramQuery.high = static_cast<uint16_t>(ramHigh);
+            ramSearch.Filter(ramQuery);
+        }
+        if (ramSearch.Snapshots() > 0 && ImGui::BeginTable("candidates", 3)) {
+            ImGui::TableSetupColumn("Address");
+            ImGui::TableSetupColumn("Value");
+            ImGui::TableSetupColumn("Previous");
+            ImGui::TableHeadersRow();
+            for (uint32_t index : ramSearch.Candidates(100)) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("$%04X", RamSearch::Address(index));
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", ramSearch.Value(index, ramQuery.word, ramQuery.bigEndian));
+                ImGui::TableNextColumn();
+                if (ramSearch.Snapshots() > 1) ImGui::Text("%u", ramSearch.Value(index, ramQuery.word, ramQuery.bigEndian, -2));
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+
+        // Breakpoints window
+        ImGui::Begin("Breakpoints");
+        Debugger& dbg = cpu.debugger;
+        static const char* const bpKinds[] = {"exec", "read", "write", "$2007 read", "$2007 write"};
+        ImGui::Checkbox("Enabled##breakpoints", &dbg.enabled);
+        ImGui::SameLine();
+        ImGui::Text("%zu set, %llu hits", dbg.Count(), static_cast<unsigned long long>(dbg.Hits()));
+        ImGui::SetNextItemWidth(110.0f);
+        ImGui::Combo("##bpkind", &bpKind, bpKinds, IM_ARRAYSIZE(bpKinds));
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(60.0f);
+        ImGui::InputText("addr##bp", bpAddr, sizeof(bpAddr));
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(140.0f);
+        ImGui::InputText("if##bp", bpCondition, sizeof(bpCondition));
+        ImGui::SameLine();
+        if (ImGui::Button("Add##bp")) {
+            BreakCondition condition;
+            bool conditional = bpCondition[0] != '\0';
+            if (conditional && !BreakCondition::Parse(bpCondition, condition)) {
+                std::cerr << "Bad condition: " << bpCondition << " (e.g. a == $10, value & $80)" << std::endl;
+            } else {
+                uint16_t addr = static_cast<uint16_t>(std::strtoul(bpAddr, nullptr, 16));
+                dbg.Add(static_cast<Debugger::Kind>(bpKind), addr, conditional ? &condition : nullptr);
+            }
+        }
+        if (dbg.pause) {
+            const Debugger::Hit& hit = dbg.LastHit();
+            ImGui::Text("Paused: %s $%04X = %02X at PC %04X", bpKinds[hit.kind], hit.addr, hit.value, hit.pc);
+            if (ImGui::Button("Continue")) dbg.Resume(cpu.PC);
+            ImGui::SameLine();
+            if (ImGui::Button("Step")) {
+                dbg.Resume(cpu.PC);
+                cpu.Execute(cycles, bus);
+                dbg.pause = true;
+            }
+        }
+        if (ImGui::BeginTable("breakpoints", 4)) {
+            ImGui::TableSetupColumn("Kind");
+            ImGui::TableSetupColumn("Address");
+            ImGui::TableSetupColumn("Condition");
+            ImGui::TableSetupColumn("");
+            ImGui::TableHeadersRow();
+            for (const Debugger::Breakpoint& bp : dbg.List()) {
+                ImGui::PushID(int(bp.kind) << 16 | bp.addr);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(bpKinds[bp.kind]);
+                ImGui::TableNextColumn();
+                ImGui::Text("$%04X", bp.addr);
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(bp.conditional ? bp.condition.ToString().c_str() : "");
+                ImGui::TableNextColumn();
+                if (ImGui::SmallButton("x")) dbg.Remove(bp.kind, bp.addr);
+                ImGui::PopID();
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+
+        // Profiler window
+        ImGui::Begin("Profiler");
+        ImGui::Checkbox("Enabled", &profiling);
+        ImGui::SameLine();
+        if (ImGui::Button("Reset##profiler")) profiler.Reset();
+        ImGui::Text("%llu instructions, %llu cycles (%llu OAM DMA)",
+            static_cast<unsigned long long>(profiler.Instructions()),
+            static_cast<unsigned long long>(profiler.Cycles()),
+            static_cast<unsigned long long>(profiler.DmaCycles()));
+        ImGui::InputText("##folded", foldedPath, sizeof(foldedPath));
+        ImGui::SameLine();
+        if (ImGui::Button("Export folded stacks")) profiler.WriteFoldedStacks(foldedPath);
+        double totalCycles = profiler.Cycles() ? double(profiler.Cycles()) : 1.0;
+        if (ImGui::CollapsingHeader("Hot spots", ImGuiTreeNodeFlags_DefaultOpen) && ImGui::BeginTable("hotspots", 4)) {
+            ImGui::TableSetupColumn("PC");
+            ImGui::TableSetupColumn("Instructions");
+            ImGui::TableSetupColumn("Cycles");
+            ImGui::TableSetupColumn("%");
+            ImGui::TableHeadersRow();
+            for (const Profiler::HotSpot& h : profiler.HotSpots(50)) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(Profiler::LocationName(h.pc, h.bank).c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(h.instructions));
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(h.cycles));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", 100.0 * double(h.cycles) / totalCycles);
+            }
+            ImGui::EndTable();
+        }
+        if (ImGui::CollapsingHeader("Subroutines") && ImGui::BeginTable("functions", 5)) {
+            ImGui::TableSetupColumn("Entry");
+            ImGui::TableSetupColumn("Calls");
+            ImGui::TableSetupColumn("Inclusive");
+            ImGui::TableSetupColumn("Self");
+            ImGui::TableSetupColumn("Incl %");
+            ImGui::TableHeadersRow();
+            for (const Profiler::Function& f : profiler.Functions(50)) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(Profiler::LocationName(f.pc, f.bank).c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(f.calls));
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(f.inclusiveCycles));
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(f.selfCycles));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", 100.0 * double(f.inclusiveCycles) / totalCycles);
+            }
+            ImGui::EndTable();
+        }
+        if (ImGui::CollapsingHeader("Opcodes") && ImGui::BeginTable("opcodes", 3)) {
+            ImGui::TableSetupColumn("Opcode");
+            ImGui::TableSetupColumn("Count");
+            ImGui::TableSetupColumn("Cycles");
+            ImGui::TableHeadersRow();
+            for (int op = 0; op < 256; ++op) {
+                if (!profiler.OpcodeCount(uint8_t(op))) continue;
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("$%02X", op);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(profiler.OpcodeCount(uint8_t(op))));
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(profiler.OpcodeCycles(uint8_t(op))));
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+
+        // Heatmap window: last frame's accesses per 256-byte page, log scale
+        ImGui::Begin("Heatmap");
+        ImGui::Checkbox("Enabled##heatmap", &heatmapping);
+        ImGui::SameLine();
+        if (ImGui::Button("Reset##heatmap")) heatmap.Reset();
+        ImGui::SameLine();
+        static const char* const heatmapKinds[] = {"read", "write", "execute"};
+        ImGui::SetNextItemWidth(90.0f);
+        ImGui::Combo("##heatmapkind", &heatmapKind, heatmapKinds, IM_ARRAYSIZE(heatmapKinds));
+        ImGui::InputText("##heatmappath", heatmapPath, sizeof(heatmapPath));
+        ImGui::SameLine();
+        if (ImGui::Button("Export##heatmap")) heatmap.Export(heatmapPath);
+        if (!heatmap.History().empty()) {
+            const Heatmap::FramePages& last = heatmap.History().back();
+            auto drawGrid = [](const char* id, const uint32_t* pages, int columns, int rows, uint32_t addrStep) {
+                const float cell = 14.0f;
+                uint32_t peak = 1;
+                for (int i = 0; i < columns * rows; ++i) peak = std::max(peak, pages[i]);
+                ImVec2 origin = ImGui::GetCursorScreenPos();
+                ImDrawList* draw = ImGui::GetWindowDrawList();
+                for (int i = 0; i < columns * rows; ++i) {
+                    float heat = pages[i] ? float(std::log1p(double(pages[i])) / std::log1p(double(peak))) : 0.0f;
+                    ImVec2 a(origin.x + (i % columns) * cell, origin.y + (i / columns) * cell);
+                    ImVec2 b(a.x + cell - 1.0f, a.y + cell - 1.0f);
+                    draw->AddRectFilled(a, b, IM_COL32(int(40 + 215 * heat), int(40 + 120 * heat * (1.0f - heat)), int(60 * (1.0f - heat)), 255));
+                }
+                ImGui::PushID(id);
+                ImGui::Dummy(ImVec2(columns * cell, rows * cell));
+                if (ImGui::IsItemHovered()) {
+                    ImVec2 mouse = ImGui::GetIO().MousePos;
+                    int cx = int((mouse.x - origin.x) / cell);
+                    int cy = int((mouse.y - origin.y) / cell);
+                    if (cx >= 0 && cx < columns && cy >= 0 && cy < rows) {
+                        int i = cy * columns + cx;
+                        ImGui::SetTooltip("$%04X-$%04X: %u", unsigned(i * addrStep), unsigned(i * addrStep + addrStep - 1), pages[i]);
+                    }
+                }
+                ImGui::PopID();
+            };
+            ImGui::Text("CPU %s, frame %llu", heatmapKinds[heatmapKind], static_cast<unsigned long long>(last.frame));
+            drawGrid("cpu", last.cpu[heatmapKind], 16, 16, 0x100);
+            if (heatmapKind != Heatmap::CPU_EXECUTE) {
+                ImGui::Text("PPU %s ($0000-$1FFF CHR, $2000-$2FFF VRAM, $3F00 palette)", heatmapKinds[heatmapKind]);
+                drawGrid("ppu", last.ppu[heatmapKind], 8, 8, 0x100);
+            }
+        }
+        ImGui::End();
+
         // Memory view
         DrawMemoryView(bus, memBase);
 
@@ -285,6 +789,75 @@ void RunGUI(CPU& cpu, Bus& bus) {
             
             ImGui::Begin("PPU");
             ImGui::Image((void*)(intptr_t)ppuTex, ImVec2((float)ppuW * 2.0f, (float)ppuH * 2.0f));
+            // Register timeline: a mark at the dot/scanline of each access or mapper change
+            static const ImU32 timelineColors[] = {IM_COL32(80, 160, 255, 255), IM_COL32(255, 70, 70, 255),
+                IM_COL32(255, 220, 60, 255), IM_COL32(80, 255, 120, 255)};
+            if (registerTimeline) {
+                ImVec2 origin = ImGui::GetItemRectMin();
+                ImDrawList* draw = ImGui::GetWindowDrawList();
+                for (const PPURegisterLog::Event& e : ppuLog.Events()) {
+                    if (e.scanline >= 240 || e.dot < 1 || e.dot > 256) continue;
+                    float x = origin.x + (e.dot - 1) * 2.0f;
+                    float y = origin.y + e.scanline * 2.0f;
+                    draw->AddRectFilled(ImVec2(x - 1.0f, y), ImVec2(x + 3.0f, y + 2.0f), timelineColors[e.kind]);
+                }
+            }
+            if (ImGui::Checkbox("Register timeline", &registerTimeline)) {
+                if (registerTimeline) ppuLog.Attach(ppu, bus, cpu);
+                else ppuLog.Detach();
+            }
+            if (registerTimeline) {
+                ImGui::SameLine();
+                ImGui::Text("frame %llu: %zu events, %zu on visible lines, %zu dropped (blue read, red write, yellow mirroring, green CHR)",
+                    static_cast<unsigned long long>(ppuLog.Frame()), ppuLog.Events().size(), ppuLog.MidFrameChanges(), ppuLog.Dropped());
+                // Whole frame, 2 px per scanline: VBlank (241-260) shaded
+                ImVec2 origin = ImGui::GetCursorScreenPos();
+                ImDrawList* draw = ImGui::GetWindowDrawList();
+                const float height = 16.0f;
+                draw->AddRectFilled(origin, ImVec2(origin.x + 262 * 2.0f, origin.y + height), IM_COL32(30, 30, 30, 255));
+                draw->AddRectFilled(ImVec2(origin.x + 241 * 2.0f, origin.y), ImVec2(origin.x + 261 * 2.0f, origin.y + height), IM_COL32(60, 60, 90, 255));
+                for (const PPURegisterLog::Event& e : ppuLog.Events()) {
+                    float x = origin.x + (e.scanline + e.dot / 341.0f) * 2.0f;
+                    float y = origin.y + e.kind * (height / 4.0f);
+                    draw->AddLine(ImVec2(x, y), ImVec2(x, y + height / 4.0f), timelineColors[e.kind]);
+                }
+                ImGui::Dummy(ImVec2(262 * 2.0f, height));
+                if (ImGui::IsItemHovered()) {
+                    int line = int((ImGui::GetIO().MousePos.x - origin.x) / 2.0f);
+                    size_t n = 0;
+                    for (const PPURegisterLog::Event& e : ppuLog.Events()) n += e.scanline == line;
+                    ImGui::SetTooltip("scanline %d: %zu events", line, n);
+                }
+                ImGui::InputText("##ppulogpath", ppuLogPath, sizeof(ppuLogPath));
+                ImGui::SameLine();
+                if (ImGui::Button("Export##ppulog")) ppuLog.Export(ppuLogPath);
+                if (ImGui::CollapsingHeader("Register events") && ImGui::BeginTable("ppuevents", 6)) {
+                    ImGui::TableSetupColumn("Scanline");
+                    ImGui::TableSetupColumn("Dot");
+                    ImGui::TableSetupColumn("Event");
+                    ImGui::TableSetupColumn("Target");
+                    ImGui::TableSetupColumn("Value");
+                    ImGui::TableSetupColumn("Repeat");
+                    ImGui::TableHeadersRow();
+                    for (const PPURegisterLog::Event& e : ppuLog.Events()) {
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%u", e.scanline);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%u", e.dot);
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(PPURegisterLog::KindName(e.kind));
+                        ImGui::TableNextColumn();
+                        if (e.kind == PPURegisterLog::MIRRORING) ImGui::TextUnformatted("-");
+                        else ImGui::Text("$%04X", e.kind == PPURegisterLog::CHR_BANK ? e.index * 0x400 : 0x2000 + e.index);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("$%02X", e.value);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%u", e.repeat);
+                    }
+                    ImGui::EndTable();
+                }
+            }
 
             // Debug info: registers, palette, OAM, VRAM head
             ImGui::Separator();
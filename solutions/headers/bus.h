@@ -13,6 +13,18 @@
 // $4018-$401F: APU and I/O functionality that is normally disabled
 // $4020-$FFFF: Cartridge space (PRG-ROM, PRG-RAM, mappers)
 
+// Optional per-access instrumentation (watchpoints, access counters, write
+// logs). Reads are reported after the access with the byte the CPU got,
+// writes before they land. Taps chain through Bus::AddTap/RemoveTap so
+// several tools can run at once; with none installed the normal path pays a
+// single null test.
+struct BusTap {
+    virtual ~BusTap() = default;
+    virtual void OnCPURead(uint16_t, uint8_t) {}
+    virtual void OnCPUWrite(uint16_t, uint8_t) {}
+    BusTap* nextTap = nullptr;
+};
+
 class Bus {
 public:
     static constexpr uint32_t RAM_SIZE = 0x0800; // 2KB
@@ -42,6 +54,22 @@ public:
     // Input / controller state
     class Input input;
 
+    // Dump CHR checksum/head/tail when a cartridge is loaded
+    bool verbose = false;
+
+    // Per-access instrumentation chain (nullptr unless a tool is running)
+    BusTap* tap = nullptr;
+    // Put t at the front of the chain (no-op when already installed)
+    void AddTap(BusTap* t);
+    void RemoveTap(BusTap* t);
+
+    // Content hash of the loaded cartridge (HashRomData over PRG+CHR, header excluded)
+    uint64_t romHash = 0;
+
+    // iNES mapper number of the cartridge when it has no implementation and
+    // runs on the naive mapping; -1 otherwise
+    int missingMapper = -1;
+
     // Cartridge mirroring (from iNES flags)
     bool mirrorVertical = false;
 
@@ -78,6 +106,8 @@ public:
 
     // Read a byte from the bus
     uint8_t read(uint16_t addr) ;
+    // Read without side effects (debuggers, tracing): PPU and I/O registers read as 0
+    uint8_t peek(uint16_t addr) const;
 
     // Write a byte to the bus
     void write(uint16_t addr, uint8_t value);
@@ -89,4 +119,7 @@ public:
     // Utility: clear cartridge data
     void UnloadCartridge() { prgRom.clear(); chrRom.clear(); }
 
+private:
+    // read() without the tap chain
+    uint8_t readMemory(uint16_t addr);
 };
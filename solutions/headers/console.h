@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "bus.h"
+#include "cpu.h"
+#include "ppu.h"
+#include "savestate.h"
+
+// One complete machine (bus, CPU, PPU) behind a small interface. Every host
+// builds on it: the GUI and the command-line modes, servers, batch tools,
+// tests and benchmarks. Everything here lives in the nescore library and has
+// no GL or windowing dependency.
+class Console {
+public:
+    static constexpr int WIDTH = 256;
+    static constexpr int HEIGHT = 240;
+
+    Console();
+    Console(const Console&) = delete;
+    Console& operator=(const Console&) = delete;
+
+    // Load an iNES cartridge and power on
+    bool LoadROM(const std::string& path);
+    void Reset();
+
+    // Run until the PPU completes the next frame. With render = false the
+    // frame is emulated but not drawn (the framebuffer keeps the last picture).
+    void RunFrame(bool render = true);
+    // Same, but the frame is rendered straight into pixels (WIDTH * HEIGHT)
+    // instead of the console's framebuffer
+    void RunFrame(uint32_t* pixels);
+    // Same, producing palette indices (WIDTH * HEIGHT bytes) and no RGBA at all
+    void RunFrameIndexed(uint8_t* indices);
+    // Last completed frame, WIDTH * HEIGHT RGBA pixels (black before the first frame)
+    const std::vector<uint32_t>& GetFramebuffer() const { return framebuffer; }
+
+    // Buttons as in Input::SetButtons (bit 0 = A ... bit 7 = Right)
+    void SetInput(int controller, uint8_t buttons) { bus.input.SetButtons(controller, buttons); }
+
+    void Snapshot(MachineState& out) const;
+    bool Restore(const MachineState& state);
+
+    uint64_t FrameCount() const { return ppu.frameCount; }
+
+    // Direct access for tools that need more than the facade
+    Bus bus;
+    CPU cpu;
+    PPU ppu;
+    u32 cycles = 0;
+
+private:
+    std::vector<uint32_t> framebuffer;
+};
@@ -2,13 +2,57 @@
 
 
 
+#include <array>
 #include "instructions.h"
 #include "bus.h"
+#include "debugger.h"
+#include "tracefile.h"
+
 
 using namespace Instructions;
 
-// Global verbose flag to enable CPU trace prints (default off)
-extern bool g_verboseCpu;
+// Compile-time instrumentation for CPU::ExecuteHooked. The plain Execute()
+// runs with these, and every hook call sits behind `if constexpr`, so it
+// compiles to the uninstrumented loop. A hooks type with enabled = true
+// (profiler.h, debugger.h, heatmap.h) gets:
+//   Paused() -> bool                           first, before DMA, interrupts
+//                                              or the instruction; true stops
+//                                              with nothing run
+//   BeforeInstruction(cpu, bus) -> bool        before each instruction; false
+//                                              stops without running it
+//   Instruction(cpu, bus, pc, opcode, cycles)  after each instruction
+//   Interrupt(cpu, bus, nmi, cycles)           after an NMI or IRQ is taken
+//   Stall(cycles)                              OAM DMA cycles
+struct NoExecuteHooks {
+    static constexpr bool enabled = false;
+};
+
+// Two enabled hooks types run together, e.g. the debugger's checks with a
+// profiler; either one can stop execution
+template <class First, class Second>
+struct ChainedHooks {
+    static constexpr bool enabled = true;
+
+    First& first;
+    Second& second;
+
+    bool Paused() const { return first.Paused() || second.Paused(); }
+    bool BeforeInstruction(const CPU& cpu, const Bus& bus) {
+        return first.BeforeInstruction(cpu, bus) && second.BeforeInstruction(cpu, bus);
+    }
+    void Instruction(const CPU& cpu, const Bus& bus, uint16_t pc, uint8_t opcode, u32 cycles) {
+        first.Instruction(cpu, bus, pc, opcode, cycles);
+        second.Instruction(cpu, bus, pc, opcode, cycles);
+    }
+    void Interrupt(const CPU& cpu, const Bus& bus, bool nmi, u32 cycles) {
+        first.Interrupt(cpu, bus, nmi, cycles);
+        second.Interrupt(cpu, bus, nmi, cycles);
+    }
+    void Stall(u32 cycles) {
+        first.Stall(cycles);
+        second.Stall(cycles);
+    }
+};
 
 struct CPU
 {
@@ -29,7 +73,8 @@ struct CPU
     uint8_t P = FLAG_U; // status register (bit 5 always 1)
 
     typedef void (*InstructionHandler)(CPU& cpu, u32& Cycles, Bus& bus);
-    static InstructionHandler instructionTable[256];
+    // Immutable, built at compile time (table.cpp); shared by every CPU instance
+    static const std::array<InstructionHandler, 256> instructionTable;
 
     bool Interrupt = false;
 
@@ -40,6 +85,13 @@ struct CPU
 
     // Tracing: when >0, CPU will print executed instructions and bus interactions for debugging
     int traceInstructionsRemaining = 0;
+    // When set, every instruction is passed to it (CaptureTrace) before it executes
+    TraceSink* traceSink = nullptr;
+    // Per-instance diagnostics (branch/compare trace prints)
+    bool verbose = false;
+    bool warnedUnknownOpcode = false;
+    Byte unknownOpcode = 0;     // first opcode without a handler, once warnedUnknownOpcode is set
+    Debugger debugger;
     void HandleNMI(u32& Cycles, Bus& bus);
 
     void printReg(char reg);
@@ -84,31 +136,59 @@ struct CPU
     InstructionHandler GetInstructionHandler(Byte opcode);
     void InvokeInstruction(Byte opcode, u32& Cycles, Bus& bus);
     void Execute(u32& Cycles, Bus& bus);
+    // Execute with instrumentation; instantiated in cpu.cpp for
+    // NoExecuteHooks, Profiler, DebugHooks, Heatmap and the chains
+    // RunFrameWith builds. Returns false when the hooks stopped it.
+    template <class Hooks> bool ExecuteHooked(u32& Cycles, Bus& bus, Hooks& hooks);
+    // Cycles the running instruction (or interrupt/DMA) has taken so far. The
+    // PPU only catches up once it finishes, so a register access sees the PPU
+    // this many CPU cycles behind. 0 outside ExecuteHooked.
+    u32 CyclesIntoInstruction() const { return instructionCycles ? *instructionCycles - instructionStart : 0; }
+    const u32* instructionCycles = nullptr;
+    u32 instructionStart = 0;
+    // Run whole instructions until the PPU completes the current frame (or
+    // the debugger pauses). render = false emulates the frame without
+    // drawing it (PPU::drawFrame). Execute and RunFrame switch to the
+    // DebugHooks loop only while debugger.Active().
+    void RunFrame(u32& Cycles, Bus& bus, bool render = true);
+    template <class Hooks> void RunFrameHooked(u32& Cycles, Bus& bus, Hooks& hooks, bool render = true);
+    // RunFrameHooked for tools (Profiler, Heatmap) that also honours the
+    // debugger: while debugger.Active() the hooks run chained behind DebugHooks
+    template <class Hooks> void RunFrameWith(u32& Cycles, Bus& bus, Hooks& hooks, bool render = true);
+    static constexpr u32 CYCLES_PER_FRAME = 29780; // NTSC, used when no PPU is attached
     void IRQ_Handler(u32& Cycles, Bus& bus, bool Interrupt);
-    struct CPUTrace {
-    uint16_t pc;
-    uint8_t opcode;
-    uint8_t op1;
-    uint8_t op2;
-    uint8_t A;
-    uint8_t X;
-    uint8_t Y;
-    uint8_t P;
-    uint8_t SP;
-    uint64_t cycles;
-
-    };
-    CPUTrace CaptureTrace(Bus& bus) const {
-    CPUTrace t;
-    t.pc = PC;
-    t.opcode = bus.read(PC);
-    t.op1 = bus.read(PC + 1);
-    t.op2 = bus.read(PC + 2);
-    t.A = A;
-    t.X = X;
-    t.Y = Y;
-    t.P = P;
-    t.SP = SP;
-    return t;
-}
+    // Bytes taken by the instruction starting with opcode (official and
+    // unofficial encodings; BRK counts as 1 like in nestest logs)
+    static constexpr uint8_t InstructionLength(Byte opcode) {
+        uint8_t mode = (opcode >> 2) & 7;
+        switch (opcode & 3) {
+        case 0:
+            if (mode == 0) return opcode == 0x20 ? 3 : (opcode >= 0x80 ? 2 : 1);
+            return mode == 2 || mode == 6 ? 1 : (mode == 3 || mode == 7 ? 3 : 2);
+        case 2:
+            if (mode == 0) return 2;
+            return mode == 2 || mode == 4 || mode == 6 ? 1 : (mode == 3 || mode == 7 ? 3 : 2);
+        default:
+            return mode == 3 || mode == 6 || mode == 7 ? 3 : 2;
+        }
+    }
+
+    // Trace record for the instruction at PC, read without bus side effects
+    using CPUTrace = TraceRecord;
+    CPUTrace CaptureTrace(const Bus& bus, u32 cycles) const {
+        CPUTrace t;
+        t.cycles = cycles;
+        t.pc = PC;
+        t.bytes[0] = bus.peek(PC);
+        t.length = InstructionLength(t.bytes[0]);
+        t.bytes[1] = t.length > 1 ? bus.peek(static_cast<uint16_t>(PC + 1)) : 0;
+        t.bytes[2] = t.length > 2 ? bus.peek(static_cast<uint16_t>(PC + 2)) : 0;
+        t.a = A;
+        t.x = X;
+        t.y = Y;
+        t.p = P;
+        t.sp = SP;
+        t.flags = TraceRecord::FLAG_CYCLES;
+        return t;
+    }
 };
\ No newline at end of file
@@ -1,17 +1,113 @@
 #pragma once
-#include <unordered_set>
+#include <array>
 #include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "bus.h"
+#include "types.h"
 
-struct Debugger {
-    bool enabled = false;
-    bool stepMode = false;
-    bool pause = false;
+struct CPU;
 
-    std::unordered_set<uint16_t> breakpoints;
+// Optional test on a breakpoint: "<source> <op> <number>", e.g. "a == $10",
+// "value & $80" or "sp < 0x20". value is the byte read or written (the
+// opcode for execute breakpoints, the byte at the VRAM address for $2007).
+struct BreakCondition {
+    enum Source : uint8_t { A, X, Y, SP, P, Value };
+    enum Op : uint8_t { Equal, NotEqual, Less, Greater, LessEqual, GreaterEqual, BitsSet };
 
-    void CheckBreakpoint(uint16_t pc) {
-        if (breakpoints.count(pc)) {
-            pause = true;
-        }
-    }
-};
\ No newline at end of file
+    Source source = Value;
+    Op op = Equal;
+    uint8_t operand = 0;
+
+    static bool Parse(const std::string& text, BreakCondition& out);
+    std::string ToString() const;
+    bool Test(uint8_t lhs) const;
+};
+
+// Execute/read/write breakpoints on the CPU address space and read/write
+// watchpoints on PPU addresses reached through $2007, each kind a 64K-entry
+// bitmap so a check is one bit test. The CPU only runs its checking loop
+// (DebugHooks) while Active(); otherwise Execute/RunFrame take the plain
+// path and the debugger is not on the bus tap chain.
+struct Debugger : BusTap {
+    enum Kind : uint8_t { EXECUTE, READ, WRITE, PPU_READ, PPU_WRITE, KIND_COUNT };
+
+    struct Breakpoint {
+        Kind kind;
+        uint16_t addr;
+        bool conditional;
+        BreakCondition condition;
+    };
+
+    struct Hit {
+        Kind kind;
+        uint16_t addr;      // CPU address, or PPU address for the PPU kinds
+        uint8_t value;
+        uint16_t pc;        // instruction that hit (execute: the one about to run)
+    };
+
+    bool enabled = true;    // master switch for all breakpoints
+    bool pause = false;     // set by a hit; execution stops before the next instruction
+
+    void Add(Kind kind, uint16_t addr, const BreakCondition* condition = nullptr);
+    void Remove(Kind kind, uint16_t addr);
+    void Clear();
+    bool Has(Kind kind, uint16_t addr) const { return (bits[kind][addr >> 6] >> (addr & 63)) & 1; }
+    std::vector<Breakpoint> List() const;
+    size_t Count() const { return count; }
+
+    // True when the CPU has to run the checking loop
+    bool Active() const { return pause || (enabled && count > 0); }
+    // Continue after a hit; the execute breakpoint at pc does not fire again
+    // until another instruction has run
+    void Resume(uint16_t pc);
+
+    const Hit& LastHit() const { return lastHit; }
+    uint64_t Hits() const { return hits; }
+
+    // Join the bus tap chain for the checking loop, until Detach()
+    void Attach(const CPU& cpu, Bus& bus);
+    void Detach();
+
+    // CPU side (DebugHooks): false stops before the instruction at cpu.PC
+    bool BeforeInstruction(const CPU& cpu, const Bus& bus);
+
+    // Bus side while the checking loop runs: reads after the access, with
+    // the byte returned; writes before
+    void OnCPURead(uint16_t addr, uint8_t value) override;
+    void OnCPUWrite(uint16_t addr, uint8_t value) override;
+
+private:
+    static constexpr size_t WORDS = 0x10000 / 64;
+
+    bool Check(Kind kind, uint16_t addr, uint8_t value);
+    void CheckPPU(Kind kind, uint8_t value);
+
+    std::array<std::array<uint64_t, WORDS>, KIND_COUNT> bits{};
+    std::unordered_map<uint32_t, BreakCondition> conditions;   // kind << 16 | addr
+    size_t count = 0;
+
+    const CPU* cpu = nullptr;
+    Bus* bus = nullptr;
+    uint16_t fetchStart = 0;    // bytes of the running instruction: fetches are not data reads
+    uint8_t fetchLength = 0;
+    bool skipOnce = false;
+    uint16_t skipPc = 0;
+
+    Hit lastHit{};
+    uint64_t hits = 0;
+};
+
+// ExecuteHooked hooks that consult the debugger before each instruction
+struct DebugHooks {
+    static constexpr bool enabled = true;
+
+    Debugger& debugger;
+
+    bool Paused() const { return debugger.pause; }
+    bool BeforeInstruction(const CPU& cpu, const Bus& bus) { return debugger.BeforeInstruction(cpu, bus); }
+    void Instruction(const CPU&, const Bus&, uint16_t, uint8_t, u32) {}
+    void Interrupt(const CPU&, const Bus&, bool, u32) {}
+    void Stall(u32) {}
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Byte codecs for state history: XOR deltas plus a zero-run-length encoding
+// tuned for them (a delta between neighbouring frames is mostly zeros).
+//
+// Encoded stream: repeated [zero run varint][literal count varint][literals].
+
+// out[i] = a[i] ^ b[i]
+void XorBytes(const uint8_t* a, const uint8_t* b, uint8_t* out, size_t n);
+
+// Append the encoding of in[0..n) to out. Returns the number of bytes appended.
+size_t ZeroRleEncode(const uint8_t* in, size_t n, std::vector<uint8_t>& out);
+
+// Decode exactly n bytes into out. Returns false on malformed/short input.
+bool ZeroRleDecode(const uint8_t* in, size_t len, uint8_t* out, size_t n);
+
+// Decode and XOR into out (out[i] ^= decoded[i]); skips zero runs entirely,
+// so applying a sparse delta costs only its literal bytes.
+bool ZeroRleDecodeXor(const uint8_t* in, size_t len, uint8_t* out, size_t n);
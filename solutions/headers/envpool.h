@@ -0,0 +1,105 @@
+#pragma once
+#include <stdint.h>
+
+// Batched environments for reinforcement learning: N consoles running the same
+// cartridge, stepped together on a work-stealing thread pool. Plain C ABI so
+// it can be loaded from Python with ctypes:
+//
+//   lib = ctypes.CDLL("libnesenv.so")
+//   pool = lib.nes_env_create(b"mario.nes", 64, 0, 4)
+//   obs = numpy.empty((64, 240, 256), numpy.uint32)   # RGBA, see NES_ENV_*
+//   ram = numpy.empty((64, 2048), numpy.uint8)
+//   done = numpy.empty(64, numpy.uint8)
+//   lib.nes_env_step(pool, actions.ctypes.data, obs.ctypes.data, ram.ctypes.data, done.ctypes.data)
+//
+// Observations are rendered by the PPU directly into the caller's array and
+// RAM is copied straight into it; nothing is buffered in between.
+
+#if defined(_WIN32)
+#define NES_ENV_API __declspec(dllexport)
+#else
+#define NES_ENV_API __attribute__((visibility("default")))
+#endif
+
+#define NES_ENV_WIDTH 256
+#define NES_ENV_HEIGHT 240
+#define NES_ENV_OBS_PIXELS (NES_ENV_WIDTH * NES_ENV_HEIGHT)
+#define NES_ENV_RAM_BYTES 2048
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct NesEnvPool NesEnvPool;
+
+// Processed observations (see ObservationConfig): crop, grayscale, resize,
+// max-pool of the last two frames and frame stacking, computed from palette
+// indices without producing RGBA frames
+typedef struct NesEnvObservation {
+    int cropTop, cropBottom, cropLeft, cropRight;
+    int width, height;
+    int area;       // 1 = box filter, 0 = nearest
+    int maxPool;
+    int stack;
+} NesEnvObservation;
+
+// count consoles on threads workers (0 = one per hardware thread, pinned to
+// cores). Each step runs frameSkip frames with the action held. NULL on failure.
+NES_ENV_API NesEnvPool* nes_env_create(const char* romPath, int count, int threads, int frameSkip);
+NES_ENV_API void nes_env_destroy(NesEnvPool* pool);
+NES_ENV_API int nes_env_count(const NesEnvPool* pool);
+
+// Episode end conditions, checked after every step: a frame limit (0 = none)
+// and/or RAM[addr] == value (addr < 0 disables). set_done_ram returns -1 and
+// keeps the old condition for an address outside $0000-$07FF.
+NES_ENV_API void nes_env_set_max_frames(NesEnvPool* pool, uint32_t frames);
+NES_ENV_API int nes_env_set_done_ram(NesEnvPool* pool, int addr, int value);
+
+// Restart every console at the power-on state. obs/ram may be NULL.
+NES_ENV_API int nes_env_reset(NesEnvPool* pool, uint32_t* obs, uint8_t* ram);
+
+// actions[i] is controller 1 for console i (bit 0 = A ... bit 7 = Right).
+// Writes obs[count * NES_ENV_OBS_PIXELS], ram[count * NES_ENV_RAM_BYTES] and
+// done[count]; any of them may be NULL. A console whose episode ended reports
+// its final frame with done = 1 and starts over on the next step.
+NES_ENV_API int nes_env_step(NesEnvPool* pool, const uint8_t* actions, uint32_t* obs, uint8_t* ram, uint8_t* done);
+
+// Switch the pool to processed observations. Returns the bytes per console
+// written by the *_processed calls, or -1 if the configuration is invalid.
+NES_ENV_API int nes_env_set_observation(NesEnvPool* pool, const NesEnvObservation* config);
+NES_ENV_API int nes_env_reset_processed(NesEnvPool* pool, uint8_t* obs, uint8_t* ram);
+NES_ENV_API int nes_env_step_processed(NesEnvPool* pool, const uint8_t* actions, uint8_t* obs, uint8_t* ram, uint8_t* done);
+
+// RAM search (cheat-search filtering, see RamSearch) on the pool's consoles:
+// capture snapshots between steps, then filter to the addresses that behaved
+// as expected. slot < 0 applies reset/capture/filter to every console.
+//
+//   lib.nes_env_ramsearch_capture(pool, -1)
+//   lib.nes_env_step(pool, ...)
+//   lib.nes_env_ramsearch_capture(pool, -1)
+//   q = NesEnvRamQuery(op=5, vsPrevious=1)             # increased or equal
+//   lib.nes_env_ramsearch_filter(pool, 0, ctypes.byref(q))
+typedef struct NesEnvRamQuery {
+    int op;             // 0 ==, 1 !=, 2 <, 3 >, 4 <=, 5 >=, 6 in [value, high], 7 changed by value
+    int vsPrevious;     // compare with the previous snapshot instead of value
+    int value, high;
+    int word;           // 16-bit values starting at each address
+    int bigEndian;
+} NesEnvRamQuery;
+
+// Drop snapshots and make every address a candidate again ($0000-$07FF,
+// plus PRG-RAM $6000-$7FFF when includePrgRam)
+NES_ENV_API int nes_env_ramsearch_reset(NesEnvPool* pool, int slot, int includePrgRam);
+NES_ENV_API int nes_env_ramsearch_capture(NesEnvPool* pool, int slot);
+// Filter the latest snapshot against the previous one (or query->value).
+// Returns the candidates left (summed over consoles for slot < 0), -1 on error.
+NES_ENV_API int nes_env_ramsearch_filter(NesEnvPool* pool, int slot, const NesEnvRamQuery* query);
+// Up to max candidates of one console in address order: addrs[] gets the CPU
+// address, values[] (may be NULL) the value in the latest snapshot. Returns
+// how many were written, -1 on error.
+NES_ENV_API int nes_env_ramsearch_candidates(NesEnvPool* pool, int slot, int word, int bigEndian,
+                                             uint16_t* addrs, uint16_t* values, int max);
+
+#ifdef __cplusplus
+}
+#endif
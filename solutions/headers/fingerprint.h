@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "savestate.h"
+
+struct CPU;
+class Bus;
+
+struct Hash128 {
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+
+    bool operator==(const Hash128& o) const { return lo == o.lo && hi == o.hi; }
+    bool operator!=(const Hash128& o) const { return !(*this == o); }
+};
+
+// 128-bit non-cryptographic hash over bytes. Eight 64-bit accumulators take
+// 64-byte stripes (SSE2 when available, identical scalar code otherwise), so
+// hashing runs at memory speed for large blocks such as frame images.
+Hash128 HashBytes128(const void* data, size_t len, uint64_t seed = 0);
+
+// Stripe loop of HashBytes128: folds stripes 64-byte stripes at p into the
+// eight accumulators, scrambling them after every 16. SSE2 when the build has
+// it; the scalar version is the fallback and the parity test's reference.
+namespace FingerprintDetail {
+void AccumulateStripes(uint64_t* acc, const uint8_t* p, size_t stripes);
+void AccumulateStripesScalar(uint64_t* acc, const uint8_t* p, size_t stripes);
+}
+
+// Hash of a video frame (e.g. the pixels returned by PPU::PopFrame)
+inline Hash128 HashFrame(const uint32_t* pixels, size_t count) {
+    return HashBytes128(pixels, count * sizeof(uint32_t));
+}
+
+// Per-frame fingerprint of the whole machine (CPU, RAM, PPU, mapper). The
+// MachineState image is hashed in 256-byte pages; on each update only pages
+// whose bytes differ from the previous update are rehashed, and the page
+// hashes are folded into the final value. A typical frame touches a handful
+// of pages, so an update costs about one snapshot plus a 20KB compare.
+class StateFingerprint {
+public:
+    static constexpr size_t PAGE_SIZE = 256;
+    static constexpr size_t PAGE_COUNT = (sizeof(MachineState) + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    // Leave the CPU cycle counter and PPU frame counter out of the hash, so
+    // states that differ only in elapsed time compare equal (search dedup)
+    bool excludeCounters = false;
+
+    Hash128 Update(const CPU& cpu, const Bus& bus, u32 cycles);
+    Hash128 Update(const MachineState& state);
+
+    Hash128 Value() const { return value; }
+    size_t PagesRehashed() const { return rehashed; }
+    // Force a full rehash on the next update
+    void Invalidate() { valid = false; }
+
+private:
+    Hash128 Commit();
+
+    MachineState states[2] = {};    // latest update and the one being compared against it
+    int latest = 0;
+    uint64_t pageHash[PAGE_COUNT] = {0};
+    bool valid = false;
+    Hash128 value;
+    size_t rehashed = 0;
+};
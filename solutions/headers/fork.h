@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include "savestate.h"
+
+struct CPU;
+class Bus;
+
+// Copy-on-write machine state for tree search. The MachineState image is cut
+// into 256-byte pages held by immutable, reference-counted blocks; a fork
+// shares its parent's page table (one refcount increment) and a page is only
+// copied when the child's run actually changed it. Pages are never mutated
+// after creation, so states can be handed between threads freely.
+class ForkedState {
+public:
+    static constexpr size_t PAGE_SIZE = 256;
+    static constexpr size_t PAGE_COUNT = (sizeof(MachineState) + PAGE_SIZE - 1) / PAGE_SIZE;
+    using Page = std::array<uint8_t, PAGE_SIZE>;
+
+    ForkedState() = default;
+    explicit ForkedState(const MachineState& state);
+
+    // Child state sharing every page (and the page table) with this one
+    ForkedState Fork() const { return *this; }
+
+    bool Empty() const { return table == nullptr; }
+    void Materialize(MachineState& out) const;
+
+    // Number of pages this state does not share with other
+    size_t DistinctPages(const ForkedState& other) const;
+
+private:
+    friend class ForkRunner;
+    using PageTable = std::array<std::shared_ptr<const Page>, PAGE_COUNT>;
+
+    // Rebuild from a flat state, reusing base's pages wherever the bytes match
+    void Commit(const MachineState& state, const ForkedState* base, size_t* copiedPages);
+    const uint8_t* PageData(size_t i) const { return (*table)[i]->data(); }
+
+    std::shared_ptr<const PageTable> table;
+};
+
+// Runs forked states on one live machine (one runner per thread; the ROM is
+// loaded once into that machine and never copied per fork). Load() only
+// copies pages that differ from what the machine last held.
+class ForkRunner {
+public:
+    ForkRunner(CPU& cpu, Bus& bus) : cpu(cpu), bus(bus) {}
+
+    // Put the machine into state s. Returns false if the state does not fit the cartridge.
+    bool Load(const ForkedState& s);
+
+    // Capture the machine as a child of parent (normally the state passed to Load)
+    ForkedState Capture(const ForkedState& parent);
+
+    u32& Cycles() { return cycles; }
+    size_t PagesCopiedLastCapture() const { return lastCopied; }
+
+private:
+    CPU& cpu;
+    Bus& bus;
+    u32 cycles = 0;
+    MachineState scratch{};
+    ForkedState resident;   // what scratch currently mirrors
+    size_t lastCopied = 0;
+};
@@ -579,7 +579,7 @@ Byte Address = Byte(zp + cpu.X); // force wrap
         cpu.SetFlag(CPU::FLAG_C, cpu.A >= Value);
         cpu.SetZN(Temp);
         Cycles += 0;
-        if (g_verboseCpu) {
+        if (cpu.verbose) {
             printf("CMP: A = 0x%02X, Value = 0x%02X, Z = %d, C = %d, N = %d\n",
                 cpu.A, Value,
                 cpu.GetFlag(CPU::FLAG_Z),
@@ -594,7 +594,7 @@ Byte Address = Byte(zp + cpu.X); // force wrap
         cpu.SetFlag(CPU::FLAG_C, cpu.A >= Value);
         cpu.SetZN(Temp);
         Cycles += 1;
-        if (g_verboseCpu) {
+        if (cpu.verbose) {
             printf("CMP: A = 0x%02X, Value = 0x%02X, Z = %d, C = %d, N = %d\n",
                 cpu.A, Value,
                 cpu.GetFlag(CPU::FLAG_Z),
@@ -611,7 +611,7 @@ Byte Address = Byte(zp + cpu.X); // force wrap
         cpu.SetFlag(CPU::FLAG_C, cpu.A >= Value);
         cpu.SetZN(Temp);
         Cycles += 2;
-        if (g_verboseCpu) {
+        if (cpu.verbose) {
             printf("CMP: A = 0x%02X, Value = 0x%02X, Z = %d, C = %d, N = %d\n",
                 cpu.A, Value,
                 cpu.GetFlag(CPU::FLAG_Z),
@@ -626,7 +626,7 @@ Byte Address = Byte(zp + cpu.X); // force wrap
         cpu.SetFlag(CPU::FLAG_C, cpu.A >= Value);
         cpu.SetZN(Temp);
         Cycles += 1;
-        if (g_verboseCpu) {
+        if (cpu.verbose) {
             printf("CMP: A = 0x%02X, Value = 0x%02X, Z = %d, C = %d, N = %d\n",
                 cpu.A, Value,
                 cpu.GetFlag(CPU::FLAG_Z),
@@ -643,7 +643,7 @@ Byte Address = Byte(zp + cpu.X); // force wrap
         cpu.SetFlag(CPU::FLAG_C, cpu.A >= Value);
         cpu.SetZN(Temp);
         Cycles += 1 + (pageCrossed ? 1 : 0);
-        if (g_verboseCpu) {
+        if (cpu.verbose) {
             printf("CMP: A = 0x%02X, Value = 0x%02X, Z = %d, C = %d, N = %d\n",
                 cpu.A, Value,
                 cpu.GetFlag(CPU::FLAG_Z),
@@ -660,7 +660,7 @@ Byte Address = Byte(zp + cpu.X); // force wrap
         cpu.SetFlag(CPU::FLAG_C, cpu.A >= Value);
         cpu.SetZN(Temp);
         Cycles += 1 + (pageCrossed ? 1 : 0);
-        if (g_verboseCpu) {
+        if (cpu.verbose) {
             printf("CMP: A = 0x%02X, Value = 0x%02X, Z = %d, C = %d, N = %d\n",
                 cpu.A, Value,
                 cpu.GetFlag(CPU::FLAG_Z),
@@ -675,7 +675,7 @@ Byte Address = Byte(zp + cpu.X); // force wrap
         cpu.SetFlag(CPU::FLAG_C, cpu.A >= Value);
         cpu.SetZN(Temp);
         Cycles += 0;
-        if (g_verboseCpu) {
+        if (cpu.verbose) {
             printf("CMP: A = 0x%02X, Value = 0x%02X, Z = %d, C = %d, N = %d\n",
                 cpu.A, Value,
                 cpu.GetFlag(CPU::FLAG_Z),
@@ -690,7 +690,7 @@ Byte Address = Byte(zp + cpu.X); // force wrap
         cpu.SetFlag(CPU::FLAG_C, cpu.A >= Value);
         cpu.SetZN(Temp);
         Cycles += 0;
-        if (g_verboseCpu) {
+        if (cpu.verbose) {
             printf("CMP: A = 0x%02X, Value = 0x%02X, Z = %d, C = %d, N = %d\n",
                 cpu.A, Value,
                 cpu.GetFlag(CPU::FLAG_Z),
@@ -1,7 +1,6 @@
 #pragma once
 
-#include "cpu.h"
-#include "bus.h"
+#include "console.h"
 
-// Simple GUI entrypoint
-void RunGUI(CPU& cpu, Bus& bus);
+// Simple GUI entrypoint; drives the console's bus, CPU and PPU
+void RunGUI(Console& console);
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// Fast non-cryptographic 64-bit hash (xxHash64-style: four independent lanes
+// over 32-byte blocks so the multiplies pipeline, then a shared avalanche).
+// Used for ROM identification and machine state fingerprints.
+
+namespace HashDetail {
+constexpr uint64_t P1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t P3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t P5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t Rotl(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+
+inline uint64_t Read64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t Read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t Round(uint64_t acc, uint64_t input) {
+    acc += input * P2;
+    acc = Rotl(acc, 31);
+    return acc * P1;
+}
+
+inline uint64_t Merge(uint64_t acc, uint64_t lane) {
+    acc ^= Round(0, lane);
+    return acc * P1 + P4;
+}
+
+inline uint64_t Avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+}
+
+inline uint64_t Hash64(const void* data, size_t len, uint64_t seed = 0) {
+    using namespace HashDetail;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        uint64_t v1 = seed + P1 + P2;
+        uint64_t v2 = seed + P2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - P1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = Round(v1, Read64(p));
+            v2 = Round(v2, Read64(p + 8));
+            v3 = Round(v3, Read64(p + 16));
+            v4 = Round(v4, Read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = Rotl(v1, 1) + Rotl(v2, 7) + Rotl(v3, 12) + Rotl(v4, 18);
+        h = Merge(h, v1);
+        h = Merge(h, v2);
+        h = Merge(h, v3);
+        h = Merge(h, v4);
+    } else {
+        h = seed + P5;
+    }
+
+    h += static_cast<uint64_t>(len);
+    while (p + 8 <= end) {
+        h ^= Round(0, Read64(p));
+        h = Rotl(h, 27) * P1 + P4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= uint64_t(Read32(p)) * P1;
+        h = Rotl(h, 23) * P2 + P3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * P5;
+        h = Rotl(h, 11) * P1;
+        ++p;
+    }
+    return Avalanche(h);
+}
+
+// Hash of a cartridge image as used by the ROM index and save states:
+// PRG data followed by CHR data, header and trainer excluded.
+inline uint64_t HashRomData(const uint8_t* prg, size_t prgLen, const uint8_t* chr, size_t chrLen) {
+    uint64_t h = Hash64(prg, prgLen, 0);
+    return Hash64(chr, chrLen, h);
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include "bus.h"
+#include "ppu.h"
+#include "types.h"
+
+struct CPU;
+
+// Memory access counters. CPU side: every bus read (instruction fetches
+// included) and write, and every instruction start (execute), per address.
+// PPU side: reads and writes per PPU address, so CHR ($0000-$1FFF),
+// nametable VRAM ($2000-$2FFF) and palette ($3F00-$3F1F) traffic are kept
+// apart. Instruments through the bus tap chain, PPU::tap and as an
+// ExecuteHooked hooks type; none of it runs unless attached.
+//
+// Each EndFrame() folds the frame's accesses into page heatmaps (256-byte
+// pages: 256 CPU pages x read/write/execute, 64 PPU pages x read/write),
+// kept for the last HISTORY frames.
+class Heatmap : public BusTap, public PPUTap {
+public:
+    static constexpr bool enabled = true;
+    static constexpr size_t HISTORY = 600;
+    static constexpr size_t CPU_PAGES = 256;
+    static constexpr size_t PPU_PAGES = 64;
+
+    enum CpuAccess { CPU_READ, CPU_WRITE, CPU_EXECUTE, CPU_ACCESS_COUNT };
+    enum PpuAccess { PPU_READ, PPU_WRITE, PPU_ACCESS_COUNT };
+
+    struct FramePages {
+        uint64_t frame;
+        uint32_t cpu[CPU_ACCESS_COUNT][CPU_PAGES];
+        uint32_t ppu[PPU_ACCESS_COUNT][PPU_PAGES];
+    };
+
+    Heatmap();
+
+    // Join the bus tap chain and take ppu.tap until Detach(); run the CPU with
+    // RunFrameHooked(cycles, bus, heatmap) to count execution too
+    void Attach(Bus& bus, PPU& ppu);
+    void Detach();
+    void Reset();
+    // Close the current frame's page heatmap
+    void EndFrame(uint64_t frame);
+
+    // ExecuteHooked hooks
+    bool Paused() const { return false; }
+    bool BeforeInstruction(const CPU&, const Bus&) { return true; }
+    void Instruction(const CPU&, const Bus&, uint16_t pc, uint8_t, u32) { Count(CPU_EXECUTE, pc); }
+    void Interrupt(const CPU&, const Bus&, bool, u32) {}
+    void Stall(u32) {}
+
+    void OnCPURead(uint16_t addr, uint8_t) override { Count(CPU_READ, addr); }
+    void OnCPUWrite(uint16_t addr, uint8_t) override { Count(CPU_WRITE, addr); }
+    void OnPPURead(uint16_t addr) override { CountPPU(PPU_READ, addr); }
+    void OnPPUWrite(uint16_t addr) override { CountPPU(PPU_WRITE, addr); }
+
+    // Totals since Reset()
+    uint64_t Cpu(CpuAccess a, uint16_t addr) const { return cpuCounts[a][addr]; }
+    uint64_t Ppu(PpuAccess a, uint16_t addr) const { return ppuCounts[a][addr & 0x3FFF]; }
+    // Completed frames, oldest first (up to HISTORY)
+    const std::deque<FramePages>& History() const { return history; }
+
+    // Binary dump: HeatmapFileHeader, per-address totals (u64, CPU
+    // read/write/execute x 64K, then PPU read/write x 16K), then the frame
+    // history as FramePages records
+    bool Export(const std::string& path) const;
+
+private:
+    void Count(CpuAccess a, uint16_t addr) {
+        ++cpuCounts[a][addr];
+        ++current.cpu[a][addr >> 8];
+    }
+    void CountPPU(PpuAccess a, uint16_t addr) {
+        addr &= 0x3FFF;
+        ++ppuCounts[a][addr];
+        ++current.ppu[a][addr >> 8];
+    }
+
+    std::vector<uint64_t> cpuCounts[CPU_ACCESS_COUNT];
+    std::vector<uint64_t> ppuCounts[PPU_ACCESS_COUNT];
+    FramePages current{};
+    std::deque<FramePages> history;
+
+    Bus* bus = nullptr;
+    PPU* ppu = nullptr;
+    PPUTap* previousPpuTap = nullptr;
+};
+
+struct HeatmapFileHeader {
+    static constexpr char MAGIC[8] = {'N', 'E', 'S', 'H', 'E', 'A', 'T', '1'};
+
+    char magic[8];
+    uint32_t cpuAddresses;      // 65536
+    uint32_t ppuAddresses;      // 16384
+    uint32_t frameRecordSize;   // sizeof(Heatmap::FramePages)
+    uint32_t frames;            // records in the history
+};
+static_assert(sizeof(HeatmapFileHeader) == 24, "heatmap file header layout is fixed");
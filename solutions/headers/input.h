@@ -1,7 +1,7 @@
 // Basic NES controller input handling
 #pragma once
 #include <cstdint>
-struct GLFWwindow;
+struct InputState;
 
 class Input {
 public:
@@ -31,8 +31,9 @@ public:
     // Read next bit from controller 0 or 1 (0x4016 / 0x4017)
     uint8_t Read(int controller) ;
 
-    // Poll keyboard via GLFW and update internal current state
-    void PollFromGLFW(GLFWwindow* window);
+    // Save-state support
+    void SaveState(InputState& out) const;
+    void LoadState(const InputState& in);
 
 private:
     uint8_t currState[2];    // current live button state bits
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Read-only file mapping. Uses mmap on POSIX; elsewhere falls back to a
+// single bulk read into memory so callers see the same interface.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    const uint8_t* Data() const { return data; }
+    size_t Size() const { return size; }
+    bool IsOpen() const { return opened; }
+
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    bool opened = false;
+    bool mapped = false;
+    std::vector<uint8_t> fallback;
+};
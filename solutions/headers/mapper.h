@@ -4,6 +4,7 @@
 #include <string>
 
 class Bus;
+struct MapperState;
 enum class Mirroring {
     Horizontal,
     Vertical,
@@ -17,6 +18,10 @@ public:
 
     Bus* bus = nullptr;
     Mirroring mirroring = Mirroring::Horizontal;
+    int number = 0; // iNES mapper number
+    // Per-instance diagnostics: register/bank writes and IRQ activity
+    bool verbose = false;
+    bool irqLog = false;
     virtual ~Mapper() {}
     virtual uint8_t CPURead(uint16_t addr) = 0;
     virtual void CPUWrite(uint16_t addr, uint8_t value) = 0;
@@ -24,11 +29,21 @@ public:
     virtual void CHRWrite(uint16_t addr, uint8_t value) = 0;
     // Called when the PPU accesses an address in $0000-$1FFF; used for MMC3 A12 detection
     virtual void OnPPUAddr(uint16_t addr, uint32_t cycles) {}
+    // True when OnPPUAddr has side effects, so pattern fetches must be replayed
+    // even for frames that are not drawn
+    virtual bool WantsPPUAddr() const { return false; }
+    // 8KB PRG ROM bank currently mapped at addr ($8000-$FFFF), -1 elsewhere
+    virtual int PRGBank(uint16_t) const { return -1; }
+    // 1KB CHR bank selected for addr ($0000-$1FFF), -1 when not banked
+    virtual int CHRBank(uint16_t) const { return -1; }
     // Debug helper: return a concise status string for mapper internals
     virtual std::string DebugString() const { return std::string(); }
     virtual Mirroring GetMirroring() const {
         return mirroring;
     }
+    // Save-state support: the base version only covers mirroring
+    virtual void SaveState(MapperState& out) const;
+    virtual void LoadState(const MapperState& in);
 };
 
 // Factory helper
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "savestate.h"
+
+struct CPU;
+class Bus;
+
+// Input movie: the button bytes of both controllers for every frame, played
+// back from either power-on or an embedded start snapshot.
+//
+// File layout: 32-byte header, zero-RLE encoded MachineState (only when
+// FLAG_FROM_SNAPSHOT), then frameCount * 2 bytes (controller 0, controller 1).
+struct MovieHeader {
+    static constexpr char MAGIC[8] = {'N', 'E', 'S', 'M', 'O', 'V', 'I', 'E'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t FLAG_FROM_SNAPSHOT = 0x1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t romHash;       // 0 when unknown (e.g. imported movies)
+    uint32_t frameCount;
+    uint32_t startSize;     // encoded snapshot bytes following the header
+};
+static_assert(sizeof(MovieHeader) == 32, "movie header layout is fixed");
+
+class Movie {
+public:
+    uint64_t romHash = 0;
+    bool fromSnapshot = false;
+    MachineState start{};
+
+    void Clear();
+    size_t Frames() const { return inputs.size() / 2; }
+    void AddFrame(uint8_t pad0, uint8_t pad1);
+    void Truncate(size_t frames) { if (frames < Frames()) inputs.resize(frames * 2); }
+    uint8_t Pad(size_t frame, int controller) const { return inputs[frame * 2 + (controller ? 1 : 0)]; }
+
+    // Begin recording at the machine's current state
+    void StartRecording(const CPU& cpu, const Bus& bus, u32 cycles);
+    // Append the controller state the frame about to run will see
+    void RecordFrame(const Bus& bus);
+
+    // Put the machine at the movie start. Power-on movies expect a freshly
+    // loaded cartridge; snapshot movies restore their embedded state.
+    bool StartPlayback(CPU& cpu, Bus& bus, u32& cycles) const;
+    // Latch the recorded buttons for frame f into both controllers
+    void ApplyFrame(size_t frame, Bus& bus) const;
+
+    bool Save(const std::string& path) const;
+    bool Load(const std::string& path);
+    // FCEUX text movie (.fm2). Only standard gamepads are read.
+    bool ImportFM2(const std::string& path);
+
+private:
+    std::vector<uint8_t> inputs;
+};
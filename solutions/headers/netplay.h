@@ -0,0 +1,102 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include "savestate.h"
+
+struct CPU;
+class Bus;
+
+// Minimal non-blocking UDP endpoint with a single fixed peer
+class UdpSocket {
+public:
+    UdpSocket() = default;
+    ~UdpSocket();
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    bool Bind(uint16_t port);
+    bool SetPeer(const std::string& host, uint16_t port);
+    bool Send(const void* data, size_t len);
+    // Returns the datagram size, or -1 when nothing is pending
+    int Receive(void* buf, size_t cap);
+
+private:
+    intptr_t fd = -1;
+    uint8_t peer[128] = {0}; // sockaddr storage
+    uint32_t peerLen = 0;
+};
+
+// Two-player rollback session. Each frame the local input is applied
+// immediately and the remote one is predicted (last known value). When the
+// real remote input for an already simulated frame differs from the
+// prediction, the machine is restored to that frame's snapshot and the
+// frames up to the present are re-simulated. The local side stalls rather
+// than run more than MAX_ROLLBACK frames past the last confirmed remote input.
+class RollbackSession {
+public:
+    static constexpr int MAX_ROLLBACK = 8;
+    static constexpr int HISTORY = 64;          // ring of per-frame records
+    static constexpr int MAX_INPUTS_PER_PACKET = 32;
+
+    RollbackSession(CPU& cpu, Bus& bus, u32& cycles, UdpSocket& socket, int localPlayer);
+
+    // Receive, roll back if needed, then simulate one frame with this input.
+    // Returns false (without advancing) while stalled waiting for the peer.
+    bool AdvanceFrame(uint8_t localInput);
+
+    // Receive/rollback/send without advancing (used while stalled or draining)
+    void Poll();
+
+    uint32_t Frame() const { return frame; }
+    // Highest frame for which every remote input is known (-1 if none)
+    int64_t ConfirmedFrame() const { return remoteConfirmed; }
+    // Highest of our frames the peer has acknowledged (-1 if none)
+    int64_t PeerAckedFrame() const { return remoteAck; }
+    uint64_t Rollbacks() const { return rollbacks; }
+    uint64_t ResimulatedFrames() const { return resimulated; }
+    uint64_t Desyncs() const { return desyncs; }
+
+private:
+    struct FrameRecord {
+        MachineState start;     // state before the frame ran
+        uint32_t frame = UINT32_MAX;
+        uint8_t local = 0;
+        uint8_t remoteUsed = 0; // remote input the frame was simulated with
+    };
+    struct RemoteInput {
+        uint32_t frame = UINT32_MAX;
+        uint8_t value = 0;
+    };
+
+    void Receive();
+    void Send();
+    void Simulate(FrameRecord& rec, bool render = true);
+    uint8_t PredictRemote(uint32_t f) const;
+    void CheckConfirmedHash();
+
+    CPU& cpu;
+    Bus& bus;
+    u32& cycles;
+    UdpSocket& socket;
+    int localPlayer;
+
+    std::array<FrameRecord, HISTORY> history;
+    std::array<RemoteInput, HISTORY> remote;
+    uint32_t frame = 0;             // next frame to simulate
+    int64_t remoteConfirmed = -1;
+    int64_t remoteAck = -1;         // highest of our frames the peer has confirmed
+    int64_t rollbackFrom = -1;      // earliest mispredicted frame, -1 if none
+    uint8_t lastRemote = 0;
+
+    // Desync detection: hash of the start state of the latest fully confirmed frame
+    uint32_t checkFrame = UINT32_MAX;
+    uint64_t checkHash = 0;
+    uint32_t peerCheckFrame = UINT32_MAX;
+    uint64_t peerCheckHash = 0;
+    uint32_t lastComparedFrame = UINT32_MAX;
+
+    uint64_t rollbacks = 0;
+    uint64_t resimulated = 0;
+    uint64_t desyncs = 0;
+};
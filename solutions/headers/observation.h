@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Agent-sized observations from palette-index frames (PPU::SetIndexTarget):
+// crop the overscan, map palette indices to luma, max-pool the two most
+// recent frames (sprite flicker), resize and stack the last few results.
+// Works on 1 byte per pixel throughout; no RGBA frame is involved.
+struct ObservationConfig {
+    int cropTop = 8;        // rows/columns dropped at each edge of the 256x240 frame
+    int cropBottom = 8;
+    int cropLeft = 0;
+    int cropRight = 0;
+    int width = 84;
+    int height = 84;
+    bool area = true;       // box-filter resize; false = nearest neighbour
+    bool maxPool = true;    // max of the last two frames
+    int stack = 4;          // observations concatenated, oldest first
+};
+
+// Row kernels of the pipeline. The plain versions use SSE2 (LumaRow: SSSE3)
+// when the build has it; the *Scalar versions are the fallback and the
+// reference the parity test holds them to.
+namespace ObservationDetail {
+// dst[x] = luma[src[x] & 63]
+void LumaRow(const uint8_t* luma, const uint8_t* src, uint8_t* dst, int n);
+void LumaRowScalar(const uint8_t* luma, const uint8_t* src, uint8_t* dst, int n);
+// dst[i] = max(a[i], b[i])
+void MaxBytes(const uint8_t* a, const uint8_t* b, uint8_t* dst, size_t n);
+void MaxBytesScalar(const uint8_t* a, const uint8_t* b, uint8_t* dst, size_t n);
+// dst[x] = (sum of src[(first + t) * stride + x] * weights[t] + 128) / 256
+// for t < count; the weights sum to 256
+void BlendRows(const uint8_t* src, int stride, int first, int count, const uint16_t* weights, uint8_t* dst, int n);
+void BlendRowsScalar(const uint8_t* src, int stride, int first, int count, const uint16_t* weights, uint8_t* dst, int n);
+}
+
+class ObservationPipeline {
+public:
+    explicit ObservationPipeline(const ObservationConfig& config = {});
+
+    const ObservationConfig& Config() const { return config; }
+    // False when the crop leaves nothing or the sizes are not positive
+    bool Valid() const { return valid; }
+    size_t FrameBytes() const { return size_t(config.width) * config.height; }
+    size_t ObservationBytes() const { return FrameBytes() * config.stack; }
+
+    // Forget previous frames (new episode); the stack reads as black
+    void Reset();
+    // Feed a 256x240 palette-index frame
+    void AddFrame(const uint8_t* indices);
+    // Pool, resize and push the latest frames onto the stack, then write the
+    // whole stack (ObservationBytes()) to out
+    void Observe(uint8_t* out);
+
+    // Source rows (or columns) feeding one output, weights[offset..] summing to 256
+    struct Tap {
+        uint16_t first;
+        uint16_t count;
+        uint32_t offset;
+    };
+    // Resize taps from srcSize to dstSize (box filter when area, else nearest)
+    static void BuildTaps(int srcSize, int dstSize, bool area, std::vector<Tap>& taps, std::vector<uint16_t>& weights);
+
+private:
+    ObservationConfig config;
+    bool valid = false;
+    int srcW = 0, srcH = 0;
+    uint8_t luma[64];
+    std::vector<Tap> rowTaps, colTaps;
+    std::vector<uint16_t> rowWeights, colWeights;
+    std::vector<uint8_t> frames[2];     // cropped luma of the two latest frames
+    int latest = 0;
+    std::vector<uint8_t> pooled;
+    std::vector<uint8_t> columnPass;    // vertically resized, srcW wide
+    std::vector<uint8_t> history;       // stack ring, FrameBytes() per entry
+    int next = 0;
+};
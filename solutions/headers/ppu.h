@@ -1,14 +1,39 @@
 #pragma once
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 
 class Bus;
+class PPURegisterLog;
+struct PPUState;
+
+// Optional instrumentation of PPU memory traffic: pattern (CHR), nametable
+// and palette accesses by rendering and through $2007, by PPU address
+// ($0000-$3FFF, before nametable mirroring). While PPU::tap is null the
+// render loop is the uninstrumented instantiation.
+struct PPUTap {
+    virtual ~PPUTap() = default;
+    virtual void OnPPURead(uint16_t addr) = 0;
+    virtual void OnPPUWrite(uint16_t addr) = 0;
+};
 
 class PPU {
 public:
     explicit PPU(Bus& bus);
     bool frameReady = false;
-    
+    // Number of frames completed since power-on (incremented at the start of VBlank)
+    uint64_t frameCount = 0;
+    // Per-instance diagnostics: log PPUSTATUS transitions and NMIs
+    bool verbose = false;
+    // false: run the frame without producing pixels. Timing, VBlank/NMI, status
+    // flags, register side effects and mapper-visible pattern fetches are kept;
+    // the frame buffer is left untouched and PopFrame has nothing to return.
+    bool drawFrame = true;
+    // Memory access instrumentation (nullptr when off)
+    PPUTap* tap = nullptr;
+    // Register/mapper timeline (nullptr when off)
+    PPURegisterLog* registerLog = nullptr;
+
 
     // Reset PPU state
     void Reset();
@@ -23,9 +48,19 @@ public:
     // Force render of a frame from current memory (useful for GUI immediate view)
     //bool RenderFrame(std::vector<uint32_t>& outPixels, int& outWidth, int& outHeight);
     uint32_t RenderPixel(int x, int y);
+    // Same pixel as a 6-bit NES palette index (before the RGBA lookup)
+    uint8_t RenderPaletteIndex(int x, int y);
+    // RGBA colour of a palette index, as used for the frame output
+    static uint32_t ColorOf(uint8_t paletteIndex);
+    static constexpr uint8_t BLACK_INDEX = 0x0F;
 
     // Pop a completed frame that was produced by StepCycles. Returns true if a frame was available.
     bool PopFrame(std::vector<uint32_t>& outPixels, int& outWidth, int& outHeight);
+    // Render straight into caller memory (256*240 pixels) instead of the internal
+    // frame; nullptr switches back. Frames are complete at the start of VBlank.
+    void SetFrameTarget(uint32_t* pixels) { frameTarget = pixels; }
+    // Output palette indices (256*240 bytes) instead; no RGBA is produced while set
+    void SetIndexTarget(uint8_t* indices) { indexTarget = indices; }
 
     // Keep existing pattern table helper (paletteGroup selects which 4-color palette to use; 0..3)
     bool RenderPatternTable(int tableIndex, std::vector<uint32_t>& outPixels, int& outWidth, int& outHeight, int paletteGroup = 0);
@@ -39,6 +74,13 @@ public:
     uint8_t GetPPUMASK() const { return PPUMASK; }
     uint8_t GetPPUSTATUS() const { return PPUSTATUS; }
     int GetSpriteHeight() const { return (PPUCTRL & 0x20) ? 16 : 8; }
+    // Address the next $2007 access goes to
+    uint16_t GetVRAMAddr() const { return vramAddr & 0x3FFF; }
+    // Byte at a PPU address ($0000-$3FFF) without touching the read buffer
+    uint8_t PeekVRAM(uint16_t addr) const;
+    // Current position: scanline 0-261 (241 starts VBlank, 261 is pre-render), dot 0-340
+    int GetScanline() const { return scanline; }
+    int GetDot() const { return cycle; }
 
 
     // OAM DMA: copy 256 bytes from CPU page (value<<8) into OAM
@@ -47,6 +89,10 @@ public:
     void WriteOAMByte(uint16_t index, uint8_t value);
     uint16_t MapNametable(uint16_t addr) const;
 
+    // Save-state support (the last rendered frame is output, not state)
+    void SaveState(PPUState& out) const;
+    void LoadState(const PPUState& in);
+
 private:
     Bus& bus;
 
@@ -79,6 +125,11 @@ private:
     // PPUDATA read buffer (reads from $0000-$3EFF are buffered)
     uint8_t readBuffer = 0;
 
+    // NMI already raised for the current VBlank
+    bool nmiOccurred = false;
+    // Last PPUSTATUS value written to the verbose log
+    uint8_t loggedStatus = 0xFF;
+
     // PPU cycle/frame counters
     uint32_t ppuCycleCounter = 0;
 
@@ -87,4 +138,23 @@ private:
 
     // Last rendered full frame (256x240) RGBA32
     std::vector<uint32_t> lastFrame;
+    uint32_t* frameTarget = nullptr;
+    uint8_t* indexTarget = nullptr;
+    // The last completed frame was drawn (output only, not saved)
+    bool frameDrawn = true;
+
+    // Sprites whose rows cover scanline lineSpriteY, in OAM order. Rebuilt when the
+    // scanline changes; any OAM or PPUCTRL write invalidates it.
+    uint8_t lineSprites[64];
+    int lineSpriteCount = 0;
+    int lineSpriteY = -1;
+    void InvalidateSpriteLine() { lineSpriteY = -1; }
+
+    uint8_t ReadRegisterValue(uint16_t reg);
+
+    // Tapped: report memory accesses to tap
+    template <bool Draw, bool Tapped>
+    uint8_t FetchPixel(int x, int y);
+    template <bool Tapped>
+    void Step(uint32_t ppuCycles);
 };
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Bus;
+class PPU;
+struct CPU;
+
+// Per-frame timeline of CPU-side PPU activity: every $2000-$2007 read and
+// write, and every mapper change of nametable mirroring or of a 1KB CHR
+// bank, stamped with the PPU scanline (0-261) and dot (0-340) it happened
+// at. The PPU only catches up after each instruction, so the stamp is its
+// position plus the cycles the instruction had spent before the access. A
+// frame runs from one VBlank start to the next, so it holds the VBlank
+// setup followed by whatever the game did while that picture was rendered.
+// Events go into a fixed buffer of CAPACITY per frame; repeats of the same
+// read (status polling) fold into one event, and the rest count as dropped.
+class PPURegisterLog {
+public:
+    static constexpr size_t CAPACITY = 4096;
+
+    enum Kind : uint8_t { READ, WRITE, MIRRORING, CHR_BANK };
+
+    struct Event {
+        uint16_t scanline;
+        uint16_t dot;
+        Kind kind;
+        uint8_t index;      // register 0-7 ($2000-$2007), or 1KB CHR slot 0-7
+        uint16_t value;     // byte read/written, Mirroring, or CHR bank in 1KB units
+        uint16_t repeat;    // further identical reads folded into this one
+    };
+
+    PPURegisterLog();
+
+    // Route ppu.registerLog here until Detach()
+    void Attach(PPU& ppu, Bus& bus, const CPU& cpu);
+    void Detach();
+    bool Attached() const { return ppu != nullptr; }
+
+    // PPU side: a register access at the current position
+    void OnRegister(Kind kind, uint8_t reg, uint8_t value);
+    // Bus side: after a CPU write to the mapper; records what changed
+    void OnMapperWrite();
+    // PPU side: VBlank started; the current frame becomes the last one
+    void EndFrame(uint64_t frame);
+
+    // Last completed frame
+    const std::vector<Event>& Events() const { return last; }
+    uint64_t Frame() const { return lastFrame; }
+    size_t Dropped() const { return lastDropped; }
+    // Writes and mapper changes on visible scanlines (0-239): nonzero means
+    // the frame cannot be drawn from one snapshot of PPU state. Stamps come
+    // from the CPU's per-instruction cycle count, so an access can still be
+    // off by a cycle (3 dots) around the edges of the visible area.
+    size_t MidFrameChanges() const;
+
+    static const char* KindName(Kind kind);
+    // CSV: "frame,scanline,dot,event,target,value,repeat"
+    static void WriteHeader(std::ostream& out);
+    void WriteFrame(std::ostream& out) const;
+    // Header plus the last completed frame
+    bool Export(const std::string& path) const;
+
+private:
+    void Record(Kind kind, uint8_t index, uint16_t value);
+    void CaptureMapper();
+
+    std::vector<Event> current;
+    std::vector<Event> last;
+    size_t dropped = 0;
+    size_t lastDropped = 0;
+    uint64_t lastFrame = 0;
+
+    PPU* ppu = nullptr;
+    Bus* bus = nullptr;
+    const CPU* cpu = nullptr;
+    int mirroring = -1;
+    int chrBanks[8];
+};
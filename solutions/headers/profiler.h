@@ -0,0 +1,115 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "bus.h"
+#include "mapper.h"
+#include "types.h"
+
+struct CPU;
+
+// Execution profiler, used as the hooks type of CPU::ExecuteHooked /
+// RunFrameHooked; the plain Execute path contains none of this. Counts
+// instructions and cycles per PC, tagged with the PRG bank mapped there, per
+// opcode and per subroutine. JSR/RTS and interrupts/RTI are tracked as a call
+// stack, which gives each subroutine its inclusive cycles and is exported as
+// folded stacks ("a;b;c cycles" lines for flamegraph.pl, speedscope, ...).
+class Profiler {
+public:
+    static constexpr bool enabled = true;
+
+    struct HotSpot {
+        uint16_t pc;
+        int bank;                   // PRG bank at pc, -1 for RAM/$6000 or unknown
+        uint64_t instructions;
+        uint64_t cycles;
+    };
+
+    struct Function {
+        uint16_t pc;                // entry point
+        int bank;
+        uint64_t calls;             // JSRs (or interrupts) that entered it
+        uint64_t inclusiveCycles;   // entry to return, callees included
+        uint64_t selfCycles;        // spent in its own instructions
+    };
+
+    Profiler();
+
+    void Reset();
+
+    // ExecuteHooked hooks
+    bool Paused() const { return false; }
+    bool BeforeInstruction(const CPU&, const Bus&) { return true; }
+    void Instruction(const CPU& cpu, const Bus& bus, uint16_t pc, uint8_t opcode, u32 cycles);
+    void Interrupt(const CPU& cpu, const Bus& bus, bool nmi, u32 cycles);
+    void Stall(u32 cycles);
+
+    uint64_t Instructions() const { return instructions; }
+    uint64_t Cycles() const { return cycles; }
+    uint64_t DmaCycles() const { return dmaCycles; }
+    uint64_t OpcodeCount(uint8_t opcode) const { return opcodeCounts[opcode]; }
+    uint64_t OpcodeCycles(uint8_t opcode) const { return opcodeCycles[opcode]; }
+
+    // Most expensive first (by cycles)
+    std::vector<HotSpot> HotSpots(size_t limit) const;
+    // Most expensive first (by inclusive cycles)
+    std::vector<Function> Functions(size_t limit) const;
+
+    // One "frame;frame;... selfCycles" line per distinct call stack
+    bool WriteFoldedStacks(const std::string& path) const;
+
+    // "05:8123" for PRG ROM (bank:address), "0700" for RAM and PRG-RAM
+    static std::string LocationName(uint16_t pc, int bank);
+
+private:
+    enum Kind : uint32_t { KIND_CALL = 0, KIND_NMI = 1, KIND_IRQ = 2 };
+    static constexpr size_t MAX_DEPTH = 256;
+
+    struct Counter {
+        uint64_t instructions = 0;
+        uint64_t cycles = 0;
+        uint64_t calls = 0;
+        uint64_t inclusiveCycles = 0;
+        uint16_t pc = 0;
+    };
+    // Call tree node: one per distinct stack
+    struct Node {
+        uint32_t parent;
+        uint32_t function;          // location | kind << 24
+        uint64_t selfCycles;
+    };
+    struct Frame {
+        uint32_t node;
+        uint32_t location;
+        uint8_t sp;                 // SP before the return address was pushed
+        uint64_t entryCycles;
+    };
+
+    // Index into counters: PC below $8000, otherwise $8000 + bank * 8KB +
+    // offset in the bank, so one address in different banks stays apart
+    static uint32_t Locate(const Bus& bus, uint16_t pc) {
+        int bank = pc >= 0x8000 && bus.mapper ? bus.mapper->PRGBank(pc) : -1;
+        return bank < 0 ? pc : 0x8000u + uint32_t(bank) * 0x2000u + (pc & 0x1FFFu);
+    }
+    Counter& At(uint32_t location);
+    static int BankOf(uint32_t location) { return location < 0x8000 ? -1 : int((location - 0x8000) >> 13); }
+    std::string FunctionName(uint32_t function) const;
+
+    void Enter(uint32_t location, Kind kind, uint8_t sp);
+    void Leave(uint8_t sp);
+
+    std::vector<Counter> counters;
+    std::array<uint64_t, 256> opcodeCounts{};
+    std::array<uint64_t, 256> opcodeCycles{};
+    uint64_t instructions = 0;
+    uint64_t cycles = 0;
+    uint64_t dmaCycles = 0;
+
+    std::vector<Node> nodes;                                // 0 is the root
+    std::unordered_map<uint64_t, uint32_t> children;        // parent << 32 | function -> node
+    std::vector<Frame> stack;
+    uint32_t current = 0;
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "savestate.h"
+
+class Bus;
+
+// What a RAM search filter keeps. Operands are either the older snapshot
+// (vsPrevious) or the constant `value`; InRange tests the newer value against
+// [value, high] and ChangedBy keeps addresses where newer - older == value
+// (modulo the width, so "decreased by 1" is ChangedBy 0xFF / 0xFFFF).
+struct RamQuery {
+    enum Op { Equal, NotEqual, Less, Greater, LessEqual, GreaterEqual, InRange, ChangedBy };
+
+    Op op = Equal;
+    bool vsPrevious = true;
+    uint16_t value = 0;
+    uint16_t high = 0;
+    bool word = false;       // 16-bit values starting at each address
+    bool bigEndian = false;
+};
+
+// Filter kernels, 16 image bytes per call: bit k of the result is set when
+// the value at cur + k passes q against the one at prev + k. Both buffers
+// must have 17 readable bytes (a word reads one past the last address).
+// Match16 is the SSE2 version when the build has it; the scalar one is the
+// fallback and the reference the parity test holds it to.
+namespace RamSearchDetail {
+uint32_t Match16(const RamQuery& q, const uint8_t* cur, const uint8_t* prev);
+uint32_t Match16Scalar(const RamQuery& q, const uint8_t* cur, const uint8_t* prev);
+}
+
+// Cheat-search style candidate filtering over the internal 2KB RAM ($0000)
+// and cartridge PRG-RAM ($6000). Snapshots are kept as flat images; each
+// Filter() narrows a candidate bitmap, comparing 16 addresses per step with
+// SSE2 (scalar otherwise).
+class RamSearch {
+public:
+    static constexpr size_t RAM_BYTES = 0x0800;
+    static constexpr size_t PRG_RAM_BYTES = 0x2000;
+    static constexpr size_t SIZE = RAM_BYTES + PRG_RAM_BYTES;
+
+    explicit RamSearch(bool includePrgRam = true) { Reset(includePrgRam); }
+
+    // Drop all snapshots and make every address a candidate again
+    void Reset(bool includePrgRam = true);
+
+    void Capture(const Bus& bus);
+    void Capture(const MachineState& state);
+    size_t Snapshots() const { return snapshots.size(); }
+    // Oldest snapshots are dropped beyond this many
+    size_t maxSnapshots = 64;
+
+    // Keep candidates matching q, comparing snapshot `newer` with `older`
+    // (negative indices count from the end: -1 = latest). Returns the count left.
+    size_t Filter(const RamQuery& q, int newer = -1, int older = -2);
+
+    size_t Count() const { return count; }
+    bool IsCandidate(size_t index) const { return (candidates[index >> 6] >> (index & 63)) & 1; }
+    // Candidate indices in address order, at most limit of them
+    std::vector<uint32_t> Candidates(size_t limit = SIZE) const;
+
+    // Value at an image index in snapshot `which` (negative = from the end)
+    uint16_t Value(size_t index, bool word, bool bigEndian, int which = -1) const;
+    // CPU address of an image index
+    static uint16_t Address(size_t index) {
+        return index < RAM_BYTES ? uint16_t(index) : uint16_t(0x6000 + (index - RAM_BYTES));
+    }
+
+private:
+    // Zero padding so word and vector loads at the last address stay in bounds
+    struct Image {
+        uint8_t bytes[SIZE + 16];
+    };
+    const Image* At(int which) const;
+    void Recount();
+
+    std::deque<Image> snapshots;
+    uint64_t candidates[SIZE / 64] = {0};
+    size_t count = 0;
+    bool prgRam = true;
+};
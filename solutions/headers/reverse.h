@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include "savestate.h"
+
+struct CPU;
+class Bus;
+
+// Reverse execution for the debugger. While attached, all emulation goes
+// through Step()/RunFrame(), which count instructions ("positions"), log
+// controller changes and keep a compressed checkpoint every
+// `checkpointInterval` frames. Going backwards restores the nearest
+// checkpoint and re-executes forward deterministically, so the cost of a
+// backward step is bounded by the checkpoint spacing, not the session length.
+//
+// Positions below Head() are history: stepping forward there replays the
+// logged input instead of the live pads. Diverge() drops the future so new
+// input can be recorded from the current position.
+class ReverseDebugger {
+public:
+    static constexpr size_t DEFAULT_MAX_BYTES = 64u * 1024 * 1024;
+
+    ReverseDebugger(CPU& cpu, Bus& bus, u32& cycles);
+
+    int checkpointInterval = 4;             // frames between checkpoints
+    size_t maxBytes = DEFAULT_MAX_BYTES;    // checkpoint budget; oldest are dropped first
+
+    // Start a new history at the machine's current state
+    void Reset();
+
+    void Step();
+    void RunFrame();
+
+    bool StepBack(uint64_t instructions = 1);
+    // Back to the start of the current frame (or the previous one when already there)
+    bool StepBackFrame();
+    // Back to the most recent instruction that wrote addr (RAM mirrors included),
+    // stopping before it executes
+    bool StepBackToWrite(uint16_t addr);
+    // Move anywhere within recorded history
+    bool SeekTo(uint64_t target);
+    // Forget everything after the current position
+    void Diverge();
+
+    uint64_t Position() const { return position; }
+    uint64_t Head() const { return head; }
+    uint64_t Oldest() const { return checkpoints.empty() ? 0 : checkpoints.front().position; }
+    size_t Checkpoints() const { return checkpoints.size(); }
+    size_t Bytes() const { return bytes; }
+    double LastSeekMs() const { return lastSeekMs; }
+
+private:
+    struct Checkpoint {
+        uint64_t position;
+        std::vector<uint8_t> data; // zero-RLE encoded MachineState
+    };
+    struct InputEvent {
+        uint64_t position;         // pads take effect before this instruction
+        uint8_t pads[2];
+    };
+
+    void AddCheckpoint();
+    bool RestoreCheckpoint(size_t index);
+    size_t CheckpointBefore(uint64_t target) const;
+    void SyncInput(bool replaying);
+    uint64_t FrameCount() const;
+
+    CPU& cpu;
+    Bus& bus;
+    u32& cycles;
+
+    uint64_t position = 0;
+    uint64_t head = 0;
+    uint64_t framesRecorded = 0;
+    std::deque<Checkpoint> checkpoints;
+    std::deque<InputEvent> inputs;
+    std::deque<uint64_t> frameStarts;
+    size_t nextInput = 0;       // first input event not yet applied
+    uint8_t pads[2] = {0, 0};   // logged controller state at the current position
+    size_t bytes = 0;
+    double lastSeekMs = 0.0;
+    MachineState scratch{};
+};
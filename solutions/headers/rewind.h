@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "savestate.h"
+
+// Bounded history of per-frame machine states. Every keyframeInterval-th
+// state is stored whole; the ones in between are XOR deltas against that
+// keyframe, and both are zero-run-length encoded. When the byte budget is
+// exceeded the oldest keyframe group is dropped.
+class RewindBuffer {
+public:
+    explicit RewindBuffer(size_t maxBytes = 32u * 1024u * 1024u, int keyframeInterval = 60);
+
+    // Record the state at the end of a frame
+    void Push(const MachineState& state);
+
+    // Remove the most recent state and return it. False when empty.
+    bool Pop(MachineState& out);
+
+    void Clear();
+    size_t Frames() const { return entries.size(); }
+    size_t Bytes() const { return totalBytes; }
+    size_t MaxBytes() const { return maxBytes; }
+
+private:
+    struct Entry {
+        std::vector<uint8_t> data;
+        bool keyframe = false;
+    };
+
+    bool DecodeLastKeyframe();
+    void Evict();
+
+    size_t maxBytes;
+    int keyframeInterval;
+    std::deque<Entry> entries;
+    size_t totalBytes = 0;
+
+    // Decoded keyframe of the newest group, used as the XOR base for new deltas
+    MachineState base{};
+    bool baseValid = false;
+    int sinceKeyframe = 0;
+    std::vector<uint8_t> scratch;
+};
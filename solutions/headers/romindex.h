@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mapper.h"
+
+// Persistent index of a ROM library. Each entry caches the parsed iNES /
+// NES 2.0 header and a content hash, keyed by path and validated by file
+// size + mtime so rescans only touch files that changed.
+
+enum class RomFormat : uint8_t {
+    Unknown = 0,
+    INES = 1,
+    NES20 = 2,
+};
+
+struct RomInfo {
+    std::string path;
+    uint64_t fileSize = 0;
+    int64_t mtime = 0;          // last write time (filesystem clock ticks)
+    uint64_t hash = 0;          // HashRomData over PRG+CHR (header excluded)
+
+    RomFormat format = RomFormat::Unknown;
+    uint16_t mapper = 0;
+    uint8_t submapper = 0;
+    uint32_t prgSize = 0;       // bytes
+    uint32_t chrSize = 0;       // bytes (0 = CHR RAM)
+    uint32_t prgRamSize = 0;    // bytes
+    uint32_t chrRamSize = 0;    // bytes
+    Mirroring mirroring = Mirroring::Horizontal;
+    bool battery = false;
+    bool trainer = false;
+    uint8_t header[16] = {0};
+};
+
+// Parse a 16-byte iNES / NES 2.0 header. Returns false if the signature is missing.
+bool ParseRomHeader(const uint8_t* header, RomInfo& out);
+
+// Every .nes file under a directory (recursive), sorted by path
+std::vector<std::string> ListRomFiles(const std::string& directory);
+
+class RomIndex {
+public:
+    // Load/save the on-disk index. Load returns false if missing or incompatible.
+    bool Load(const std::string& indexPath);
+    bool Save(const std::string& indexPath) const;
+
+    // Recursively scan a directory for .nes files. Entries whose size and mtime
+    // match the cache are kept; new or changed files are hashed in parallel
+    // (threads = 0 uses all hardware threads). Files that disappeared under
+    // the directory are dropped. Returns the number of files (re)hashed.
+    size_t Scan(const std::string& directory, unsigned threads = 0);
+
+    const std::vector<RomInfo>& Entries() const { return entries; }
+    const RomInfo* FindByHash(uint64_t hash) const;
+    const RomInfo* FindByPath(const std::string& path) const;
+
+    // Default index location used by the GUI and the `index` CLI mode
+    static constexpr const char* DEFAULT_PATH = "romindex.bin";
+
+private:
+    std::vector<RomInfo> entries; // sorted by path
+};
@@ -0,0 +1,19 @@
+#pragma once
+#include "savestate.h"
+
+struct CPU;
+class Bus;
+
+// Run-ahead input latency reduction. Each host frame advances the real
+// machine one frame, snapshots it, emulates `frames` more frames with the
+// input just sampled, and rolls back. The PPU picture left behind is the
+// last run-ahead frame, so games that poll input in NMI respond immediately.
+class RunAhead {
+public:
+    int frames = 0; // 0 = disabled
+
+    void RunFrame(CPU& cpu, Bus& bus, u32& cycles);
+
+private:
+    MachineState saved{};
+};
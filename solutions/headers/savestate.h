@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include "types.h"
+
+// Fixed-size, padding-free POD image of the whole machine. Every byte is
+// written on Snapshot, so two snapshots of the same machine compare equal
+// byte-for-byte (which the rewind/fingerprint code relies on).
+
+struct CPUState {
+    uint32_t cycles;
+    uint16_t PC;
+    uint8_t SP, A, X, Y, P;
+    uint8_t interrupt;
+    uint8_t nmiRequested;
+    uint8_t prevNmiLine;
+    uint8_t pad[2];
+};
+
+struct BusState {
+    uint8_t ram[0x0800];
+    uint8_t chrRam[0x2000];     // only meaningful when chrIsRam
+    uint32_t oamDmaCycles;
+    uint16_t oamDmaIndex;
+    uint8_t irqEnable;
+    uint8_t nmiLine;
+    uint8_t mirrorVertical;
+    uint8_t chrIsRam;
+    uint8_t oamDmaActive;
+    uint8_t oamDmaPage;
+    uint8_t oamDmaDummy;
+    uint8_t pad[3];
+};
+
+struct InputState {
+    int32_t shiftIndex[2];
+    uint8_t currState[2];
+    uint8_t shiftReg[2];
+    uint8_t strobe;
+    uint8_t pad[3];
+};
+
+struct PPUState {
+    uint8_t vram[0x0800];
+    uint8_t paletteRam[32];
+    uint8_t oam[256];
+    uint64_t frameCount;
+    uint32_t ppuCycleCounter;
+    int32_t scanline;
+    int32_t cycle;
+    uint16_t vramAddr;
+    uint16_t vramAddrTemp;
+    uint16_t renderAddr;
+    uint8_t PPUCTRL, PPUMASK, PPUSTATUS, OAMADDR;
+    uint8_t writeToggle;
+    uint8_t fineX;
+    uint8_t scrollCoarseX, scrollCoarseY, scrollFineY;
+    uint8_t readBuffer;
+    uint8_t frameReady;
+    uint8_t nmiOccurred;
+    uint8_t pad[2];
+};
+
+// Generic mapper block: mappers fill what they use and zero the rest
+struct MapperState {
+    uint8_t prgRam[0x2000];
+    int32_t a12HighCycles;
+    int32_t a12EdgeCount;
+    uint16_t mapperId;          // 0xFFFF when no mapper is attached
+    uint8_t regs[8];
+    uint8_t bankSelect;
+    uint8_t prgMode;
+    uint8_t chrMode;
+    uint8_t irqLatch;
+    uint8_t irqCounter;
+    uint8_t irqReload;
+    uint8_t prevA12;
+    uint8_t mirroring;
+    uint8_t pad[6];
+};
+
+struct MachineState {
+    static constexpr uint32_t MAGIC = 0x5453454E; // "NEST"
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    CPUState cpu;
+    BusState bus;
+    InputState input;
+    PPUState ppu;
+    MapperState mapper;
+};
+
+static_assert(std::is_trivially_copyable<MachineState>::value, "MachineState must be POD");
+static_assert(sizeof(MachineState) == 8 + sizeof(CPUState) + sizeof(BusState) + sizeof(InputState) +
+              sizeof(PPUState) + sizeof(MapperState), "MachineState must not contain padding");
+static_assert(sizeof(CPUState) % 8 == 0 && sizeof(BusState) % 8 == 0 && sizeof(InputState) % 8 == 0 &&
+              sizeof(PPUState) % 8 == 0 && sizeof(MapperState) % 8 == 0, "state blocks must stay 8-byte aligned");
+
+struct CPU;
+class Bus;
+
+// Capture the complete machine (CPU, bus RAM/CHR-RAM, input, attached PPU and
+// mapper) plus the caller's cycle counter.
+void Snapshot(const CPU& cpu, const Bus& bus, u32 cycles, MachineState& out);
+
+// Restore a snapshot taken from the same cartridge. Returns false (and leaves
+// the machine untouched) if the blob is not a compatible MachineState.
+bool Restore(CPU& cpu, Bus& bus, u32& cycles, const MachineState& state);
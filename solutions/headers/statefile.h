@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "savestate.h"
+#include "mappedfile.h"
+
+// On-disk save state: a 64-byte header followed by the MachineState image.
+// Uncompressed files are restored straight from the mapping (no parsing);
+// compressed ones hold the zero-RLE encoding of the image instead.
+struct StateFileHeader {
+    static constexpr char MAGIC[8] = {'N', 'E', 'S', 'S', 'T', 'A', 'T', 'E'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t FLAG_COMPRESSED = 0x1;
+
+    char magic[8];
+    uint32_t version;       // file layout version
+    uint32_t stateVersion;  // MachineState::VERSION
+    uint32_t stateSize;     // sizeof(MachineState)
+    uint32_t flags;
+    uint64_t romHash;       // HashRomData of the cartridge the state belongs to
+    uint16_t mapperId;
+    uint16_t reserved0[3];
+    uint64_t payloadSize;
+    uint8_t reserved1[16];
+};
+static_assert(sizeof(StateFileHeader) == 64, "state file header layout is fixed");
+
+bool SaveStateFile(const std::string& path, const MachineState& state, uint64_t romHash, bool compress = false);
+
+// Mapped view over a state file. State() points into the mapping for
+// uncompressed files, so a load is Open() + Restore(*view.State()).
+class StateFileView {
+public:
+    bool Open(const std::string& path);
+    const StateFileHeader* Header() const { return header; }
+    bool IsCompressed() const { return header && (header->flags & StateFileHeader::FLAG_COMPRESSED); }
+    const MachineState* State() const;
+    // Copy (or decompress) the state into out
+    bool Decode(MachineState& out) const;
+
+private:
+    MappedFile file;
+    const StateFileHeader* header = nullptr;
+};
+
+// Convenience: open, verify the ROM hash (if romHash != 0) and decode
+bool LoadStateFile(const std::string& path, MachineState& out, uint64_t romHash = 0);
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. ParallelFor splits the
+// index range into one contiguous block per worker, so index i keeps landing
+// on the same worker from call to call (and its data stays in that core's
+// cache); a worker that runs out of work steals from the back of the busiest
+// looking neighbour. The calling thread takes part as worker 0.
+class ThreadPool {
+public:
+    // threads counts the caller; 0 = one per hardware thread. With pinToCores,
+    // spawned worker k is bound to core k (Linux only, ignored elsewhere).
+    explicit ThreadPool(size_t threads = 0, bool pinToCores = false);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t Size() const { return queueCount; }
+
+    // Run fn(i) for every i in [0, count) and wait for all of them. Not reentrant.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    // Tasks run by a worker other than the one that owned them
+    uint64_t Steals() const { return steals.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Queue {
+        std::mutex m;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    void WorkerLoop(size_t self);
+    void RunTasks(size_t self, const std::function<void(size_t)>& fn);
+    bool Pop(size_t self, size_t& index);
+    bool Steal(size_t self, size_t& index);
+
+    std::unique_ptr<Queue[]> queues;    // one per worker, each on its own cache line
+    size_t queueCount = 0;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    const std::function<void(size_t)>* job = nullptr;
+    uint64_t generation = 0;
+    size_t activeWorkers = 0;
+    bool stopping = false;
+    std::atomic<size_t> remaining{0};
+    std::atomic<uint64_t> steals{0};
+};
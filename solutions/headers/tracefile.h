@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mappedfile.h"
+
+// One executed instruction as seen before it runs: registers, the
+// instruction bytes (only `length` of them are meaningful) and the CPU
+// cycle counter.
+struct TraceRecord {
+    static constexpr uint8_t FLAG_CYCLES = 0x1;    // cycles was present in the source log
+
+    uint32_t cycles;
+    uint16_t pc;
+    uint8_t bytes[3];
+    uint8_t length;
+    uint8_t a, x, y, p, sp;
+    uint8_t flags;
+};
+static_assert(sizeof(TraceRecord) == 16, "trace record layout is fixed");
+
+// Receives every instruction the CPU executes (CPU::traceSink)
+struct TraceSink {
+    virtual ~TraceSink() = default;
+    virtual void OnInstruction(const TraceRecord& r) = 0;
+};
+
+// Golden trace file: a 32-byte header followed by TraceRecords. Text logs
+// are converted once and the binary is compared straight from the mapping.
+struct TraceFileHeader {
+    static constexpr char MAGIC[8] = {'N', 'E', 'S', 'T', 'R', 'A', 'C', 'E'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;    // sizeof(TraceRecord)
+    uint64_t recordCount;
+    uint64_t reserved;
+};
+static_assert(sizeof(TraceFileHeader) == 32, "trace file header layout is fixed");
+
+// Parse one nestest/Nintendulator style line ("C000  4C F5 C5  JMP ...
+// A:00 X:00 Y:00 P:24 SP:FD ... CYC:7"). S: is accepted for SP.
+bool ParseTraceLine(const char* line, size_t len, TraceRecord& out);
+
+// Convert a text log into a golden trace file; lines without a leading
+// PC are skipped, lines with one that do not parse are counted and
+// reported. Returns the number of records written, or -1 on error
+// (including a log with no usable line).
+int64_t ConvertTraceLog(const std::string& textPath, const std::string& binPath);
+
+// "C5F5  A2 00     A:00 X:00 Y:00 P:24 SP:FD CYC:10" into buf
+void FormatTraceRecord(const TraceRecord& r, char* buf, size_t size);
+
+// Mapped golden trace
+class TraceFileView {
+public:
+    bool Open(const std::string& path);
+    size_t Count() const { return count; }
+    const TraceRecord& operator[](size_t i) const { return records[i]; }
+
+private:
+    MappedFile file;
+    const TraceRecord* records = nullptr;
+    size_t count = 0;
+};
+
+// The last `capacity` records pushed, for divergence context
+class TraceHistory {
+public:
+    // Rounded up to a power of two
+    explicit TraceHistory(size_t capacity) {
+        size_t n = 1;
+        while (n < capacity) n <<= 1;
+        ring.resize(n);
+    }
+
+    void Push(const TraceRecord& r) { ring[total++ & (ring.size() - 1)] = r; }
+    size_t Size() const { return total < ring.size() ? size_t(total) : ring.size(); }
+    uint64_t Total() const { return total; }
+    // i = 0 is the oldest record still held
+    const TraceRecord& At(size_t i) const { return ring[(total - Size() + i) & (ring.size() - 1)]; }
+
+private:
+    std::vector<TraceRecord> ring;
+    uint64_t total = 0;
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "tracefile.h"
+
+// Instruction trace to disk without stalling emulation. The emulation
+// thread appends TraceRecords to a single-producer/single-consumer ring (no
+// locks, one release store per record); a writer thread drains it in large
+// sequential writes. The output is a golden trace file (tracefile.h), so it
+// can be compared against or formatted to text later.
+class TraceRecorder : public TraceSink {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = size_t(1) << 20;    // records (16 MB)
+    static constexpr size_t WRITE_BATCH = size_t(1) << 16;         // records per write
+
+    explicit TraceRecorder(size_t capacity = DEFAULT_CAPACITY);
+    ~TraceRecorder() override;
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    bool Start(const std::string& path);
+    // Flush everything recorded so far and finish the file
+    bool Stop();
+    bool Running() const { return writer.joinable(); }
+
+    // Producer side; only one thread may call this. Blocks (spinning) only
+    // when the writer has fallen a whole ring behind.
+    void Record(const TraceRecord& r) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tailCache >= ring.size()) WaitForSpace(h);
+        ring[h & mask] = r;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    void OnInstruction(const TraceRecord& r) override { Record(r); }
+
+    uint64_t Recorded() const { return head.load(std::memory_order_relaxed); }
+    // Times Record found the ring full and had to wait for the writer
+    uint64_t Stalls() const { return stalls; }
+
+private:
+    void WriteHeader(uint64_t count);
+    void WaitForSpace(uint64_t h);
+    void WriterLoop();
+
+    std::vector<TraceRecord> ring;
+    size_t mask = 0;
+    alignas(64) std::atomic<uint64_t> head{0};     // next record to fill (producer)
+    uint64_t tailCache = 0;                        // producer's last view of tail
+    uint64_t stalls = 0;
+    alignas(64) std::atomic<uint64_t> tail{0};     // next record to write (writer)
+    std::atomic<bool> stopping{false};
+    std::ofstream out;
+    std::thread writer;
+    bool failed = false;
+};
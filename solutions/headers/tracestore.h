@@ -0,0 +1,163 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bus.h"
+#include "mappedfile.h"
+#include "tracefile.h"
+
+struct CPU;
+
+// Indexed on-disk trace for long sessions. Instructions (TraceRecords), the
+// CPU writes they made and frame boundaries are stored in chunks of
+// CHUNK_RECORDS instructions. Each chunk has an index entry with its frame
+// range, PC range, a bitmap of executed PC pages and a bitmap of written
+// 32-byte blocks, so queries only decode chunks that can match.
+//
+// File: TraceStoreHeader, chunk blobs, then the index table (at
+// header.indexOffset). A chunk blob holds the zero-RLE encoded records
+// (each XORed with its predecessor and split into byte planes), then the
+// writes, then the frame start offsets.
+struct TraceStoreHeader {
+    static constexpr char MAGIC[8] = {'N', 'E', 'S', 'T', 'S', 'T', 'O', 'R'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t chunkRecords;
+    uint64_t chunkCount;
+    uint64_t indexOffset;
+    uint64_t instructions;
+};
+static_assert(sizeof(TraceStoreHeader) == 40, "trace store header layout is fixed");
+
+struct TraceWrite {
+    uint32_t instruction;   // offset in the chunk of the instruction that wrote
+    uint16_t addr;
+    uint8_t value;
+    uint8_t pad;
+};
+static_assert(sizeof(TraceWrite) == 8, "trace write layout is fixed");
+
+struct TraceChunkIndex {
+    uint64_t offset;            // file offset of the blob
+    uint64_t firstInstruction;
+    uint64_t firstFrame;
+    uint64_t lastFrame;
+    uint32_t count;             // instructions
+    uint32_t recordBytes;       // encoded record bytes at the start of the blob
+    uint32_t writeCount;
+    uint32_t frameStartCount;
+    uint16_t pcMin;
+    uint16_t pcMax;
+    uint32_t pad;
+    uint64_t pcPages[4];        // bit p: an instruction ran in page $pp00
+    uint64_t writeBlocks[32];   // bit b: a write hit addr / 32 == b (RAM mirrors folded)
+
+    bool HasPcPage(uint16_t pc) const { return (pcPages[pc >> 14] >> ((pc >> 8) & 63)) & 1; }
+    bool HasWriteBlock(uint16_t addr) const { return (writeBlocks[addr >> 11] >> ((addr >> 5) & 63)) & 1; }
+};
+static_assert(sizeof(TraceChunkIndex) == 344, "trace chunk index layout is fixed");
+
+// Same address for the CPU: internal RAM mirrors fold onto $0000-$07FF
+inline uint16_t CanonicalAddr(uint16_t addr) {
+    return addr < 0x2000 ? uint16_t(addr & Bus::RAM_MASK) : addr;
+}
+
+// Builds a store while the machine runs. Attach() hooks the CPU trace path
+// and the bus tap chain (for writes); full chunks are encoded and written by a
+// background thread.
+class TraceStoreWriter : public TraceSink, public BusTap {
+public:
+    static constexpr uint32_t CHUNK_RECORDS = 1u << 16;
+    static constexpr size_t MAX_PENDING = 8;    // chunks queued for the encoder before emulation waits
+
+    TraceStoreWriter() = default;
+    ~TraceStoreWriter() override;
+    TraceStoreWriter(const TraceStoreWriter&) = delete;
+    TraceStoreWriter& operator=(const TraceStoreWriter&) = delete;
+
+    bool Open(const std::string& path);
+    // Take cpu.traceSink and join the bus tap chain until Detach()
+    void Attach(CPU& cpu, Bus& bus);
+    void Detach();
+    // Flush the last chunk and write the index
+    bool Close();
+
+    void OnInstruction(const TraceRecord& r) override;
+    void OnCPUWrite(uint16_t addr, uint8_t value) override;
+
+    uint64_t Instructions() const { return instructions; }
+    uint64_t Bytes() const { return bytesWritten; }
+
+private:
+    struct Chunk {
+        TraceChunkIndex index{};
+        std::vector<TraceRecord> records;
+        std::vector<TraceWrite> writes;
+        std::vector<uint32_t> frameStarts;   // offsets of the first instruction of each new frame
+    };
+
+    void StartChunk();
+    void Submit();
+    void EncoderLoop();
+
+    std::ofstream out;
+    CPU* cpu = nullptr;
+    Bus* bus = nullptr;
+    Chunk current;
+    uint64_t instructions = 0;
+    uint64_t frame = 0;
+
+    std::thread encoder;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable drained;
+    std::deque<Chunk> pending;
+    bool closing = false;
+    std::vector<TraceChunkIndex> index;
+    uint64_t bytesWritten = 0;
+    bool failed = false;
+};
+
+// One matching instruction
+struct TraceHit {
+    uint64_t instruction;   // position in the whole session
+    uint64_t frame;
+    TraceRecord record;
+    uint16_t addr = 0;      // write queries: the address and value written
+    uint8_t value = 0;
+};
+
+class TraceStoreReader {
+public:
+    bool Open(const std::string& path);
+    size_t Chunks() const { return count; }
+    uint64_t Instructions() const { return header ? header->instructions : 0; }
+    const TraceChunkIndex& Index(size_t i) const { return index[i]; }
+
+    // Decode one chunk
+    bool ReadChunk(size_t i, std::vector<TraceRecord>& records, std::vector<TraceWrite>& writes,
+                   std::vector<uint32_t>& frameStarts) const;
+
+    // Writes to addr (RAM mirrors included) made in frames [firstFrame, lastFrame]
+    std::vector<TraceHit> FindWrites(uint16_t addr, uint64_t firstFrame, uint64_t lastFrame, size_t limit = SIZE_MAX);
+    // First instruction at pc in frame firstFrame or later
+    bool FindPC(uint16_t pc, uint64_t firstFrame, TraceHit& out);
+
+    // Chunks decoded by the queries so far (the rest were skipped by the index)
+    size_t ChunksDecoded() const { return decoded; }
+
+private:
+    MappedFile file;
+    const TraceStoreHeader* header = nullptr;
+    const TraceChunkIndex* index = nullptr;
+    size_t count = 0;
+    size_t decoded = 0;
+};
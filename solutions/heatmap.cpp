@@ -0,0 +1,62 @@
+#include "headers/heatmap.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+Heatmap::Heatmap() {
+    Reset();
+}
+
+void Heatmap::Attach(Bus& b, PPU& p) {
+    Detach();
+    bus = &b;
+    ppu = &p;
+    previousPpuTap = p.tap;
+    b.AddTap(this);
+    p.tap = this;
+}
+
+void Heatmap::Detach() {
+    if (bus) bus->RemoveTap(this);
+    if (ppu && ppu->tap == this) ppu->tap = previousPpuTap;
+    bus = nullptr;
+    ppu = nullptr;
+}
+
+void Heatmap::Reset() {
+    for (auto& c : cpuCounts) c.assign(0x10000, 0);
+    for (auto& c : ppuCounts) c.assign(0x4000, 0);
+    current = FramePages{};
+    history.clear();
+}
+
+void Heatmap::EndFrame(uint64_t frame) {
+    current.frame = frame;
+    if (history.size() == HISTORY) history.pop_front();
+    history.push_back(current);
+    current = FramePages{};
+}
+
+bool Heatmap::Export(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to create heatmap file: " << path << std::endl;
+        return false;
+    }
+    HeatmapFileHeader header{};
+    std::memcpy(header.magic, HeatmapFileHeader::MAGIC, sizeof(header.magic));
+    header.cpuAddresses = 0x10000;
+    header.ppuAddresses = 0x4000;
+    header.frameRecordSize = sizeof(FramePages);
+    header.frames = static_cast<uint32_t>(history.size());
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& c : cpuCounts) out.write(reinterpret_cast<const char*>(c.data()), std::streamsize(c.size() * sizeof(uint64_t)));
+    for (const auto& c : ppuCounts) out.write(reinterpret_cast<const char*>(c.data()), std::streamsize(c.size() * sizeof(uint64_t)));
+    for (const FramePages& f : history) out.write(reinterpret_cast<const char*>(&f), sizeof(f));
+    if (!out) {
+        std::cerr << "Failed to write heatmap file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
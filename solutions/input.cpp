@@ -1,14 +1,5 @@
 #include "headers/input.h"
-#if defined(__has_include)
-#  if __has_include(<GLFW/glfw3.h>)
-#    include <GLFW/glfw3.h>
-#    define INPUT_HAVE_GLFW 1
-#  else
-#    define INPUT_HAVE_GLFW 0
-#  endif
-#else
-#  define INPUT_HAVE_GLFW 0
-#endif
+#include "headers/savestate.h"
 #include <cstring>
 #include <iostream>
 
@@ -78,23 +69,21 @@ uint8_t Input::Read(int port) {
     return bit | 0x40;
 }
 
-// Basic keyboard mapping:
-// Z -> A, X -> B, Right Shift -> Select, Enter -> Start
-// Arrow keys -> D-Pad
-void Input::PollFromGLFW(GLFWwindow* window) {
-#if INPUT_HAVE_GLFW
-    if (!window) return;
-    SetButton(0, BTN_A, glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS);
-    SetButton(0, BTN_B, glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS);
-    SetButton(0, BTN_SELECT, glfwGetKey(window, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS);
-    SetButton(0, BTN_START, glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS);
-    SetButton(0, BTN_UP, glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS);
-    SetButton(0, BTN_DOWN, glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS);
-    SetButton(0, BTN_LEFT, glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS);
-    SetButton(0, BTN_RIGHT, glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS);
-    // indicate that a poll occurred (helpful when GUI active)
-    static int pollCount = 0;
-#else
-    (void)window; // GLFW not available at compile-time: do nothing
-#endif
+void Input::SaveState(InputState& out) const {
+    for (int i = 0; i < 2; ++i) {
+        out.currState[i] = currState[i];
+        out.shiftReg[i] = shiftReg[i];
+        out.shiftIndex[i] = shiftIndex[i];
+    }
+    out.strobe = strobe ? 1 : 0;
+    out.pad[0] = out.pad[1] = out.pad[2] = 0;
+}
+
+void Input::LoadState(const InputState& in) {
+    for (int i = 0; i < 2; ++i) {
+        currState[i] = in.currState[i];
+        shiftReg[i] = in.shiftReg[i];
+        shiftIndex[i] = in.shiftIndex[i];
+    }
+    strobe = in.strobe != 0;
 }
@@ -0,0 +1,247 @@
+// Unit checks for the hand-vectorised kernels and the byte codecs. Every
+// vector kernel (RamSearchDetail, ObservationDetail, FingerprintDetail) runs
+// next to its scalar version on random inputs and must give identical
+// results; the zero-RLE and trace-store codecs must round-trip. Built once
+// against the default core and once more with the SSSE3 luma path compiled
+// in (kernel_tests_ssse3), so every path the sources contain is exercised.
+//
+// Usage: kernel_tests [seed]
+#include "headers/delta.h"
+#include "headers/fingerprint.h"
+#include "headers/observation.h"
+#include "headers/ramsearch.h"
+#include "headers/tracestore.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+size_t checks = 0;
+size_t failures = 0;
+
+bool Check(bool ok, const std::string& what) {
+    ++checks;
+    if (!ok && ++failures <= 20) std::printf("FAIL %s\n", what.c_str());
+    return ok;
+}
+
+std::vector<uint8_t> RandomBytes(std::mt19937_64& rng, size_t n) {
+    std::vector<uint8_t> v(n);
+    for (uint8_t& b : v) b = uint8_t(rng());
+    return v;
+}
+
+// Mostly zeros with runs of literals, like a state delta
+std::vector<uint8_t> SparseBytes(std::mt19937_64& rng, size_t n, unsigned density) {
+    std::vector<uint8_t> v(n, 0);
+    for (size_t i = 0; i < n;) {
+        size_t run = 1 + rng() % 24;
+        bool literal = rng() % 100 < density;
+        for (size_t k = 0; k < run && i < n; ++k, ++i) {
+            if (literal) v[i] = uint8_t(rng() % 4 ? rng() : 0);
+        }
+    }
+    return v;
+}
+
+void TestRamSearch(std::mt19937_64& rng) {
+    static const char* const OPS[] = {"==", "!=", "<", ">", "<=", ">=", "in", "changed by"};
+    for (int iter = 0; iter < 2000; ++iter) {
+        // Small value range so equal and neighbouring values are common
+        uint8_t cur[17], prev[17];
+        uint8_t range = iter % 2 ? 4 : 255;
+        for (int i = 0; i < 17; ++i) {
+            cur[i] = uint8_t(rng() % (range + 1u));
+            prev[i] = rng() % 3 ? cur[i] : uint8_t(rng() % (range + 1u));
+        }
+        for (int op = RamQuery::Equal; op <= RamQuery::ChangedBy; ++op) {
+            for (int mode = 0; mode < 8; ++mode) {
+                RamQuery q;
+                q.op = RamQuery::Op(op);
+                q.vsPrevious = mode & 1;
+                q.word = mode & 2;
+                q.bigEndian = mode & 4;
+                q.value = uint16_t(rng() % 2 ? rng() % (range + 1u) : rng());
+                q.high = uint16_t(q.value + rng() % 0x300);
+                uint32_t vec = RamSearchDetail::Match16(q, cur, prev);
+                uint32_t ref = RamSearchDetail::Match16Scalar(q, cur, prev);
+                char what[128];
+                std::snprintf(what, sizeof(what), "RamSearch %s %s%s%s value %u high %u: %04x, scalar %04x", OPS[op],
+                              q.vsPrevious ? "previous " : "", q.word ? "word " : "byte ",
+                              q.word ? (q.bigEndian ? "BE" : "LE") : "", q.value, q.high, vec, ref);
+                Check(vec == ref, what);
+            }
+        }
+    }
+}
+
+void TestObservationKernels(std::mt19937_64& rng) {
+    uint8_t luma[64];
+    for (uint8_t& l : luma) l = uint8_t(rng());
+    for (int n = 0; n <= 300; n += 1 + n / 16) {
+        // Full byte range: LumaRow must ignore the top two index bits
+        std::vector<uint8_t> src = RandomBytes(rng, size_t(n));
+        std::vector<uint8_t> vec(size_t(n) + 1, 0xCC), ref(size_t(n) + 1, 0xCC);
+        ObservationDetail::LumaRow(luma, src.data(), vec.data(), n);
+        ObservationDetail::LumaRowScalar(luma, src.data(), ref.data(), n);
+        Check(vec == ref, "LumaRow n=" + std::to_string(n));
+
+        std::vector<uint8_t> a = RandomBytes(rng, size_t(n)), b = RandomBytes(rng, size_t(n));
+        ObservationDetail::MaxBytes(a.data(), b.data(), vec.data(), size_t(n));
+        ObservationDetail::MaxBytesScalar(a.data(), b.data(), ref.data(), size_t(n));
+        Check(vec == ref, "MaxBytes n=" + std::to_string(n));
+    }
+}
+
+// Taps for the resize sizes an agent asks for, then BlendRows over each tap
+void TestResizeTaps(std::mt19937_64& rng) {
+    static const int SRC[] = {1, 7, 84, 224, 240, 256};
+    static const int DST[] = {1, 42, 84, 96, 224, 256, 300};
+    static const int WIDTHS[] = {1, 15, 16, 17, 84, 256};
+    for (int srcSize : SRC) {
+        for (int dstSize : DST) {
+            for (bool area : {false, true}) {
+                std::vector<ObservationPipeline::Tap> taps;
+                std::vector<uint16_t> weights;
+                ObservationPipeline::BuildTaps(srcSize, dstSize, area, taps, weights);
+                std::string name = std::to_string(srcSize) + "->" + std::to_string(dstSize) + (area ? " area" : " nearest");
+                if (!Check(int(taps.size()) == dstSize, "tap count " + name)) continue;
+
+                int width = WIDTHS[rng() % (sizeof(WIDTHS) / sizeof(WIDTHS[0]))];
+                std::vector<uint8_t> src = RandomBytes(rng, size_t(srcSize) * width);
+                std::vector<uint8_t> vec(static_cast<size_t>(width)), ref(static_cast<size_t>(width));
+                for (size_t i = 0; i < taps.size(); ++i) {
+                    const ObservationPipeline::Tap& t = taps[i];
+                    uint32_t sum = 0;
+                    for (int k = 0; k < t.count; ++k) sum += weights[t.offset + k];
+                    bool ok = t.count > 0 && t.first + t.count <= srcSize && t.offset + t.count <= weights.size() && sum == 256;
+                    if (!Check(ok, "tap " + std::to_string(i) + " of " + name)) continue;
+                    ObservationDetail::BlendRows(src.data(), width, t.first, t.count, &weights[t.offset], vec.data(), width);
+                    ObservationDetail::BlendRowsScalar(src.data(), width, t.first, t.count, &weights[t.offset], ref.data(), width);
+                    Check(vec == ref, "BlendRows tap " + std::to_string(i) + " of " + name + ", width " + std::to_string(width));
+                }
+            }
+        }
+    }
+}
+
+void TestFingerprint(std::mt19937_64& rng) {
+    static const size_t STRIPES[] = {0, 1, 15, 16, 17, 32, 33, 100};
+    for (size_t stripes : STRIPES) {
+        for (int iter = 0; iter < 20; ++iter) {
+            std::vector<uint8_t> data = RandomBytes(rng, stripes * 64);
+            uint64_t vec[8], ref[8];
+            for (int i = 0; i < 8; ++i) vec[i] = ref[i] = rng();
+            FingerprintDetail::AccumulateStripes(vec, data.data(), stripes);
+            FingerprintDetail::AccumulateStripesScalar(ref, data.data(), stripes);
+            Check(std::memcmp(vec, ref, sizeof(vec)) == 0, "AccumulateStripes stripes=" + std::to_string(stripes));
+        }
+    }
+}
+
+void TestZeroRle(std::mt19937_64& rng) {
+    static const size_t SIZES[] = {0, 1, 3, 4, 5, 8, 63, 64, 65, 1000, 20000};
+    for (size_t n : SIZES) {
+        for (unsigned density : {0u, 5u, 50u, 100u}) {
+            std::string name = "n=" + std::to_string(n) + " density " + std::to_string(density);
+            std::vector<uint8_t> in = SparseBytes(rng, n, density);
+            std::vector<uint8_t> enc;
+            size_t appended = ZeroRleEncode(in.data(), n, enc);
+            Check(appended == enc.size(), "ZeroRleEncode size " + name);
+
+            std::vector<uint8_t> out(n, 0xAA);
+            Check(ZeroRleDecode(enc.data(), enc.size(), out.data(), n) && out == in, "ZeroRle round trip " + name);
+
+            std::vector<uint8_t> base = RandomBytes(rng, n), expect(n);
+            XorBytes(base.data(), in.data(), expect.data(), n);
+            Check(ZeroRleDecodeXor(enc.data(), enc.size(), base.data(), n) && base == expect, "ZeroRleDecodeXor " + name);
+
+            if (!enc.empty()) {
+                Check(!ZeroRleDecode(enc.data(), enc.size() - 1, out.data(), n), "ZeroRle truncated input rejected " + name);
+            }
+        }
+    }
+}
+
+void TestTraceStore(std::mt19937_64& rng) {
+    // A few loops' worth of PCs so the predictor both hits and misses; more
+    // than one chunk so chunk boundaries are covered
+    std::vector<TraceRecord> records(TraceStoreWriter::CHUNK_RECORDS * 2 + 1234);
+    std::vector<std::vector<TraceWrite>> writesAfter(records.size());
+    uint32_t cycles = 7;
+    uint16_t pc = 0xC000;
+    for (size_t i = 0; i < records.size(); ++i) {
+        TraceRecord& r = records[i];
+        std::memset(&r, 0, sizeof(r));
+        r.pc = pc;
+        r.length = uint8_t(1 + rng() % 3);
+        for (uint8_t& b : r.bytes) b = uint8_t(rng() % 4 ? rng() : 0);
+        r.a = uint8_t(rng() % 8);
+        r.x = uint8_t(i);
+        r.y = uint8_t(rng());
+        r.p = 0x24;
+        r.sp = 0xFD;
+        r.flags = TraceRecord::FLAG_CYCLES;
+        r.cycles = cycles;
+        cycles += 2 + uint32_t(rng() % 6);
+        pc = rng() % 16 ? uint16_t(pc + r.length) : uint16_t(0xC000 + (rng() % 64) * 4);
+        if (rng() % 5 == 0) writesAfter[i].push_back({0, uint16_t(rng()), uint8_t(rng()), 0});
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "kernel_tests.nts").string();
+    TraceStoreWriter writer;
+    if (!Check(writer.Open(path), "TraceStoreWriter::Open " + path)) return;
+    for (size_t i = 0; i < records.size(); ++i) {
+        writer.OnInstruction(records[i]);
+        for (const TraceWrite& w : writesAfter[i]) writer.OnCPUWrite(w.addr, w.value);
+    }
+    Check(writer.Close(), "TraceStoreWriter::Close");
+
+    TraceStoreReader reader;
+    if (Check(reader.Open(path), "TraceStoreReader::Open") &&
+        Check(reader.Instructions() == records.size() && reader.Chunks() == 3, "trace store counts")) {
+        size_t next = 0;
+        bool same = true;
+        std::vector<TraceRecord> chunkRecords;
+        std::vector<TraceWrite> chunkWrites;
+        std::vector<uint32_t> frameStarts;
+        for (size_t c = 0; c < reader.Chunks() && same; ++c) {
+            if (!Check(reader.ReadChunk(c, chunkRecords, chunkWrites, frameStarts), "ReadChunk " + std::to_string(c))) {
+                same = false;
+                break;
+            }
+            size_t w = 0;
+            for (size_t i = 0; i < chunkRecords.size() && same; ++i, ++next) {
+                same = next < records.size() && std::memcmp(&chunkRecords[i], &records[next], sizeof(TraceRecord)) == 0;
+                for (const TraceWrite& expect : writesAfter[next]) {
+                    same = same && w < chunkWrites.size() && chunkWrites[w].instruction == i &&
+                           chunkWrites[w].addr == expect.addr && chunkWrites[w].value == expect.value;
+                    ++w;
+                }
+            }
+            same = same && w == chunkWrites.size();
+        }
+        Check(same && next == records.size(), "trace store round trip");
+    }
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+}
+
+int main(int argc, char** argv) {
+    uint64_t seed = argc > 1 ? std::stoull(argv[1]) : 0x6502;
+    std::mt19937_64 rng(seed);
+    TestRamSearch(rng);
+    TestObservationKernels(rng);
+    TestResizeTaps(rng);
+    TestFingerprint(rng);
+    TestZeroRle(rng);
+    TestTraceStore(rng);
+    std::printf("%zu/%zu kernel checks passed (seed %llu)\n", checks - failures, checks,
+                static_cast<unsigned long long>(seed));
+    return failures == 0 ? 0 : 1;
+}
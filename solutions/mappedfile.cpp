@@ -0,0 +1,67 @@
+#include "headers/mappedfile.h"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPEDFILE_HAVE_MMAP 1
+#else
+#define MAPPEDFILE_HAVE_MMAP 0
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+#if MAPPEDFILE_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size = static_cast<size_t>(st.st_size);
+    if (size > 0) {
+        void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            size = 0;
+            return false;
+        }
+        data = static_cast<const uint8_t*>(p);
+        mapped = true;
+    }
+    ::close(fd); // the mapping stays valid after close
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    size = static_cast<size_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+    fallback.resize(size);
+    file.read(reinterpret_cast<char*>(fallback.data()), size);
+    if (!file) {
+        fallback.clear();
+        size = 0;
+        return false;
+    }
+    data = fallback.data();
+#endif
+    opened = true;
+    return true;
+}
+
+void MappedFile::Close() {
+#if MAPPEDFILE_HAVE_MMAP
+    if (mapped && data) munmap(const_cast<uint8_t*>(data), size);
+#endif
+    fallback.clear();
+    data = nullptr;
+    size = 0;
+    opened = false;
+    mapped = false;
+}
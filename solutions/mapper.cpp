@@ -1,12 +1,21 @@
 #include "headers/mapper.h"
 #include "headers/bus.h"
 #include "headers/cpu.h"
+#include "headers/savestate.h"
 #include <cstring>
 #include <iostream>
 #include <cstdio>
 
-static bool g_mapperVerbose = false; // set true to enable detailed mapper logs
-static bool g_mapperIRQLog = true;    // set true to enable IRQ-specific logs
+
+void Mapper::SaveState(MapperState& out) const {
+    std::memset(&out, 0, sizeof(out));
+    out.mapperId = static_cast<uint16_t>(number);
+    out.mirroring = static_cast<uint8_t>(mirroring);
+}
+
+void Mapper::LoadState(const MapperState& in) {
+    mirroring = static_cast<Mirroring>(in.mirroring);
+}
 
 // Minimal MMC3 (Mapper 4) implementation. This supports PRG/CHR bank switching and IRQ scanline counting
 // sufficiently for many games (including SMB) in a basic form.
@@ -62,13 +71,13 @@ public:
                 chrMode = value & 0x80;
 
 
-                if (g_mapperVerbose) std::cout << "Mapper4: bank select=" << int(bankSelect)
+                if (verbose) std::cout << "Mapper4: bank select=" << int(bankSelect)
                           << " prgMode=" << prgMode << " chrMode=" << chrMode << std::endl;
             } else {
                 // bank data
                 if (bankSelect < 8) {
                     bankRegs[bankSelect] = value;
-                    if (g_mapperVerbose) std::cout << "Mapper4: bank data reg[" << int(bankSelect) << "] = " << int(value) << std::endl;
+                    if (verbose) std::cout << "Mapper4: bank data reg[" << int(bankSelect) << "] = " << int(value) << std::endl;
                 } else {
                     std::cout << "Mapper4: bank data reg[" << int(bankSelect) << "] OUT OF RANGE!" << std::endl;
                 }
@@ -80,20 +89,20 @@ public:
                 // mirroring
                 bus->mirrorVertical = (value & 1) != 0;
                 mirroring = bus->mirrorVertical ? Mirroring::Vertical : Mirroring::Horizontal;
-                if (g_mapperVerbose) std::cout << "Mapper4: mirroring set to " << (bus->mirrorVertical ? "vertical" : "horizontal") << std::endl;
+                if (verbose) std::cout << "Mapper4: mirroring set to " << (bus->mirrorVertical ? "vertical" : "horizontal") << std::endl;
             } else {
                 // PRG RAM protect - ignored for now
-                if (g_mapperVerbose) std::cout << "Mapper4: PRG RAM protect write ignored" << std::endl;
+                if (verbose) std::cout << "Mapper4: PRG RAM protect write ignored" << std::endl;
             }
             return;
         }
         if (addr >= 0xC000 && addr <= 0xDFFF) {
             if ((addr & 1) == 0) {
                 irqLatch = value;
-                if (g_mapperIRQLog) std::cout << "Mapper4: IRQ latch set to " << int(value) << std::endl;
+                if (irqLog) std::cout << "Mapper4: IRQ latch set to " << int(value) << std::endl;
             } else {
                 irqReload = true;
-                if (g_mapperIRQLog) std::cout << "Mapper4: IRQ reload triggered" << std::endl;
+                if (irqLog) std::cout << "Mapper4: IRQ reload triggered" << std::endl;
             }
             return;
         }
@@ -102,10 +111,10 @@ public:
                 // disable
                 bus->irqEnable = false;
                 if (bus && bus->cpu) bus->cpu->Interrupt = false;
-                if (g_mapperIRQLog) std::cout << "Mapper4: IRQ disabled" << std::endl;
+                if (irqLog) std::cout << "Mapper4: IRQ disabled" << std::endl;
             } else {
                 bus->irqEnable = true;
-                if (g_mapperIRQLog) std::cout << "Mapper4: IRQ enabled" << std::endl;
+                if (irqLog) std::cout << "Mapper4: IRQ enabled" << std::endl;
             }
             return;
         }
@@ -221,6 +230,39 @@ public:
         if (abs < bus->chrRom.size()) bus->chrRom[abs] = value;
     }
 
+    uint32_t PRGBankForSlot(uint32_t slot) const {
+        uint32_t lastBank = (uint32_t)prgBankCount - 1;
+        uint32_t secondLast = (uint32_t)prgBankCount - 2;
+
+        if (!prgMode) {
+            switch (slot) {
+                case 0: return bankRegs[6]; // $8000
+                case 1: return bankRegs[7]; // $A000
+                case 2: return secondLast;  // $C000
+                default: return lastBank;   // $E000
+            }
+        }
+        switch (slot) {
+            case 0: return secondLast;
+            case 1: return bankRegs[7];
+            case 2: return bankRegs[6];
+            default: return lastBank;
+        }
+    }
+
+    int PRGBank(uint16_t addr) const override {
+        if (addr < 0x8000 || prgBankCount == 0) return -1;
+        uint32_t bank = PRGBankForSlot((addr - 0x8000) / 0x2000);
+        return int(bank < prgBankCount ? bank : prgBankCount - 1);
+    }
+
+    int CHRBank(uint16_t addr) const override {
+        // Mode 1 swaps the 2KB (r0/r1) and 1KB (r2-r5) halves
+        uint32_t slot = ((addr & 0x1FFF) >> 10) ^ (chrMode ? 4 : 0);
+        if (slot < 4) return int((bankRegs[slot >> 1] & 0xFE) | (slot & 1));
+        return int(bankRegs[slot - 2]);
+    }
+
     uint8_t ReadPRG(uint16_t addr) {
         // PRG banks are 8KB units
         uint32_t bank = 0;
@@ -230,23 +272,7 @@ public:
         uint32_t inner = rel & 0x1FFF;
 
         uint32_t lastBank = (uint32_t)prgBankCount - 1;
-        uint32_t secondLast = (uint32_t)prgBankCount - 2;
-
-        if (!prgMode) {
-            switch (slot) {
-                case 0: bank = bankRegs[6]; break; // $8000
-                case 1: bank = bankRegs[7]; break; // $A000
-                case 2: bank = secondLast; break;  // $C000
-                case 3: bank = lastBank; break;    // $E000
-            }
-        } else {
-            switch (slot) {
-                case 0: bank = secondLast; break;
-                case 1: bank = bankRegs[7]; break;
-                case 2: bank = bankRegs[6]; break;
-                case 3: bank = lastBank; break;
-            }
-        }
+        bank = PRGBankForSlot(slot);
 
         // Bounds check for PRG bank
         if (bank >= prgBankCount) {
@@ -255,7 +281,7 @@ public:
         }
 
         uint32_t absAddr = bank * 0x2000 + inner;
-        if (addr >= 0xFF00) {
+        if (verbose && addr >= 0xFF00) {
             std::cout << "Mapper4: ReadPRG addr=0x" << std::hex << addr << " slot=" << std::dec << slot
                       << " bank=" << bank << " absAddr=0x" << std::hex << absAddr << std::dec << std::endl;
         }
@@ -283,6 +309,8 @@ uint8_t ReadCHRBank(uint32_t bankIndex, uint32_t offset) {
 }
 
 
+    bool WantsPPUAddr() const override { return true; }
+
     void OnPPUAddr(uint16_t addr, uint32_t cycles) override {
         // detect rising edge of A12 (bit 12 of addr)
         bool a12 = (addr & 0x1000) != 0;
@@ -296,7 +324,7 @@ uint8_t ReadCHRBank(uint32_t bankIndex, uint32_t offset) {
                 --irqCounter;
             }
             // Log sparingly: focus on IRQ events
-            if ((a12EdgeCount & 31) == 0 && g_mapperVerbose) {
+            if ((a12EdgeCount & 31) == 0 && verbose) {
                 std::cout << "Mapper4: A12 rising edge #" << a12EdgeCount
                           << " irqCounter=" << int(irqCounter)
                           << " irqLatch=" << int(irqLatch)
@@ -306,13 +334,45 @@ uint8_t ReadCHRBank(uint32_t bankIndex, uint32_t offset) {
                 // Request IRQ on CPU
                 if (bus && bus->cpu) {
                     bus->cpu->Interrupt = true;
-                    if (g_mapperIRQLog) std::cout << "Mapper4: IRQ asserted (edgeCount=" << a12EdgeCount << ")" << std::endl;
+                    if (irqLog) std::cout << "Mapper4: IRQ asserted (edgeCount=" << a12EdgeCount << ")" << std::endl;
                 }
             }
         }
         prevA12 = a12;
     }
 
+    void SaveState(MapperState& out) const override {
+        std::memcpy(out.prgRam, prgRam.data(), sizeof(out.prgRam));
+        out.a12HighCycles = a12HighCycles;
+        out.a12EdgeCount = a12EdgeCount;
+        out.mapperId = static_cast<uint16_t>(number);
+        std::memcpy(out.regs, bankRegs, sizeof(out.regs));
+        out.bankSelect = bankSelect;
+        out.prgMode = prgMode ? 1 : 0;
+        out.chrMode = chrMode ? 1 : 0;
+        out.irqLatch = irqLatch;
+        out.irqCounter = irqCounter;
+        out.irqReload = irqReload ? 1 : 0;
+        out.prevA12 = prevA12 ? 1 : 0;
+        out.mirroring = static_cast<uint8_t>(mirroring);
+        std::memset(out.pad, 0, sizeof(out.pad));
+    }
+
+    void LoadState(const MapperState& in) override {
+        std::memcpy(prgRam.data(), in.prgRam, sizeof(in.prgRam));
+        a12HighCycles = in.a12HighCycles;
+        a12EdgeCount = in.a12EdgeCount;
+        std::memcpy(bankRegs, in.regs, sizeof(bankRegs));
+        bankSelect = in.bankSelect;
+        prgMode = in.prgMode != 0;
+        chrMode = in.chrMode != 0;
+        irqLatch = in.irqLatch;
+        irqCounter = in.irqCounter;
+        irqReload = in.irqReload != 0;
+        prevA12 = in.prevA12 != 0;
+        mirroring = static_cast<Mirroring>(in.mirroring);
+    }
+
     // Debug helper
     std::string DebugString() const override {
         char buf[256];
@@ -325,10 +385,14 @@ class Mapper0 : public Mapper {
 
 public:
     size_t prgBanks = 0;
+    // 8KB work RAM at $6000. Not on retail NROM boards, but test ROMs report
+    // their results there and Family BASIC style carts expect it.
+    std::vector<uint8_t> prgRam;
 
     Mapper0(Bus* b, size_t prgSize) {
         bus = b;
         prgBanks = prgSize / 0x4000;
+        prgRam.resize(0x2000);
         mirroring = (bus && bus->mirrorVertical) ? Mirroring::Vertical : Mirroring::Horizontal;
     }
 
@@ -340,11 +404,17 @@ public:
             }
             return bus->prgRom[mapped];
         }
-        return 0;
+        return prgRam[addr & 0x1FFF];
     }
 
-    void CPUWrite(uint16_t, uint8_t) override {
-        // NROM is read-only
+    int PRGBank(uint16_t addr) const override {
+        if (addr < 0x8000) return -1;
+        return ((prgBanks == 1 ? addr & 0x3FFF : addr - 0x8000) >> 13);
+    }
+
+    void CPUWrite(uint16_t addr, uint8_t value) override {
+        // PRG ROM is read-only
+        if (addr < 0x8000) prgRam[addr & 0x1FFF] = value;
     }
 
     uint8_t CHRRead(uint16_t addr) override {
@@ -364,15 +434,27 @@ public:
     Mirroring GetMirroring() const override {
         return mirroring;
     }
+
+    void SaveState(MapperState& out) const override {
+        Mapper::SaveState(out);
+        std::memcpy(out.prgRam, prgRam.data(), sizeof(out.prgRam));
+    }
+
+    void LoadState(const MapperState& in) override {
+        Mapper::LoadState(in);
+        std::memcpy(prgRam.data(), in.prgRam, sizeof(in.prgRam));
+    }
 };
 
 Mapper* CreateMapperFor(Bus* bus, int mapperNumber, size_t prgSize, size_t chrSize) {
+    Mapper* m = nullptr;
     if (mapperNumber == 0) {
-    return new Mapper0(bus, prgSize);
-}
-if (mapperNumber == 4) {
-    return new Mapper4(bus, prgSize, chrSize);
-}
-return nullptr;
+        m = new Mapper0(bus, prgSize);
+    }
+    if (mapperNumber == 4) {
+        m = new Mapper4(bus, prgSize, chrSize);
+    }
+    if (m) m->number = mapperNumber;
+    return m;
 
 }
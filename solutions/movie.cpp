@@ -0,0 +1,149 @@
+#include "headers/movie.h"
+#include "headers/cpu.h"
+#include "headers/delta.h"
+#include "headers/mappedfile.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+void Movie::Clear() {
+    romHash = 0;
+    fromSnapshot = false;
+    inputs.clear();
+}
+
+void Movie::AddFrame(uint8_t pad0, uint8_t pad1) {
+    inputs.push_back(pad0);
+    inputs.push_back(pad1);
+}
+
+void Movie::StartRecording(const CPU& cpu, const Bus& bus, u32 cycles) {
+    Clear();
+    romHash = bus.romHash;
+    fromSnapshot = true;
+    Snapshot(cpu, bus, cycles, start);
+}
+
+void Movie::RecordFrame(const Bus& bus) {
+    AddFrame(bus.input.GetButtons(0), bus.input.GetButtons(1));
+}
+
+bool Movie::StartPlayback(CPU& cpu, Bus& bus, u32& cycles) const {
+    if (romHash != 0 && bus.romHash != romHash) {
+        std::cerr << "Movie was recorded on a different ROM" << std::endl;
+        return false;
+    }
+    if (!fromSnapshot) return true;
+    return Restore(cpu, bus, cycles, start);
+}
+
+void Movie::ApplyFrame(size_t frame, Bus& bus) const {
+    bus.input.SetButtons(0, Pad(frame, 0));
+    bus.input.SetButtons(1, Pad(frame, 1));
+}
+
+bool Movie::Save(const std::string& path) const {
+    std::vector<uint8_t> packed;
+    if (fromSnapshot) ZeroRleEncode(reinterpret_cast<const uint8_t*>(&start), sizeof(MachineState), packed);
+
+    MovieHeader h{};
+    std::memcpy(h.magic, MovieHeader::MAGIC, sizeof(h.magic));
+    h.version = MovieHeader::VERSION;
+    h.flags = fromSnapshot ? MovieHeader::FLAG_FROM_SNAPSHOT : 0;
+    h.romHash = romHash;
+    h.frameCount = static_cast<uint32_t>(Frames());
+    h.startSize = static_cast<uint32_t>(packed.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to write movie: " << path << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    file.write(reinterpret_cast<const char*>(packed.data()), packed.size());
+    file.write(reinterpret_cast<const char*>(inputs.data()), inputs.size());
+    return bool(file);
+}
+
+bool Movie::Load(const std::string& path) {
+    MappedFile file;
+    if (!file.Open(path) || file.Size() < sizeof(MovieHeader)) {
+        std::cerr << "Failed to open movie: " << path << std::endl;
+        return false;
+    }
+    MovieHeader h;
+    std::memcpy(&h, file.Data(), sizeof(h));
+    if (std::memcmp(h.magic, MovieHeader::MAGIC, sizeof(h.magic)) != 0 || h.version != MovieHeader::VERSION) {
+        std::cerr << "Not a supported movie file: " << path << std::endl;
+        return false;
+    }
+    size_t inputBytes = size_t(h.frameCount) * 2;
+    if (file.Size() - sizeof(MovieHeader) < size_t(h.startSize) + inputBytes) {
+        std::cerr << "Truncated movie file: " << path << std::endl;
+        return false;
+    }
+
+    const uint8_t* p = file.Data() + sizeof(MovieHeader);
+    Clear();
+    romHash = h.romHash;
+    fromSnapshot = (h.flags & MovieHeader::FLAG_FROM_SNAPSHOT) != 0;
+    if (fromSnapshot && !ZeroRleDecode(p, h.startSize, reinterpret_cast<uint8_t*>(&start), sizeof(MachineState))) {
+        std::cerr << "Corrupt start state in movie: " << path << std::endl;
+        return false;
+    }
+    p += h.startSize;
+    inputs.assign(p, p + inputBytes);
+    return true;
+}
+
+bool Movie::ImportFM2(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open FM2 movie: " << path << std::endl;
+        return false;
+    }
+    Clear();
+
+    // Frame lines look like "|cmd|RLDUTSBA|RLDUTSBA||"; a pressed button is any
+    // character other than '.' or ' ', and column i maps to Input bit 7-i.
+    auto parsePad = [](const std::string& field) {
+        uint8_t bits = 0;
+        for (size_t i = 0; i < field.size() && i < 8; ++i) {
+            if (field[i] != '.' && field[i] != ' ') bits |= uint8_t(1 << (7 - i));
+        }
+        return bits;
+    };
+
+    std::string line;
+    bool warnedCommand = false;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        if (line[0] != '|') {
+            if (line.compare(0, 7, "binary ") == 0 && line.substr(7) != "0" && line.substr(7) != "false") {
+                std::cerr << "Binary FM2 movies are not supported: " << path << std::endl;
+                return false;
+            }
+            continue; // header key/value
+        }
+
+        std::vector<std::string> fields;
+        std::stringstream ss(line.substr(1));
+        std::string field;
+        while (std::getline(ss, field, '|')) fields.push_back(field);
+        if (fields.empty()) continue;
+
+        int command = std::atoi(fields[0].c_str());
+        if (command != 0 && Frames() > 0 && !warnedCommand) {
+            std::cerr << "FM2 reset/power commands after frame 0 are ignored" << std::endl;
+            warnedCommand = true;
+        }
+        uint8_t pad0 = fields.size() > 1 ? parsePad(fields[1]) : 0;
+        uint8_t pad1 = fields.size() > 2 ? parsePad(fields[2]) : 0;
+        AddFrame(pad0, pad1);
+    }
+    return true;
+}
@@ -0,0 +1,248 @@
+#include "headers/netplay.h"
+#include "headers/cpu.h"
+#include "headers/hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef int socklen_t;
+typedef SOCKET NativeSocket;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int NativeSocket;
+#endif
+
+static_assert(sizeof(sockaddr_storage) <= 128, "peer address buffer too small");
+
+namespace {
+#ifdef _WIN32
+bool EnsureWinsock() {
+    static bool ok = [] {
+        WSADATA wsa;
+        return WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+    }();
+    return ok;
+}
+#endif
+
+// Packet layout (little-endian):
+//   u32 magic, u32 firstFrame, u32 ackNext, u32 checkFrame, u64 checkHash,
+//   u8 count, u8 inputs[count] for frames firstFrame..firstFrame+count-1
+constexpr uint32_t PACKET_MAGIC = 0x594C504E; // "NPLY"
+constexpr size_t PACKET_HEADER = 25;
+
+void Put32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+uint32_t Get32(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+void Put64(uint8_t* p, uint64_t v) {
+    Put32(p, static_cast<uint32_t>(v));
+    Put32(p + 4, static_cast<uint32_t>(v >> 32));
+}
+
+uint64_t Get64(const uint8_t* p) {
+    return uint64_t(Get32(p)) | (uint64_t(Get32(p + 4)) << 32);
+}
+}
+
+// ---------------------------------------------------------------------------
+// UdpSocket
+
+UdpSocket::~UdpSocket() {
+    if (fd < 0) return;
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(fd));
+#else
+    close(static_cast<int>(fd));
+#endif
+}
+
+bool UdpSocket::Bind(uint16_t port) {
+#ifdef _WIN32
+    if (!EnsureWinsock()) return false;
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) return false;
+    u_long nonBlocking = 1;
+    ioctlsocket(s, FIONBIO, &nonBlocking);
+    fd = static_cast<intptr_t>(s);
+#else
+    int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s < 0) return false;
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+    fd = s;
+#endif
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(static_cast<NativeSocket>(fd), reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "UdpSocket: cannot bind port " << port << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UdpSocket::SetPeer(const std::string& host, uint16_t port) {
+#ifdef _WIN32
+    if (!EnsureWinsock()) return false;
+#endif
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* res = nullptr;
+    std::string service = std::to_string(port);
+    if (getaddrinfo(host.c_str(), service.c_str(), &hints, &res) != 0 || !res) {
+        std::cerr << "UdpSocket: cannot resolve " << host << std::endl;
+        return false;
+    }
+    std::memcpy(peer, res->ai_addr, res->ai_addrlen);
+    peerLen = static_cast<uint32_t>(res->ai_addrlen);
+    freeaddrinfo(res);
+    return true;
+}
+
+bool UdpSocket::Send(const void* data, size_t len) {
+    if (fd < 0 || peerLen == 0) return false;
+    auto n = sendto(static_cast<NativeSocket>(fd), static_cast<const char*>(data), static_cast<int>(len), 0,
+                    reinterpret_cast<const sockaddr*>(peer), static_cast<socklen_t>(peerLen));
+    return n == static_cast<decltype(n)>(len);
+}
+
+int UdpSocket::Receive(void* buf, size_t cap) {
+    if (fd < 0) return -1;
+    auto n = recvfrom(static_cast<NativeSocket>(fd), static_cast<char*>(buf), static_cast<int>(cap), 0,
+                      nullptr, nullptr);
+    return n < 0 ? -1 : static_cast<int>(n);
+}
+
+// ---------------------------------------------------------------------------
+// RollbackSession
+
+RollbackSession::RollbackSession(CPU& cpu, Bus& bus, u32& cycles, UdpSocket& socket, int localPlayer)
+    : cpu(cpu), bus(bus), cycles(cycles), socket(socket), localPlayer(localPlayer ? 1 : 0) {}
+
+bool RollbackSession::AdvanceFrame(uint8_t localInput) {
+    Poll();
+    if (int64_t(frame) > remoteConfirmed + MAX_ROLLBACK) return false;
+
+    FrameRecord& rec = history[frame % HISTORY];
+    rec.frame = frame;
+    rec.local = localInput;
+    rec.remoteUsed = PredictRemote(frame);
+    Simulate(rec);
+    ++frame;
+    Send();
+    return true;
+}
+
+void RollbackSession::Poll() {
+    Receive();
+    if (rollbackFrom >= 0) {
+        uint32_t from = static_cast<uint32_t>(rollbackFrom);
+        rollbackFrom = -1;
+        Restore(cpu, bus, cycles, history[from % HISTORY].start);
+        for (uint32_t f = from; f < frame; ++f) {
+            FrameRecord& rec = history[f % HISTORY];
+            rec.remoteUsed = PredictRemote(f);
+            // Only the newest re-simulated frame is shown
+            Simulate(rec, f + 1 == frame);
+            ++resimulated;
+        }
+        ++rollbacks;
+    }
+    CheckConfirmedHash();
+    Send();
+}
+
+uint8_t RollbackSession::PredictRemote(uint32_t f) const {
+    const RemoteInput& r = remote[f % HISTORY];
+    return r.frame == f ? r.value : lastRemote;
+}
+
+void RollbackSession::Simulate(FrameRecord& rec, bool render) {
+    Snapshot(cpu, bus, cycles, rec.start);
+    bus.input.SetButtons(localPlayer, rec.local);
+    bus.input.SetButtons(1 - localPlayer, rec.remoteUsed);
+    cpu.RunFrame(cycles, bus, render);
+}
+
+void RollbackSession::Receive() {
+    uint8_t buf[PACKET_HEADER + 255];
+    int n;
+    while ((n = socket.Receive(buf, sizeof(buf))) >= 0) {
+        if (n < int(PACKET_HEADER) || Get32(buf) != PACKET_MAGIC) continue;
+        uint32_t first = Get32(buf + 4);
+        uint32_t ackNext = Get32(buf + 8);
+        uint32_t count = buf[24];
+        if (n < int(PACKET_HEADER + count)) continue;
+
+        remoteAck = std::max(remoteAck, int64_t(ackNext) - 1);
+        peerCheckFrame = Get32(buf + 12);
+        peerCheckHash = Get64(buf + 16);
+
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t f = first + i;
+            if (int64_t(f) <= remoteConfirmed) continue;
+            if (f >= frame + HISTORY) break; // peer cannot legitimately be this far ahead
+            remote[f % HISTORY] = {f, buf[PACKET_HEADER + i]};
+            const FrameRecord& rec = history[f % HISTORY];
+            if (f < frame && rec.frame == f && rec.remoteUsed != buf[PACKET_HEADER + i]) {
+                if (rollbackFrom < 0 || int64_t(f) < rollbackFrom) rollbackFrom = f;
+            }
+        }
+        while (remote[(remoteConfirmed + 1) % HISTORY].frame == uint32_t(remoteConfirmed + 1)) {
+            ++remoteConfirmed;
+            lastRemote = remote[remoteConfirmed % HISTORY].value;
+        }
+    }
+}
+
+void RollbackSession::CheckConfirmedHash() {
+    // The start state of frame C is final once every input before C is known
+    if (frame == 0) return;
+    uint32_t c = static_cast<uint32_t>(std::min<int64_t>(remoteConfirmed + 1, frame - 1));
+    if (c != checkFrame) {
+        checkFrame = c;
+        checkHash = Hash64(&history[c % HISTORY].start, sizeof(MachineState));
+    }
+
+    if (peerCheckFrame == UINT32_MAX || peerCheckFrame == lastComparedFrame) return;
+    if (peerCheckFrame > c || frame - peerCheckFrame >= HISTORY) return;
+    const FrameRecord& rec = history[peerCheckFrame % HISTORY];
+    if (rec.frame != peerCheckFrame) return;
+    lastComparedFrame = peerCheckFrame;
+    uint64_t h = peerCheckFrame == checkFrame ? checkHash : Hash64(&rec.start, sizeof(MachineState));
+    if (h != peerCheckHash) {
+        ++desyncs;
+        std::cerr << "Netplay: desync at frame " << peerCheckFrame << std::endl;
+    }
+}
+
+void RollbackSession::Send() {
+    uint8_t buf[PACKET_HEADER + MAX_INPUTS_PER_PACKET];
+    uint32_t first = static_cast<uint32_t>(std::max<int64_t>(remoteAck + 1, int64_t(frame) - MAX_INPUTS_PER_PACKET));
+    uint32_t count = first < frame ? frame - first : 0;
+
+    Put32(buf, PACKET_MAGIC);
+    Put32(buf + 4, first);
+    Put32(buf + 8, static_cast<uint32_t>(remoteConfirmed + 1));
+    Put32(buf + 12, checkFrame);
+    Put64(buf + 16, checkHash);
+    buf[24] = static_cast<uint8_t>(count);
+    for (uint32_t i = 0; i < count; ++i) buf[PACKET_HEADER + i] = history[(first + i) % HISTORY].local;
+    socket.Send(buf, PACKET_HEADER + count);
+}
@@ -0,0 +1,200 @@
+#include "headers/observation.h"
+#include "headers/ppu.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OBSERVATION_SSE2 1
+#else
+#define OBSERVATION_SSE2 0
+#endif
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define OBSERVATION_SSSE3 1
+#else
+#define OBSERVATION_SSSE3 0
+#endif
+
+namespace {
+constexpr int FRAME_W = 256;
+constexpr int FRAME_H = 240;
+}
+
+namespace ObservationDetail {
+void LumaRowScalar(const uint8_t* luma, const uint8_t* src, uint8_t* dst, int n) {
+    for (int x = 0; x < n; ++x) dst[x] = luma[src[x] & 0x3F];
+}
+
+void LumaRow(const uint8_t* luma, const uint8_t* src, uint8_t* dst, int n) {
+    int x = 0;
+#if OBSERVATION_SSSE3
+    // 64-entry lookup as four 16-entry shuffles selected by the top index bits
+    __m128i table[4];
+    for (int t = 0; t < 4; ++t) table[t] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(luma + 16 * t));
+    const __m128i low = _mm_set1_epi8(0x0F);
+    for (; x + 16 <= n; x += 16) {
+        __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        __m128i lo = _mm_and_si128(idx, low);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(idx, 4), _mm_set1_epi8(0x03));
+        __m128i out = _mm_setzero_si128();
+        for (int t = 0; t < 4; ++t) {
+            __m128i pick = _mm_cmpeq_epi8(hi, _mm_set1_epi8(static_cast<char>(t)));
+            out = _mm_or_si128(out, _mm_and_si128(pick, _mm_shuffle_epi8(table[t], lo)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), out);
+    }
+#endif
+    LumaRowScalar(luma, src + x, dst + x, n - x);
+}
+
+void MaxBytesScalar(const uint8_t* a, const uint8_t* b, uint8_t* dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] = std::max(a[i], b[i]);
+}
+
+void MaxBytes(const uint8_t* a, const uint8_t* b, uint8_t* dst, size_t n) {
+    size_t i = 0;
+#if OBSERVATION_SSE2
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_max_epu8(va, vb));
+    }
+#endif
+    MaxBytesScalar(a + i, b + i, dst + i, n - i);
+}
+
+void BlendRowsScalar(const uint8_t* src, int stride, int first, int count, const uint16_t* weights, uint8_t* dst, int n) {
+    for (int x = 0; x < n; ++x) {
+        uint32_t acc = 128;
+        for (int t = 0; t < count; ++t) acc += uint32_t(src[(first + t) * stride + x]) * weights[t];
+        dst[x] = static_cast<uint8_t>(acc >> 8);
+    }
+}
+
+void BlendRows(const uint8_t* src, int stride, int first, int count, const uint16_t* weights, uint8_t* dst, int n) {
+    int x = 0;
+#if OBSERVATION_SSE2
+    // Weights sum to 256, so a 16-bit lane holds at most 255 * 256
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(128);
+    for (; x + 16 <= n; x += 16) {
+        __m128i accLo = round, accHi = round;
+        for (int t = 0; t < count; ++t) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (first + t) * stride + x));
+            __m128i w = _mm_set1_epi16(static_cast<short>(weights[t]));
+            accLo = _mm_add_epi16(accLo, _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), w));
+            accHi = _mm_add_epi16(accHi, _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), w));
+        }
+        __m128i out = _mm_packus_epi16(_mm_srli_epi16(accLo, 8), _mm_srli_epi16(accHi, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), out);
+    }
+#endif
+    BlendRowsScalar(src + x, stride, first, count, weights, dst + x, n - x);
+}
+}
+
+ObservationPipeline::ObservationPipeline(const ObservationConfig& cfg) : config(cfg) {
+    config.stack = std::max(1, config.stack);
+    srcW = FRAME_W - config.cropLeft - config.cropRight;
+    srcH = FRAME_H - config.cropTop - config.cropBottom;
+    valid = config.cropLeft >= 0 && config.cropRight >= 0 && config.cropTop >= 0 && config.cropBottom >= 0 &&
+            srcW > 0 && srcH > 0 && config.width > 0 && config.height > 0;
+    if (!valid) return;
+
+    // ITU-R BT.601 luma of the output palette
+    for (int i = 0; i < 64; ++i) {
+        uint32_t c = PPU::ColorOf(static_cast<uint8_t>(i));
+        uint32_t r = (c >> 16) & 0xFF, g = (c >> 8) & 0xFF, b = c & 0xFF;
+        luma[i] = static_cast<uint8_t>((299 * r + 587 * g + 114 * b + 500) / 1000);
+    }
+    BuildTaps(srcH, config.height, config.area, rowTaps, rowWeights);
+    BuildTaps(srcW, config.width, config.area, colTaps, colWeights);
+
+    for (auto& f : frames) f.resize(size_t(srcW) * srcH);
+    pooled.resize(size_t(srcW) * srcH);
+    columnPass.resize(size_t(srcW) * config.height);
+    history.resize(ObservationBytes());
+    Reset();
+}
+
+void ObservationPipeline::BuildTaps(int srcSize, int dstSize, bool area, std::vector<Tap>& taps, std::vector<uint16_t>& weights) {
+    taps.clear();
+    weights.clear();
+    double scale = double(srcSize) / dstSize;
+    for (int i = 0; i < dstSize; ++i) {
+        Tap tap{0, 0, uint32_t(weights.size())};
+        if (!area) {
+            tap.first = static_cast<uint16_t>(std::min(srcSize - 1, int((i + 0.5) * scale)));
+            tap.count = 1;
+            weights.push_back(256);
+        } else {
+            // Source cells overlapping [i, i+1) * scale, weighted by overlap;
+            // weights come from rounded cumulative sums so they add up to 256
+            double start = i * scale, end = (i + 1) * scale;
+            int first = int(start);
+            int last = std::min(srcSize - 1, int(std::ceil(end)) - 1);
+            tap.first = static_cast<uint16_t>(first);
+            int prev = 0;
+            for (int j = first; j <= last; ++j) {
+                double covered = std::min(end, double(j + 1)) - start;
+                int cum = int(std::lround(256.0 * covered / (end - start)));
+                weights.push_back(static_cast<uint16_t>(cum - prev));
+                prev = cum;
+            }
+            tap.count = static_cast<uint16_t>(last - first + 1);
+        }
+        taps.push_back(tap);
+    }
+}
+
+void ObservationPipeline::Reset() {
+    for (auto& f : frames) std::fill(f.begin(), f.end(), 0);
+    std::fill(history.begin(), history.end(), 0);
+    latest = 0;
+    next = 0;
+}
+
+void ObservationPipeline::AddFrame(const uint8_t* indices) {
+    if (!valid) return;
+    latest ^= 1;
+    uint8_t* dst = frames[latest].data();
+    for (int y = 0; y < srcH; ++y) {
+        ObservationDetail::LumaRow(luma, indices + (config.cropTop + y) * FRAME_W + config.cropLeft, dst + y * srcW, srcW);
+    }
+}
+
+void ObservationPipeline::Observe(uint8_t* out) {
+    if (!valid) return;
+    const uint8_t* src = frames[latest].data();
+    if (config.maxPool) {
+        ObservationDetail::MaxBytes(frames[0].data(), frames[1].data(), pooled.data(), pooled.size());
+        src = pooled.data();
+    }
+
+    for (int oy = 0; oy < config.height; ++oy) {
+        const Tap& t = rowTaps[oy];
+        ObservationDetail::BlendRows(src, srcW, t.first, t.count, &rowWeights[t.offset], &columnPass[size_t(oy) * srcW], srcW);
+    }
+
+    uint8_t* frame = &history[size_t(next) * FrameBytes()];
+    for (int oy = 0; oy < config.height; ++oy) {
+        const uint8_t* row = &columnPass[size_t(oy) * srcW];
+        for (int ox = 0; ox < config.width; ++ox) {
+            const Tap& t = colTaps[ox];
+            const uint16_t* w = &colWeights[t.offset];
+            uint32_t acc = 128;
+            for (int k = 0; k < t.count; ++k) acc += uint32_t(row[t.first + k]) * w[k];
+            frame[oy * config.width + ox] = static_cast<uint8_t>(acc >> 8);
+        }
+    }
+    next = (next + 1) % config.stack;
+
+    // Oldest first: the entry after the one just written
+    for (int k = 0; k < config.stack; ++k) {
+        int entry = (next + k) % config.stack;
+        std::memcpy(out + size_t(k) * FrameBytes(), &history[size_t(entry) * FrameBytes()], FrameBytes());
+    }
+}
@@ -2,14 +2,14 @@
 #include "headers/bus.h"
 #include "headers/cpu.h"
 #include "headers/mapper.h"
+#include "headers/savestate.h"
+#include "headers/ppulog.h"
 #include <cstring>
 #include <algorithm>
 #include <cstdio>
-bool nmiOccurred = false;
 
 namespace {
-void LogPPUStatus(const char* label, uint8_t value, int scanline, int cycle, int pc, bool force) {
-    static uint8_t lastValue = 0xFF;
+void LogPPUStatus(const char* label, uint8_t value, uint8_t& lastValue, int scanline, int cycle, int pc, bool force) {
     if (!force && value == lastValue) return;
     lastValue = value;
     if (scanline >= 0 && cycle >= 0) {
@@ -49,7 +49,8 @@ void PPU::Reset() {
     std::fill(vram.begin(), vram.end(), 0);
     std::fill(std::begin(paletteRam), std::end(paletteRam), 0);
     std::fill(std::begin(oam), std::end(oam), 0);
-    LogPPUStatus("Reset (before)", PPUSTATUS, -1, -1, -1, true);
+    InvalidateSpriteLine();
+    if (verbose) LogPPUStatus("Reset (before)", PPUSTATUS, loggedStatus, -1, -1, -1, true);
     PPUMASK = PPUSTATUS = OAMADDR = 0;
     vramAddr = vramAddrTemp = 0;
     writeToggle = false;
@@ -95,7 +96,24 @@ uint16_t PPU::MapNametable(uint16_t addr) const {
             return offset;
     }
 }
+uint32_t PPU::ColorOf(uint8_t paletteIndex) {
+    return NES_COLORS[paletteIndex & 0x3F];
+}
+
 uint32_t PPU::RenderPixel(int x, int y) {
+    return NES_COLORS[RenderPaletteIndex(x, y)];
+}
+
+uint8_t PPU::RenderPaletteIndex(int x, int y) {
+    return FetchPixel<true, false>(x, y);
+}
+
+// Draw = false performs only what the rest of the machine can observe: the
+// pattern fetch addresses reported to the mapper (MMC3 counts A12 edges), in
+// the same order as a drawn pixel. Sprite opacity is still decoded because it
+// decides which sprite fetches happen.
+template <bool Draw, bool Tapped>
+uint8_t PPU::FetchPixel(int x, int y) {
     bool bgEnabled = (PPUMASK & 0x08) != 0;
     bool sprEnabled = (PPUMASK & 0x10) != 0;
 
@@ -113,6 +131,7 @@ uint32_t PPU::RenderPixel(int x, int y) {
 
         uint16_t ntAddr = MapNametable(tileIndexAddr);
         uint8_t tileIndex = vram[ntAddr];
+        if constexpr (Tapped) tap->OnPPURead(tileIndexAddr);
 
         uint16_t patternTableAddr = (PPUCTRL & 0x10) ? 0x1000 : 0x0000;
         uint16_t tileDataAddr =
@@ -120,28 +139,35 @@ uint32_t PPU::RenderPixel(int x, int y) {
 
         bus.NotifyPPUAddr(tileDataAddr);
         bus.NotifyPPUAddr(tileDataAddr + 8);
-        uint8_t lowByte  = bus.ReadCHR(tileDataAddr);
-        uint8_t highByte = bus.ReadCHR(tileDataAddr + 8);
+        if (Draw) {
+            uint8_t lowByte  = bus.ReadCHR(tileDataAddr);
+            uint8_t highByte = bus.ReadCHR(tileDataAddr + 8);
+            if constexpr (Tapped) {
+                tap->OnPPURead(tileDataAddr);
+                tap->OnPPURead(tileDataAddr + 8);
+            }
 
 
-        int bit = 7 - ((x + fineX) & 7);
-        bgColorIndex =
-            ((highByte >> bit) & 1) << 1 |
-            ((lowByte >> bit) & 1);
+            int bit = 7 - ((x + fineX) & 7);
+            bgColorIndex =
+                ((highByte >> bit) & 1) << 1 |
+                ((lowByte >> bit) & 1);
 
-        uint16_t attrAddr =
-            baseNametableAddr + 0x3C0 +
-            ((coarseY >> 2) * 8) + (coarseX >> 2);
+            uint16_t attrAddr =
+                baseNametableAddr + 0x3C0 +
+                ((coarseY >> 2) * 8) + (coarseX >> 2);
 
-        uint16_t attrNt = MapNametable(attrAddr);
-        uint8_t attr = vram[attrNt];
+            uint16_t attrNt = MapNametable(attrAddr);
+            uint8_t attr = vram[attrNt];
+            if constexpr (Tapped) tap->OnPPURead(attrAddr);
 
 
-        int quadrantY = (coarseY & 0x02) ? 1 : 0;
-        int quadrantX = (coarseX & 0x02) ? 1 : 0;
-        int shift = (quadrantY * 2 + quadrantX) * 2;
+            int quadrantY = (coarseY & 0x02) ? 1 : 0;
+            int quadrantX = (coarseX & 0x02) ? 1 : 0;
+            int shift = (quadrantY * 2 + quadrantX) * 2;
 
-        bgPaletteIndex = (attr >> shift) & 0x03;
+            bgPaletteIndex = (attr >> shift) & 0x03;
+        }
     }
 
     bool spritePixel = false;
@@ -152,7 +178,16 @@ uint32_t PPU::RenderPixel(int x, int y) {
     if (sprEnabled && !(x < 8 && (PPUMASK & 0x04) == 0)) {
         int spriteHeight = (PPUCTRL & 0x20) ? 16 : 8;
         uint16_t spriteTable = (PPUCTRL & 0x08) ? 0x1000 : 0x0000;
-        for (int i = 0; i < 64; ++i) {
+        if (y != lineSpriteY) {
+            lineSpriteCount = 0;
+            for (int i = 0; i < 64; ++i) {
+                int top = int(oam[i * 4 + 0]) + 1;
+                if (y >= top && y < top + spriteHeight) lineSprites[lineSpriteCount++] = static_cast<uint8_t>(i);
+            }
+            lineSpriteY = y;
+        }
+        for (int n = 0; n < lineSpriteCount; ++n) {
+            int i = lineSprites[n];
             uint8_t sy = oam[i * 4 + 0];
             uint8_t tile = oam[i * 4 + 1];
             uint8_t attr = oam[i * 4 + 2];
@@ -189,6 +224,10 @@ uint32_t PPU::RenderPixel(int x, int y) {
             bus.NotifyPPUAddr(tileAddr + 8);
             uint8_t low = bus.ReadCHR(tileAddr);
             uint8_t high = bus.ReadCHR(tileAddr + 8);
+            if constexpr (Tapped) {
+                tap->OnPPURead(tileAddr);
+                tap->OnPPURead(tileAddr + 8);
+            }
             uint8_t color = ((high >> bit) & 1) << 1 | ((low >> bit) & 1);
             if (color == 0) continue;
 
@@ -199,24 +238,34 @@ uint32_t PPU::RenderPixel(int x, int y) {
         }
     }
 
+    if (!Draw) return 0;
+
     uint8_t palEntry = 0;
+    int palIndex = 0;
     if (spritePixel && (bgColorIndex == 0 || !spriteBehind)) {
-        int palIndex = 0x10 + spritePaletteIndex * 4 + spriteColorIndex;
-        palEntry = paletteRam[palIndex & 0x1F] & 0x3F;
+        palIndex = 0x10 + spritePaletteIndex * 4 + spriteColorIndex;
     } else {
-        int palIndex = (bgColorIndex == 0) ? 0 : (bgPaletteIndex * 4 + bgColorIndex);
-        palEntry = paletteRam[palIndex & 0x1F] & 0x3F;
+        palIndex = (bgColorIndex == 0) ? 0 : (bgPaletteIndex * 4 + bgColorIndex);
     }
+    palEntry = paletteRam[palIndex & 0x1F] & 0x3F;
+    if constexpr (Tapped) tap->OnPPURead(static_cast<uint16_t>(0x3F00 + (palIndex & 0x1F)));
 
-    uint32_t finalColor = NES_COLORS[palEntry % 64];
-    return finalColor;
-
+    return palEntry;
 }
 
 
 
 // Advance PPU cycles; triggers a frame render when enough cycles collected
 void PPU::StepCycles(uint32_t cycles) {
+    if (tap) Step<true>(cycles);
+    else Step<false>(cycles);
+}
+
+template <bool Tapped>
+void PPU::Step(uint32_t cycles) {
+    uint32_t* frame = frameTarget ? frameTarget : lastFrame.data();
+    // Without a picture, pattern fetches only matter to mappers that watch them
+    bool fetchesVisible = bus.mapper && bus.mapper->WantsPPUAddr();
     for (uint32_t i = 0; i < cycles; i++) {
         auto incrementX = [this]() {
             if ((renderAddr & 0x001F) == 31) {
@@ -255,15 +304,24 @@ void PPU::StepCycles(uint32_t cycles) {
             int x = cycle - 1;
             int y = scanline;
             if (rendering) {
-                lastFrame[y * 256 + x] = RenderPixel(x, y);
+                if (!drawFrame) {
+                    // Instrumented runs see the same memory traffic whether or not the frame is drawn
+                    if constexpr (Tapped) FetchPixel<true, true>(x, y);
+                    else if (fetchesVisible) FetchPixel<false, false>(x, y);
+                } else if (indexTarget) {
+                    indexTarget[y * 256 + x] = FetchPixel<true, Tapped>(x, y);
+                } else {
+                    frame[y * 256 + x] = NES_COLORS[FetchPixel<true, Tapped>(x, y)];
+                }
                 if ((cycle % 8) == 0 && cycle != 256) {
                     incrementX();
                 }
                 if (cycle == 256) {
                     incrementY();
                 }
-            } else {
-                lastFrame[y * 256 + x] = 0xFF000000u;
+            } else if (drawFrame) {
+                if (indexTarget) indexTarget[y * 256 + x] = BLACK_INDEX;
+                else frame[y * 256 + x] = 0xFF000000u;
             }
         }
         if (rendering) {
@@ -279,13 +337,13 @@ void PPU::StepCycles(uint32_t cycles) {
         // VBlank start
         if (scanline == 241 && cycle == 1) {
     int pc = bus.cpu ? static_cast<int>(bus.cpu->PC) : -1;
-    LogPPUStatus("VBlank start (before)", PPUSTATUS, scanline, cycle, pc, false);
+    if (verbose) LogPPUStatus("VBlank start (before)", PPUSTATUS, loggedStatus, scanline, cycle, pc, false);
     PPUSTATUS |= 0x80;
 
     if ((PPUCTRL & 0x80) && !nmiOccurred) {
         bus.nmiLine = true;
         nmiOccurred = true;
-        std::cout << "NMI at s=" << scanline
+        if (verbose) std::cout << "NMI at s=" << scanline
           << " c=" << cycle << "\n";
     }
 }
@@ -294,7 +352,7 @@ void PPU::StepCycles(uint32_t cycles) {
         if (scanline == 261 && cycle == 1) {
             // pre-render line: clear VBlank and secondary flags
                     int pc = bus.cpu ? static_cast<int>(bus.cpu->PC) : -1;
-                    LogPPUStatus("Pre-render clear (before)", PPUSTATUS, scanline, cycle, pc, false);
+                    if (verbose) LogPPUStatus("Pre-render clear (before)", PPUSTATUS, loggedStatus, scanline, cycle, pc, false);
                     PPUSTATUS &= ~0x80;
                      PPUSTATUS &= ~0x40;
                  PPUSTATUS &= ~0x20;
@@ -304,6 +362,9 @@ void PPU::StepCycles(uint32_t cycles) {
         // Frame finished
         if (scanline == 241 && cycle == 0) {
             frameReady = true;
+            frameDrawn = drawFrame;
+            frameCount++;
+            if (registerLog) registerLog->EndFrame(frameCount);
         }
         cycle++;
         if (cycle == 341) {
@@ -318,13 +379,28 @@ void PPU::StepCycles(uint32_t cycles) {
 
 
 
+uint8_t PPU::PeekVRAM(uint16_t addr) const {
+    addr &= 0x3FFF;
+    if (addr < 0x2000) return bus.ReadCHR(addr);
+    if (addr < 0x3F00) return vram[MapNametable(addr & 0x2FFF)];
+    uint8_t palIndex = addr & 0x1F;
+    if ((palIndex & 0x13) == 0x10) palIndex &= ~0x10;
+    return paletteRam[palIndex];
+}
+
 uint8_t PPU::ReadRegister(uint16_t reg) {
+    uint8_t value = ReadRegisterValue(reg);
+    if (registerLog) registerLog->OnRegister(PPURegisterLog::READ, uint8_t(reg), value);
+    return value;
+}
+
+uint8_t PPU::ReadRegisterValue(uint16_t reg) {
     reg &= 7;
     switch (reg) {
         case 2: { // PPUSTATUS
             uint8_t ret = PPUSTATUS;
             int pc = bus.cpu ? static_cast<int>(bus.cpu->PC) : -1;
-            LogPPUStatus("Read $2002 (before)", PPUSTATUS, scanline, cycle, pc, false);
+            if (verbose) LogPPUStatus("Read $2002 (before)", PPUSTATUS, loggedStatus, scanline, cycle, pc, false);
             PPUSTATUS &= ~0x80;
             writeToggle = false;
             return ret;
@@ -335,6 +411,7 @@ uint8_t PPU::ReadRegister(uint16_t reg) {
         case 7: { // PPUDATA
             uint16_t addr = vramAddr & 0x3FFF;
             uint8_t ret = 0;
+            if (tap) tap->OnPPURead(addr);
             // PPUDATA is buffered for reads from $0000-$3EFF
             if (addr >= 0x3F00 && addr <= 0x3FFF) {
                 uint8_t palIndex = addr & 0x1F;
@@ -368,10 +445,12 @@ uint8_t PPU::ReadRegister(uint16_t reg) {
 }
 
 void PPU::WriteRegister(uint16_t reg, uint8_t val) {
+    if (registerLog) registerLog->OnRegister(PPURegisterLog::WRITE, uint8_t(reg), val);
     switch (reg) {
         case 0: // PPUCTRL
         {
             PPUCTRL = val;
+            InvalidateSpriteLine();
             vramAddrTemp = (vramAddrTemp & 0xF3FF) | ((val & 0x03) << 10);
         }
         break;
@@ -383,6 +462,7 @@ void PPU::WriteRegister(uint16_t reg, uint8_t val) {
             break;
         case 4: // OAMDATA
             oam[OAMADDR++] = val;
+            InvalidateSpriteLine();
             break;
         case 5: // PPUSCROLL
             if (!writeToggle) {
@@ -415,6 +495,7 @@ void PPU::WriteRegister(uint16_t reg, uint8_t val) {
             break;
         case 7: { // PPUDATA
             uint16_t addr = vramAddr & 0x3FFF;
+            if (tap) tap->OnPPUWrite(addr);
             if (addr < 0x2000) {
                 // writing to CHR RAM (if present)
                 bus.WriteCHR(addr, val);
@@ -441,15 +522,71 @@ void PPU::WriteRegister(uint16_t reg, uint8_t val) {
 
 // Return the last frame produced by StepCycles if available and clear the flag
 bool PPU::PopFrame(std::vector<uint32_t>& outPixels, int& outWidth, int& outHeight) {
-    if (!frameReady) return false;
+    if (!frameReady || !frameDrawn) return false;
     outWidth = 256;
     outHeight = 240;
-    outPixels = std::move(lastFrame);
-    lastFrame.resize(256 * 240);
+    if (frameTarget) {
+        outPixels.assign(frameTarget, frameTarget + 256 * 240);
+    } else {
+        outPixels = std::move(lastFrame);
+        lastFrame.resize(256 * 240);
+    }
     frameReady = false;
     return true;
 }
 
+void PPU::SaveState(PPUState& out) const {
+    std::memcpy(out.vram, vram.data(), sizeof(out.vram));
+    std::memcpy(out.paletteRam, paletteRam, sizeof(out.paletteRam));
+    std::memcpy(out.oam, oam, sizeof(out.oam));
+    out.frameCount = frameCount;
+    out.ppuCycleCounter = ppuCycleCounter;
+    out.scanline = scanline;
+    out.cycle = cycle;
+    out.vramAddr = vramAddr;
+    out.vramAddrTemp = vramAddrTemp;
+    out.renderAddr = renderAddr;
+    out.PPUCTRL = PPUCTRL;
+    out.PPUMASK = PPUMASK;
+    out.PPUSTATUS = PPUSTATUS;
+    out.OAMADDR = OAMADDR;
+    out.writeToggle = writeToggle ? 1 : 0;
+    out.fineX = fineX;
+    out.scrollCoarseX = scrollCoarseX;
+    out.scrollCoarseY = scrollCoarseY;
+    out.scrollFineY = scrollFineY;
+    out.readBuffer = readBuffer;
+    out.frameReady = frameReady ? 1 : 0;
+    out.nmiOccurred = nmiOccurred ? 1 : 0;
+    out.pad[0] = out.pad[1] = 0;
+}
+
+void PPU::LoadState(const PPUState& in) {
+    std::memcpy(vram.data(), in.vram, sizeof(in.vram));
+    std::memcpy(paletteRam, in.paletteRam, sizeof(paletteRam));
+    std::memcpy(oam, in.oam, sizeof(oam));
+    InvalidateSpriteLine();
+    frameCount = in.frameCount;
+    ppuCycleCounter = in.ppuCycleCounter;
+    scanline = in.scanline;
+    cycle = in.cycle;
+    vramAddr = in.vramAddr;
+    vramAddrTemp = in.vramAddrTemp;
+    renderAddr = in.renderAddr;
+    PPUCTRL = in.PPUCTRL;
+    PPUMASK = in.PPUMASK;
+    PPUSTATUS = in.PPUSTATUS;
+    OAMADDR = in.OAMADDR;
+    writeToggle = in.writeToggle != 0;
+    fineX = in.fineX;
+    scrollCoarseX = in.scrollCoarseX;
+    scrollCoarseY = in.scrollCoarseY;
+    scrollFineY = in.scrollFineY;
+    readBuffer = in.readBuffer;
+    frameReady = in.frameReady != 0;
+    nmiOccurred = in.nmiOccurred != 0;
+}
+
 // OAM DMA: copy 256 bytes from CPU page (page<<8)
 void PPU::DoOAMDMA(uint8_t page) {
     // Legacy helper that performs a whole-frame copy; kept for compatibility
@@ -459,12 +596,14 @@ void PPU::DoOAMDMA(uint8_t page) {
         uint8_t val = bus.read(addr);
         oam[i] = val;
     }
+    InvalidateSpriteLine();
     OAMADDR = 0;
 }
 
 // Write a single byte into OAM at index (used by cycle-accurate DMA)
 void PPU::WriteOAMByte(uint16_t index, uint8_t value) {
     if (index < 256) oam[index] = value;
+    InvalidateSpriteLine();
 }
 
 // Keep old helper: RenderPatternTable
@@ -0,0 +1,148 @@
+#include "headers/ppulog.h"
+#include "headers/bus.h"
+#include "headers/cpu.h"
+#include "headers/mapper.h"
+#include "headers/ppu.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace {
+const char* const MIRRORING_NAMES[] = {"horizontal", "vertical", "single-a", "single-b", "four-screen"};
+}
+
+PPURegisterLog::PPURegisterLog() {
+    current.reserve(CAPACITY);
+    last.reserve(CAPACITY);
+    for (int& b : chrBanks) b = -1;
+}
+
+void PPURegisterLog::Attach(PPU& p, Bus& b, const CPU& c) {
+    Detach();
+    ppu = &p;
+    bus = &b;
+    cpu = &c;
+    p.registerLog = this;
+    current.clear();
+    last.clear();
+    dropped = lastDropped = 0;
+    CaptureMapper();
+}
+
+void PPURegisterLog::Detach() {
+    if (ppu && ppu->registerLog == this) ppu->registerLog = nullptr;
+    ppu = nullptr;
+    bus = nullptr;
+    cpu = nullptr;
+}
+
+void PPURegisterLog::CaptureMapper() {
+    const Mapper* mapper = bus ? bus->mapper : nullptr;
+    mirroring = mapper ? int(mapper->GetMirroring()) : -1;
+    for (int slot = 0; slot < 8; ++slot) chrBanks[slot] = mapper ? mapper->CHRBank(uint16_t(slot * 0x400)) : -1;
+}
+
+void PPURegisterLog::Record(Kind kind, uint8_t index, uint16_t value) {
+    if (kind == READ && !current.empty()) {
+        Event& back = current.back();
+        if (back.kind == READ && back.index == index && back.value == value && back.repeat < 0xFFFF) {
+            ++back.repeat;
+            return;
+        }
+    }
+    if (current.size() == CAPACITY) {
+        ++dropped;
+        return;
+    }
+    // Where the PPU will be once it catches up with the cycles already spent
+    int scanline = ppu->GetScanline();
+    int dot = ppu->GetDot() + int(cpu->CyclesIntoInstruction()) * 3;
+    scanline += dot / 341;
+    dot %= 341;
+    if (scanline >= 262) scanline -= 262;
+    current.push_back({uint16_t(scanline), uint16_t(dot), kind, index, value, 0});
+}
+
+void PPURegisterLog::OnRegister(Kind kind, uint8_t reg, uint8_t value) {
+    Record(kind, reg & 7, value);
+}
+
+void PPURegisterLog::OnMapperWrite() {
+    const Mapper* mapper = bus ? bus->mapper : nullptr;
+    if (!mapper) return;
+    int m = int(mapper->GetMirroring());
+    if (m != mirroring) {
+        mirroring = m;
+        Record(MIRRORING, 0, uint16_t(m));
+    }
+    for (int slot = 0; slot < 8; ++slot) {
+        int bank = mapper->CHRBank(uint16_t(slot * 0x400));
+        if (bank == chrBanks[slot]) continue;
+        chrBanks[slot] = bank;
+        if (bank >= 0) Record(CHR_BANK, uint8_t(slot), uint16_t(bank));
+    }
+}
+
+void PPURegisterLog::EndFrame(uint64_t frame) {
+    last.swap(current);
+    current.clear();
+    lastDropped = dropped;
+    dropped = 0;
+    lastFrame = frame;
+}
+
+size_t PPURegisterLog::MidFrameChanges() const {
+    size_t n = 0;
+    for (const Event& e : last) {
+        if (e.scanline < 240 && e.kind != READ) ++n;
+    }
+    return n;
+}
+
+const char* PPURegisterLog::KindName(Kind kind) {
+    switch (kind) {
+    case READ:      return "read";
+    case WRITE:     return "write";
+    case MIRRORING: return "mirroring";
+    case CHR_BANK:  return "chr";
+    }
+    return "?";
+}
+
+void PPURegisterLog::WriteHeader(std::ostream& out) {
+    out << "frame,scanline,dot,event,target,value,repeat\n";
+}
+
+void PPURegisterLog::WriteFrame(std::ostream& out) const {
+    char buf[96];
+    for (const Event& e : last) {
+        char target[8];
+        if (e.kind == MIRRORING) std::snprintf(target, sizeof(target), "-");
+        else if (e.kind == CHR_BANK) std::snprintf(target, sizeof(target), "$%04X", e.index * 0x400);
+        else std::snprintf(target, sizeof(target), "$%04X", 0x2000 + e.index);
+        if (e.kind == MIRRORING) {
+            std::snprintf(buf, sizeof(buf), "%llu,%u,%u,%s,%s,%s,%u\n", static_cast<unsigned long long>(lastFrame), e.scanline,
+                e.dot, KindName(e.kind), target, e.value < 5 ? MIRRORING_NAMES[e.value] : "?", e.repeat);
+        } else {
+            std::snprintf(buf, sizeof(buf), "%llu,%u,%u,%s,%s,$%02X,%u\n", static_cast<unsigned long long>(lastFrame), e.scanline,
+                e.dot, KindName(e.kind), target, e.value, e.repeat);
+        }
+        out << buf;
+    }
+}
+
+bool PPURegisterLog::Export(const std::string& path) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to create register log: " << path << std::endl;
+        return false;
+    }
+    WriteHeader(out);
+    WriteFrame(out);
+    if (!out) {
+        std::cerr << "Failed to write register log: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
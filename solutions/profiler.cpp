@@ -0,0 +1,167 @@
+#include "headers/profiler.h"
+#include "headers/cpu.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+Profiler::Profiler() {
+    Reset();
+}
+
+void Profiler::Reset() {
+    counters.assign(0x8000, Counter{});
+    opcodeCounts.fill(0);
+    opcodeCycles.fill(0);
+    instructions = 0;
+    cycles = 0;
+    dmaCycles = 0;
+    nodes.assign(1, Node{0, 0, 0});
+    children.clear();
+    stack.clear();
+    current = 0;
+}
+
+Profiler::Counter& Profiler::At(uint32_t location) {
+    if (location >= counters.size()) counters.resize((location | 0x1FFF) + 1);
+    return counters[location];
+}
+
+void Profiler::Instruction(const CPU& cpu, const Bus& bus, uint16_t pc, uint8_t opcode, u32 n) {
+    Counter& c = At(Locate(bus, pc));
+    c.pc = pc;
+    ++c.instructions;
+    c.cycles += n;
+    ++opcodeCounts[opcode];
+    opcodeCycles[opcode] += n;
+    ++instructions;
+    cycles += n;
+    // The JSR itself belongs to the caller and RTS/RTI to the callee
+    nodes[current].selfCycles += n;
+
+    if (opcode == 0x20) {
+        uint32_t target = Locate(bus, cpu.PC);
+        At(target).pc = cpu.PC;
+        Enter(target, KIND_CALL, uint8_t(cpu.SP + 2));
+    } else if (opcode == 0x60 || opcode == 0x40) {
+        Leave(cpu.SP);
+    }
+}
+
+void Profiler::Interrupt(const CPU& cpu, const Bus& bus, bool nmi, u32 n) {
+    uint32_t handler = Locate(bus, cpu.PC);
+    At(handler).pc = cpu.PC;
+    cycles += n;
+    Enter(handler, nmi ? KIND_NMI : KIND_IRQ, uint8_t(cpu.SP + 3));
+    nodes[current].selfCycles += n;
+}
+
+void Profiler::Stall(u32 n) {
+    cycles += n;
+    dmaCycles += n;
+    nodes[current].selfCycles += n;
+}
+
+void Profiler::Enter(uint32_t location, Kind kind, uint8_t sp) {
+    ++At(location).calls;
+    // Runaway stacks (code that JSRs and never returns) stop growing the tree
+    if (stack.size() >= MAX_DEPTH) return;
+    uint32_t function = location | (uint32_t(kind) << 24);
+    uint64_t key = uint64_t(current) << 32 | function;
+    auto it = children.find(key);
+    uint32_t node;
+    if (it != children.end()) {
+        node = it->second;
+    } else {
+        node = uint32_t(nodes.size());
+        nodes.push_back({current, function, 0});
+        children.emplace(key, node);
+    }
+    stack.push_back({node, location, sp, cycles});
+    current = node;
+}
+
+void Profiler::Leave(uint8_t sp) {
+    // A return lands SP where it was before the call. Frames below that were
+    // abandoned (stack resets, longjmp style code) and close too; an RTS that
+    // does not reach the top frame's SP is a pushed-address jump, not a return.
+    while (!stack.empty() && stack.back().sp <= sp) {
+        const Frame& f = stack.back();
+        counters[f.location].inclusiveCycles += cycles - f.entryCycles;
+        stack.pop_back();
+    }
+    current = stack.empty() ? 0 : stack.back().node;
+}
+
+std::string Profiler::LocationName(uint16_t pc, int bank) {
+    char buf[16];
+    if (bank < 0) std::snprintf(buf, sizeof(buf), "%04X", pc);
+    else std::snprintf(buf, sizeof(buf), "%02X:%04X", bank, pc);
+    return buf;
+}
+
+std::string Profiler::FunctionName(uint32_t function) const {
+    uint32_t location = function & 0xFFFFFF;
+    std::string name = LocationName(counters[location].pc, BankOf(location));
+    switch (function >> 24) {
+    case KIND_NMI: return "NMI " + name;
+    case KIND_IRQ: return "IRQ " + name;
+    default: return name;
+    }
+}
+
+std::vector<Profiler::HotSpot> Profiler::HotSpots(size_t limit) const {
+    std::vector<HotSpot> out;
+    for (uint32_t i = 0; i < counters.size(); ++i) {
+        const Counter& c = counters[i];
+        if (c.instructions) out.push_back({c.pc, BankOf(i), c.instructions, c.cycles});
+    }
+    auto byCycles = [](const HotSpot& a, const HotSpot& b) { return a.cycles > b.cycles; };
+    if (out.size() > limit) {
+        std::partial_sort(out.begin(), out.begin() + limit, out.end(), byCycles);
+        out.resize(limit);
+    } else {
+        std::sort(out.begin(), out.end(), byCycles);
+    }
+    return out;
+}
+
+std::vector<Profiler::Function> Profiler::Functions(size_t limit) const {
+    std::unordered_map<uint32_t, uint64_t> self;
+    for (size_t i = 1; i < nodes.size(); ++i) self[nodes[i].function & 0xFFFFFF] += nodes[i].selfCycles;
+
+    std::vector<Function> out;
+    for (uint32_t i = 0; i < counters.size(); ++i) {
+        const Counter& c = counters[i];
+        if (!c.calls) continue;
+        auto it = self.find(i);
+        out.push_back({c.pc, BankOf(i), c.calls, c.inclusiveCycles, it != self.end() ? it->second : 0});
+    }
+    auto byInclusive = [](const Function& a, const Function& b) { return a.inclusiveCycles > b.inclusiveCycles; };
+    if (out.size() > limit) {
+        std::partial_sort(out.begin(), out.begin() + limit, out.end(), byInclusive);
+        out.resize(limit);
+    } else {
+        std::sort(out.begin(), out.end(), byInclusive);
+    }
+    return out;
+}
+
+bool Profiler::WriteFoldedStacks(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to create " << path << std::endl;
+        return false;
+    }
+    std::vector<uint32_t> chain;
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+        if (!nodes[i].selfCycles) continue;
+        chain.clear();
+        for (uint32_t n = i; n != 0; n = nodes[n].parent) chain.push_back(n);
+        out << "reset";
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) out << ';' << FunctionName(nodes[*it].function);
+        out << ' ' << nodes[i].selfCycles << '\n';
+    }
+    return bool(out);
+}
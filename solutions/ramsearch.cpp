@@ -0,0 +1,186 @@
+#include "headers/ramsearch.h"
+#include "headers/bus.h"
+#include "headers/mapper.h"
+
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RAMSEARCH_SSE2 1
+#else
+#define RAMSEARCH_SSE2 0
+#endif
+
+namespace {
+inline uint16_t Load(const uint8_t* p, bool word, bool bigEndian) {
+    if (!word) return p[0];
+    return bigEndian ? uint16_t(p[0] << 8 | p[1]) : uint16_t(p[0] | p[1] << 8);
+}
+
+inline bool Match(const RamQuery& q, uint16_t cur, uint16_t prev, uint16_t mask) {
+    uint16_t rhs = q.vsPrevious ? prev : q.value;
+    switch (q.op) {
+    case RamQuery::Equal:        return cur == rhs;
+    case RamQuery::NotEqual:     return cur != rhs;
+    case RamQuery::Less:         return cur < rhs;
+    case RamQuery::Greater:      return cur > rhs;
+    case RamQuery::LessEqual:    return cur <= rhs;
+    case RamQuery::GreaterEqual: return cur >= rhs;
+    case RamQuery::InRange:      return cur >= q.value && cur <= q.high;
+    case RamQuery::ChangedBy:    return uint16_t((cur - prev) & mask) == (q.value & mask);
+    }
+    return false;
+}
+
+#if RAMSEARCH_SSE2
+// Eight 16-bit values for addresses i..i+7 (half = 0) or i+8..i+15 (half = 1)
+inline __m128i LoadLanes(const uint8_t* p, bool word, bool bigEndian, int half) {
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hi = word ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1)) : _mm_setzero_si128();
+    if (word && bigEndian) std::swap(lo, hi);
+    return half ? _mm_unpackhi_epi8(lo, hi) : _mm_unpacklo_epi8(lo, hi);
+}
+
+// All-ones lanes where the query holds
+inline __m128i MatchLanes(const RamQuery& q, __m128i cur, __m128i prev, __m128i mask) {
+    const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+    __m128i rhs = q.vsPrevious ? prev : _mm_set1_epi16(static_cast<short>(q.value));
+    // Unsigned order through the signed compare
+    __m128i c = _mm_xor_si128(cur, bias);
+    __m128i r = _mm_xor_si128(rhs, bias);
+    const __m128i ones = _mm_set1_epi16(-1);
+    switch (q.op) {
+    case RamQuery::Equal:        return _mm_cmpeq_epi16(cur, rhs);
+    case RamQuery::NotEqual:     return _mm_xor_si128(_mm_cmpeq_epi16(cur, rhs), ones);
+    case RamQuery::Less:         return _mm_cmplt_epi16(c, r);
+    case RamQuery::Greater:      return _mm_cmpgt_epi16(c, r);
+    case RamQuery::LessEqual:    return _mm_xor_si128(_mm_cmpgt_epi16(c, r), ones);
+    case RamQuery::GreaterEqual: return _mm_xor_si128(_mm_cmplt_epi16(c, r), ones);
+    case RamQuery::InRange: {
+        __m128i lo = _mm_set1_epi16(static_cast<short>(q.value ^ 0x8000));
+        __m128i hi = _mm_set1_epi16(static_cast<short>(q.high ^ 0x8000));
+        return _mm_xor_si128(_mm_or_si128(_mm_cmplt_epi16(c, lo), _mm_cmpgt_epi16(c, hi)), ones);
+    }
+    case RamQuery::ChangedBy: {
+        __m128i delta = _mm_and_si128(_mm_sub_epi16(cur, prev), mask);
+        return _mm_cmpeq_epi16(delta, _mm_and_si128(_mm_set1_epi16(static_cast<short>(q.value)), mask));
+    }
+    }
+    return _mm_setzero_si128();
+}
+#endif
+}
+
+namespace RamSearchDetail {
+uint32_t Match16Scalar(const RamQuery& q, const uint8_t* cur, const uint8_t* prev) {
+    uint16_t mask = q.word ? 0xFFFF : 0x00FF;
+    uint32_t bits = 0;
+    for (size_t k = 0; k < 16; ++k) {
+        if (Match(q, Load(cur + k, q.word, q.bigEndian), Load(prev + k, q.word, q.bigEndian), mask)) bits |= 1u << k;
+    }
+    return bits;
+}
+
+uint32_t Match16(const RamQuery& q, const uint8_t* cur, const uint8_t* prev) {
+#if RAMSEARCH_SSE2
+    const __m128i m = _mm_set1_epi16(static_cast<short>(q.word ? 0xFFFF : 0x00FF));
+    __m128i lo = MatchLanes(q, LoadLanes(cur, q.word, q.bigEndian, 0), LoadLanes(prev, q.word, q.bigEndian, 0), m);
+    __m128i hi = MatchLanes(q, LoadLanes(cur, q.word, q.bigEndian, 1), LoadLanes(prev, q.word, q.bigEndian, 1), m);
+    return uint32_t(_mm_movemask_epi8(_mm_packs_epi16(lo, hi)));
+#else
+    return Match16Scalar(q, cur, prev);
+#endif
+}
+}
+
+void RamSearch::Reset(bool includePrgRam) {
+    prgRam = includePrgRam;
+    snapshots.clear();
+    std::memset(candidates, 0xFF, sizeof(candidates));
+    if (!prgRam) {
+        std::memset(candidates + RAM_BYTES / 64, 0, (SIZE - RAM_BYTES) / 8);
+    }
+    Recount();
+}
+
+void RamSearch::Capture(const Bus& bus) {
+    snapshots.emplace_back();
+    Image& img = snapshots.back();
+    std::memset(img.bytes, 0, sizeof(img.bytes));
+    std::memcpy(img.bytes, bus.ram.Data, RAM_BYTES);
+    if (bus.mapper) {
+        MapperState mapperState{};
+        bus.mapper->SaveState(mapperState);
+        std::memcpy(img.bytes + RAM_BYTES, mapperState.prgRam, PRG_RAM_BYTES);
+    }
+    if (snapshots.size() > maxSnapshots) snapshots.pop_front();
+}
+
+void RamSearch::Capture(const MachineState& state) {
+    static_assert(sizeof(state.bus.ram) == RAM_BYTES && sizeof(state.mapper.prgRam) == PRG_RAM_BYTES,
+                  "search image mirrors the save-state RAM blocks");
+    snapshots.emplace_back();
+    Image& img = snapshots.back();
+    std::memset(img.bytes, 0, sizeof(img.bytes));
+    std::memcpy(img.bytes, state.bus.ram, RAM_BYTES);
+    std::memcpy(img.bytes + RAM_BYTES, state.mapper.prgRam, PRG_RAM_BYTES);
+    if (snapshots.size() > maxSnapshots) snapshots.pop_front();
+}
+
+const RamSearch::Image* RamSearch::At(int which) const {
+    int n = int(snapshots.size());
+    int i = which < 0 ? n + which : which;
+    return i >= 0 && i < n ? &snapshots[size_t(i)] : nullptr;
+}
+
+size_t RamSearch::Filter(const RamQuery& q, int newer, int older) {
+    const Image* curImg = At(newer);
+    const Image* prevImg = At(older);
+    bool needsPrevious = q.vsPrevious || q.op == RamQuery::ChangedBy;
+    if (!curImg || (needsPrevious && !prevImg)) return count;
+    if (!prevImg) prevImg = curImg;
+    const uint8_t* cur = curImg->bytes;
+    const uint8_t* prev = prevImg->bytes;
+
+    // A 16-bit value may not run past the end of its region
+    if (q.word) {
+        candidates[(RAM_BYTES - 1) >> 6] &= ~(uint64_t(1) << ((RAM_BYTES - 1) & 63));
+        candidates[(SIZE - 1) >> 6] &= ~(uint64_t(1) << ((SIZE - 1) & 63));
+    }
+
+    for (size_t block = 0; block < SIZE / 64; ++block) {
+        if (!candidates[block]) continue;
+        uint64_t keep = 0;
+        for (size_t part = 0; part < 4; ++part) {
+            size_t base = block * 64 + part * 16;
+            keep |= uint64_t(RamSearchDetail::Match16(q, cur + base, prev + base)) << (part * 16);
+        }
+        candidates[block] &= keep;
+    }
+    Recount();
+    return count;
+}
+
+void RamSearch::Recount() {
+    count = 0;
+    for (uint64_t w : candidates) {
+        while (w) {
+            w &= w - 1;
+            ++count;
+        }
+    }
+}
+
+std::vector<uint32_t> RamSearch::Candidates(size_t limit) const {
+    std::vector<uint32_t> out;
+    for (size_t i = 0; i < SIZE && out.size() < limit; ++i) {
+        if (IsCandidate(i)) out.push_back(uint32_t(i));
+    }
+    return out;
+}
+
+uint16_t RamSearch::Value(size_t index, bool word, bool bigEndian, int which) const {
+    const Image* img = At(which);
+    return img && index < SIZE ? Load(img->bytes + index, word, bigEndian) : 0;
+}
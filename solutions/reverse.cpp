@@ -0,0 +1,193 @@
+#include "headers/reverse.h"
+#include "headers/cpu.h"
+#include "headers/ppu.h"
+#include "headers/delta.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+// Remembers the position of the latest CPU write to one address
+struct WriteWatch : BusTap {
+    uint16_t addr = 0;
+    const uint64_t* position = nullptr;
+    uint64_t hit = UINT64_MAX;
+
+    void OnCPUWrite(uint16_t a, uint8_t) override {
+        bool ramMirror = a < 0x2000 && addr < 0x2000 && ((a ^ addr) & Bus::RAM_MASK) == 0;
+        if (a == addr || ramMirror) hit = *position;
+    }
+};
+}
+
+ReverseDebugger::ReverseDebugger(CPU& cpu, Bus& bus, u32& cycles)
+    : cpu(cpu), bus(bus), cycles(cycles) {}
+
+void ReverseDebugger::Reset() {
+    position = 0;
+    head = 0;
+    framesRecorded = 0;
+    checkpoints.clear();
+    inputs.clear();
+    frameStarts.clear();
+    nextInput = 0;
+    bytes = 0;
+    pads[0] = bus.input.GetButtons(0);
+    pads[1] = bus.input.GetButtons(1);
+    frameStarts.push_back(0);
+    AddCheckpoint();
+}
+
+uint64_t ReverseDebugger::FrameCount() const {
+    return bus.ppu ? bus.ppu->frameCount : cycles / CPU::CYCLES_PER_FRAME;
+}
+
+void ReverseDebugger::SyncInput(bool replaying) {
+    while (nextInput < inputs.size() && inputs[nextInput].position <= position) {
+        pads[0] = inputs[nextInput].pads[0];
+        pads[1] = inputs[nextInput].pads[1];
+        ++nextInput;
+    }
+    if (replaying) {
+        // History plays back the logged pads regardless of what the host set
+        if (bus.input.GetButtons(0) != pads[0]) bus.input.SetButtons(0, pads[0]);
+        if (bus.input.GetButtons(1) != pads[1]) bus.input.SetButtons(1, pads[1]);
+        return;
+    }
+    uint8_t live0 = bus.input.GetButtons(0);
+    uint8_t live1 = bus.input.GetButtons(1);
+    if (live0 != pads[0] || live1 != pads[1]) {
+        inputs.push_back({position, {live0, live1}});
+        nextInput = inputs.size();
+        pads[0] = live0;
+        pads[1] = live1;
+    }
+}
+
+void ReverseDebugger::Step() {
+    SyncInput(position < head);
+    uint64_t frame = FrameCount();
+    cpu.Execute(cycles, bus);
+    ++position;
+    if (position > head) {
+        head = position;
+        if (FrameCount() != frame) {
+            frameStarts.push_back(position);
+            if (++framesRecorded % uint64_t(std::max(1, checkpointInterval)) == 0) AddCheckpoint();
+        }
+    }
+}
+
+void ReverseDebugger::RunFrame() {
+    uint64_t frame = FrameCount();
+    while (FrameCount() == frame) Step();
+}
+
+void ReverseDebugger::AddCheckpoint() {
+    Snapshot(cpu, bus, cycles, scratch);
+    Checkpoint cp{position, {}};
+    ZeroRleEncode(reinterpret_cast<const uint8_t*>(&scratch), sizeof(MachineState), cp.data);
+    bytes += cp.data.size();
+    checkpoints.push_back(std::move(cp));
+
+    // Over budget: drop the oldest checkpoints and whatever history only they could reach
+    while (bytes > maxBytes && checkpoints.size() > 1) {
+        bytes -= checkpoints.front().data.size();
+        checkpoints.pop_front();
+    }
+    uint64_t oldest = checkpoints.front().position;
+    while (!frameStarts.empty() && frameStarts.front() < oldest) frameStarts.pop_front();
+    while (!inputs.empty() && inputs.front().position < oldest) {
+        inputs.pop_front();
+        if (nextInput > 0) --nextInput;
+    }
+}
+
+size_t ReverseDebugger::CheckpointBefore(uint64_t target) const {
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), target,
+                               [](uint64_t t, const Checkpoint& cp) { return t < cp.position; });
+    if (it == checkpoints.begin()) return SIZE_MAX;
+    return size_t(it - checkpoints.begin()) - 1;
+}
+
+bool ReverseDebugger::RestoreCheckpoint(size_t index) {
+    const Checkpoint& cp = checkpoints[index];
+    if (!ZeroRleDecode(cp.data.data(), cp.data.size(), reinterpret_cast<uint8_t*>(&scratch), sizeof(MachineState)) ||
+        !Restore(cpu, bus, cycles, scratch)) {
+        return false;
+    }
+    position = cp.position;
+    pads[0] = bus.input.GetButtons(0);
+    pads[1] = bus.input.GetButtons(1);
+    auto it = std::lower_bound(inputs.begin(), inputs.end(), position,
+                               [](const InputEvent& e, uint64_t p) { return e.position < p; });
+    nextInput = size_t(it - inputs.begin());
+    return true;
+}
+
+bool ReverseDebugger::SeekTo(uint64_t target) {
+    if (target > head || checkpoints.empty() || target < Oldest()) return false;
+    auto start = std::chrono::steady_clock::now();
+
+    // Re-execute from a checkpoint unless the target is just ahead of us
+    size_t ci = CheckpointBefore(target);
+    if (target < position || checkpoints[ci].position > position) {
+        if (!RestoreCheckpoint(ci)) return false;
+    }
+    while (position < target) Step();
+    if (position < head) SyncInput(true);
+
+    lastSeekMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+bool ReverseDebugger::StepBack(uint64_t instructions) {
+    if (instructions > position) return false;
+    return SeekTo(position - instructions);
+}
+
+bool ReverseDebugger::StepBackFrame() {
+    auto it = std::lower_bound(frameStarts.begin(), frameStarts.end(), position);
+    if (it == frameStarts.begin()) return false;
+    return SeekTo(*(it - 1));
+}
+
+bool ReverseDebugger::StepBackToWrite(uint16_t addr) {
+    if (position == 0 || checkpoints.empty() || position <= Oldest()) return false;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t origin = position;
+
+    WriteWatch watch;
+    watch.addr = addr;
+    watch.position = &position;
+    bus.AddTap(&watch);
+
+    // Scan checkpoint intervals newest first; the last hit in an interval is the latest write
+    uint64_t found = UINT64_MAX;
+    uint64_t end = origin;
+    for (size_t ci = CheckpointBefore(origin - 1); ci != SIZE_MAX; --ci) {
+        if (!RestoreCheckpoint(ci)) break;
+        while (position < end) Step();
+        if (watch.hit != UINT64_MAX) {
+            found = watch.hit;
+            break;
+        }
+        end = checkpoints[ci].position;
+        if (ci == 0) break;
+    }
+    bus.RemoveTap(&watch);
+
+    bool ok = SeekTo(found != UINT64_MAX ? found : origin) && found != UINT64_MAX;
+    lastSeekMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+void ReverseDebugger::Diverge() {
+    head = position;
+    while (!checkpoints.empty() && checkpoints.back().position > position) {
+        bytes -= checkpoints.back().data.size();
+        checkpoints.pop_back();
+    }
+    while (!frameStarts.empty() && frameStarts.back() > position) frameStarts.pop_back();
+    inputs.resize(nextInput);
+}
@@ -0,0 +1,83 @@
+#include "headers/rewind.h"
+#include "headers/delta.h"
+#include <cstring>
+
+RewindBuffer::RewindBuffer(size_t maxBytes, int keyframeInterval)
+    : maxBytes(maxBytes), keyframeInterval(keyframeInterval > 0 ? keyframeInterval : 1) {
+    scratch.resize(sizeof(MachineState));
+}
+
+void RewindBuffer::Push(const MachineState& state) {
+    const uint8_t* raw = reinterpret_cast<const uint8_t*>(&state);
+    Entry entry;
+    if (!baseValid || sinceKeyframe >= keyframeInterval) {
+        entry.keyframe = true;
+        ZeroRleEncode(raw, sizeof(MachineState), entry.data);
+        base = state;
+        baseValid = true;
+        sinceKeyframe = 0;
+    } else {
+        XorBytes(raw, reinterpret_cast<const uint8_t*>(&base), scratch.data(), sizeof(MachineState));
+        ZeroRleEncode(scratch.data(), sizeof(MachineState), entry.data);
+        sinceKeyframe++;
+    }
+    entry.data.shrink_to_fit();
+    totalBytes += entry.data.size();
+    entries.push_back(std::move(entry));
+    Evict();
+}
+
+bool RewindBuffer::Pop(MachineState& out) {
+    if (entries.empty()) return false;
+    Entry& entry = entries.back();
+    uint8_t* dst = reinterpret_cast<uint8_t*>(&out);
+    bool ok;
+    if (entry.keyframe) {
+        ok = ZeroRleDecode(entry.data.data(), entry.data.size(), dst, sizeof(MachineState));
+        baseValid = false;
+    } else {
+        if (!baseValid && !DecodeLastKeyframe()) return false;
+        out = base;
+        ok = ZeroRleDecodeXor(entry.data.data(), entry.data.size(), dst, sizeof(MachineState));
+        sinceKeyframe--;
+    }
+    totalBytes -= entry.data.size();
+    entries.pop_back();
+    return ok;
+}
+
+void RewindBuffer::Clear() {
+    entries.clear();
+    totalBytes = 0;
+    baseValid = false;
+    sinceKeyframe = 0;
+}
+
+// Re-establish the XOR base after the newest keyframe was popped
+bool RewindBuffer::DecodeLastKeyframe() {
+    int deltas = 0;
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        if (it->keyframe) {
+            if (!ZeroRleDecode(it->data.data(), it->data.size(), reinterpret_cast<uint8_t*>(&base), sizeof(MachineState)))
+                return false;
+            baseValid = true;
+            sinceKeyframe = deltas;
+            return true;
+        }
+        deltas++;
+    }
+    return false;
+}
+
+void RewindBuffer::Evict() {
+    while (totalBytes > maxBytes) {
+        // Never drop the newest group: it holds the current XOR base
+        size_t groupEnd = 1;
+        while (groupEnd < entries.size() && !entries[groupEnd].keyframe) groupEnd++;
+        if (groupEnd >= entries.size()) break;
+        for (size_t i = 0; i < groupEnd; ++i) {
+            totalBytes -= entries.front().data.size();
+            entries.pop_front();
+        }
+    }
+}
@@ -0,0 +1,266 @@
+// Headless test-ROM runner. Every manifest line names a ROM, how it reports
+// its result and a wall-clock budget; ROMs run in parallel, one Console each.
+//
+//   status <code>  blargg convention: $6001-$6003 hold DE B0 61 once the
+//                  protocol is active, $6000 is $80 while running, $81 when
+//                  the ROM asks for a reset and the result code when done.
+//                  Text output is at $6004 (zero terminated).
+//   result <code>  older blargg ROMs (the 2005 PPU tests): $F0 holds the
+//                  test being run and then the result, 1 = pass, 2 and up
+//                  = the test that failed. Done once $F0 is nonzero and has
+//                  not changed for STABLE_FRAMES frames.
+//   frame <hash>   run the given number of frames; the picture must have
+//                  been unchanged for the last STABLE_FRAMES of them and
+//                  match HashFrame <hash>.
+//   skip <reason>  not run (e.g. an unimplemented mapper); fails once the
+//                  ROM's mapper is supported so it gets a real expectation.
+//
+// Any other ROM whose mapper is not implemented fails instead of being
+// measured. Budgets are for an optimized (NDEBUG) build and are scaled by
+// BUDGET_SCALE otherwise.
+//
+// Usage: rom_tests <manifest> [threads] [--update]
+// --update prints the manifest with the observed results filled in and the
+// budgets derived from the measured times.
+#include "headers/console.h"
+#include "headers/fingerprint.h"
+#include "headers/threadpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr uint32_t STABLE_FRAMES = 30;
+constexpr uint32_t RESET_DELAY_FRAMES = 6;  // the protocol asks for at least 100ms
+#ifdef NDEBUG
+constexpr double BUDGET_SCALE = 1;
+#else
+constexpr double BUDGET_SCALE = 3;          // unoptimized builds run 2-3x slower
+#endif
+// --update: budget = measured time x BUDGET_SLACK, rounded up to BUDGET_STEP_MS
+constexpr double BUDGET_SLACK = 1.5;
+constexpr double BUDGET_STEP_MS = 50;
+constexpr double BUDGET_MIN_MS = 100;
+
+struct RomTest {
+    std::string rom;
+    std::string mode;
+    std::string expect;     // skip: the reason
+    uint32_t maxFrames = 0;
+    double budgetMs = 0;    // 0 = no time limit
+
+    // Results
+    std::string actual;
+    std::string failure;
+    std::string text;
+    uint32_t frames = 0;
+    double ms = 0;
+};
+
+// Cartridge load messages go to std::cout/std::cerr; keep them out of the
+// report (load failures and missing mappers show up as test failures)
+struct NullBuffer : std::streambuf {
+    int overflow(int c) override { return c; }
+};
+
+std::string ReadResultText(Bus& bus) {
+    std::string text;
+    for (uint16_t addr = 0x6004; addr < 0x8000; ++addr) {
+        uint8_t c = bus.read(addr);
+        if (c == 0) break;
+        if (c == 0x1B) {
+            // Skip ANSI colour sequences
+            while (addr < 0x7FFF && bus.read(addr) != 'm') ++addr;
+            continue;
+        }
+        text += char(c);
+    }
+    return text;
+}
+
+bool ProtocolActive(Bus& bus) {
+    return bus.read(0x6001) == 0xDE && bus.read(0x6002) == 0xB0 && bus.read(0x6003) == 0x61;
+}
+
+void RunStatusTest(Console& console, RomTest& t) {
+    uint32_t resetAt = 0;
+    for (t.frames = 0; t.frames < t.maxFrames; ++t.frames) {
+        console.RunFrame(false);
+        if (!ProtocolActive(console.bus)) continue;
+        uint8_t status = console.bus.read(0x6000);
+        if (status == 0x81 && resetAt == 0) resetAt = t.frames + RESET_DELAY_FRAMES;
+        if (resetAt != 0 && t.frames >= resetAt) {
+            console.cpu.Reset(console.bus);
+            resetAt = 0;
+        }
+        if (status < 0x80) {
+            t.actual = std::to_string(status);
+            t.text = ReadResultText(console.bus);
+            if (t.actual != t.expect) t.failure = "result " + t.actual + ", expected " + t.expect;
+            return;
+        }
+    }
+    t.actual = "-";
+    t.failure = ProtocolActive(console.bus) ? "no result" : "no $6000 status";
+}
+
+void RunResultTest(Console& console, RomTest& t) {
+    uint8_t last = 0;
+    uint32_t same = 0;
+    for (t.frames = 0; t.frames < t.maxFrames; ++t.frames) {
+        console.RunFrame(false);
+        uint8_t code = console.bus.read(0xF0);
+        same = code == last ? same + 1 : 0;
+        last = code;
+        if (code != 0 && same + 1 >= STABLE_FRAMES) {
+            t.actual = std::to_string(code);
+            if (t.actual != t.expect) t.failure = "result " + t.actual + ", expected " + t.expect;
+            return;
+        }
+    }
+    t.actual = "-";
+    t.failure = last ? "result at $F0 still changing" : "no result at $F0";
+}
+
+void RunFrameTest(Console& console, RomTest& t) {
+    // Frames before the last STABLE_FRAMES are not drawn
+    Hash128 last;
+    uint32_t same = 0;
+    for (t.frames = 0; t.frames < t.maxFrames; ++t.frames) {
+        bool draw = t.frames + STABLE_FRAMES >= t.maxFrames;
+        console.RunFrame(draw);
+        if (!draw) continue;
+        const std::vector<uint32_t>& fb = console.GetFramebuffer();
+        Hash128 h = HashFrame(fb.data(), fb.size());
+        same = h == last ? same + 1 : 0;
+        last = h;
+    }
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(last.lo));
+    t.actual = hex;
+    if (same + 1 < STABLE_FRAMES) t.failure = "picture still changing after " + std::to_string(t.maxFrames) + " frames";
+    else if (t.actual != t.expect) t.failure = "frame " + t.actual + ", expected " + t.expect;
+}
+
+void RunTest(RomTest& t, const std::string& baseDir) {
+    auto console = std::make_unique<Console>();
+    if (!console->LoadROM(baseDir + t.rom)) {
+        t.failure = "failed to load";
+        return;
+    }
+    int missing = console->bus.missingMapper;
+    if (t.mode == "skip") {
+        if (missing < 0) t.failure = "mapper is supported now; replace 'skip' with an expected result";
+        return;
+    }
+    if (missing >= 0) {
+        t.failure = "mapper " + std::to_string(missing) + " is not implemented";
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (t.mode == "status") RunStatusTest(*console, t);
+    else if (t.mode == "result") RunResultTest(*console, t);
+    else RunFrameTest(*console, t);
+    t.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    double budget = t.budgetMs * BUDGET_SCALE;
+    if (t.failure.empty() && budget > 0 && t.ms > budget) {
+        t.failure = "took " + std::to_string(int(t.ms)) + " ms, budget " + std::to_string(int(budget)) + " ms";
+    }
+}
+
+bool LoadManifest(const std::string& path, std::vector<RomTest>& tests) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Failed to open manifest: " << path << std::endl;
+        return false;
+    }
+    int lineNo = 0;
+    for (std::string line; std::getline(in, line);) {
+        ++lineNo;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream fields(line);
+        RomTest t;
+        if (!(fields >> t.rom)) continue;
+        if (fields >> t.mode && t.mode == "skip" && std::getline(fields >> std::ws, t.expect) && !t.expect.empty()) {
+            while (t.expect.back() == ' ' || t.expect.back() == '\t') t.expect.pop_back();
+            tests.push_back(t);
+            continue;
+        }
+        if (!(fields >> t.expect >> t.maxFrames >> t.budgetMs) ||
+            (t.mode != "status" && t.mode != "result" && t.mode != "frame")) {
+            std::cerr << path << ":" << lineNo << ": expected '<rom> status|result|frame <expect> <frames> <budget_ms>'"
+                      << " or '<rom> skip <reason>'\n";
+            return false;
+        }
+        tests.push_back(t);
+    }
+    return true;
+}
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: rom_tests <manifest> [threads] [--update]\n";
+        return 1;
+    }
+    std::string manifest = argv[1];
+    size_t threads = 0;
+    bool update = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--update") == 0) update = true;
+        else threads = static_cast<size_t>(std::stoul(argv[i]));
+    }
+
+    std::vector<RomTest> tests;
+    if (!LoadManifest(manifest, tests)) return 1;
+    size_t slash = manifest.find_last_of("/\\");
+    std::string baseDir = slash == std::string::npos ? std::string() : manifest.substr(0, slash + 1);
+
+    NullBuffer sink;
+    std::streambuf* coutBuf = std::cout.rdbuf(&sink);
+    std::streambuf* cerrBuf = std::cerr.rdbuf(&sink);
+    ThreadPool pool(threads);
+    pool.ParallelFor(tests.size(), [&](size_t i) { RunTest(tests[i], baseDir); });
+    std::cout.rdbuf(coutBuf);
+    std::cerr.rdbuf(cerrBuf);
+
+    size_t failed = 0, skipped = 0;
+    for (const RomTest& t : tests) {
+        if (update) {
+            if (t.mode == "skip") {
+                std::printf("%-36s %-6s %s\n", t.rom.c_str(), t.mode.c_str(), t.expect.c_str());
+                continue;
+            }
+            double budget = t.ms > 0 ? std::ceil(t.ms / BUDGET_SCALE * BUDGET_SLACK / BUDGET_STEP_MS) * BUDGET_STEP_MS : t.budgetMs;
+            std::printf("%-36s %-6s %-16s %6u %6.0f\n", t.rom.c_str(), t.mode.c_str(),
+                t.actual.empty() ? t.expect.c_str() : t.actual.c_str(), t.maxFrames, std::max(budget, BUDGET_MIN_MS));
+            continue;
+        }
+        if (t.mode == "skip" && t.failure.empty()) {
+            ++skipped;
+            std::printf("SKIP %-36s %s\n", t.rom.c_str(), t.expect.c_str());
+        } else if (t.failure.empty()) {
+            std::printf("PASS %-36s %5u frames %8.1f ms\n", t.rom.c_str(), t.frames, t.ms);
+        } else {
+            ++failed;
+            std::printf("FAIL %-36s %s\n", t.rom.c_str(), t.failure.c_str());
+            if (!t.text.empty()) std::printf("%s\n", t.text.c_str());
+        }
+    }
+    if (!update) {
+        std::printf("%zu/%zu ROM tests passed", tests.size() - failed - skipped, tests.size() - skipped);
+        if (skipped) std::printf(", %zu skipped", skipped);
+        std::printf("\n");
+    }
+    return failed == 0 ? 0 : 1;
+}
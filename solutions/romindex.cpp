@@ -0,0 +1,302 @@
+#include "headers/romindex.h"
+#include "headers/hash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr char INDEX_MAGIC[8] = {'N', 'E', 'S', 'I', 'D', 'X', 0, 0};
+constexpr uint32_t INDEX_VERSION = 1;
+
+// Fixed on-disk record; the path bytes follow it directly.
+struct IndexRecord {
+    uint64_t fileSize;
+    int64_t mtime;
+    uint64_t hash;
+    uint32_t prgSize;
+    uint32_t chrSize;
+    uint32_t prgRamSize;
+    uint32_t chrRamSize;
+    uint16_t mapper;
+    uint16_t pathLen;
+    uint8_t submapper;
+    uint8_t format;
+    uint8_t mirroring;
+    uint8_t flags; // bit0 = battery, bit1 = trainer
+    uint8_t header[16];
+};
+
+bool IsRomFile(const fs::path& p) {
+    std::string ext = p.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext == ".nes";
+}
+
+// One spelling per file however the directory was named ("roms", "./roms",
+// an absolute path); weakly_canonical also covers files that are gone
+std::string CanonicalPath(const std::string& path) {
+    std::error_code ec;
+    fs::path p = fs::weakly_canonical(path, ec);
+    return (ec ? fs::path(path).lexically_normal() : p).generic_string();
+}
+
+int64_t FileMtime(const fs::path& p, std::error_code& ec) {
+    auto t = fs::last_write_time(p, ec);
+    return ec ? 0 : static_cast<int64_t>(t.time_since_epoch().count());
+}
+
+// NES 2.0 ROM size: either a plain unit count or the exponent-multiplier form
+uint32_t Nes20RomSize(uint8_t lsb, uint8_t msbNibble, uint32_t unit) {
+    if (msbNibble == 0x0F) {
+        uint32_t exponent = lsb >> 2;
+        uint32_t multiplier = (lsb & 0x03) * 2 + 1;
+        if (exponent > 31) return 0;
+        return (1u << exponent) * multiplier;
+    }
+    return ((uint32_t(msbNibble) << 8) | lsb) * unit;
+}
+
+uint32_t Nes20RamSize(uint8_t shift) {
+    return shift ? (64u << shift) : 0;
+}
+
+// Read a ROM file once, fill header fields and the content hash
+bool HashRomFile(RomInfo& info) {
+    std::ifstream file(info.path, std::ios::binary);
+    if (!file) return false;
+    std::vector<uint8_t> data(static_cast<size_t>(info.fileSize));
+    file.read(reinterpret_cast<char*>(data.data()), data.size());
+    data.resize(static_cast<size_t>(file.gcount()));
+
+    if (data.size() >= 16 && ParseRomHeader(data.data(), info)) {
+        size_t prgOffset = 16 + (info.trainer ? 512 : 0);
+        size_t prgLen = std::min<size_t>(info.prgSize, data.size() > prgOffset ? data.size() - prgOffset : 0);
+        size_t chrOffset = prgOffset + prgLen;
+        size_t chrLen = std::min<size_t>(info.chrSize, data.size() > chrOffset ? data.size() - chrOffset : 0);
+        info.hash = HashRomData(data.data() + prgOffset, prgLen, data.data() + chrOffset, chrLen);
+    } else {
+        // Raw PRG image: the whole file is PRG (matches Bus::LoadPRGFromFile)
+        info.format = RomFormat::Unknown;
+        info.prgSize = static_cast<uint32_t>(data.size());
+        info.hash = HashRomData(data.data(), data.size(), nullptr, 0);
+    }
+    return true;
+}
+}
+
+bool ParseRomHeader(const uint8_t* header, RomInfo& out) {
+    if (!(header[0] == 'N' && header[1] == 'E' && header[2] == 'S' && header[3] == 0x1A)) return false;
+    std::copy(header, header + 16, out.header);
+
+    uint8_t flags6 = header[6];
+    uint8_t flags7 = header[7];
+    out.trainer = (flags6 & 0x04) != 0;
+    out.battery = (flags6 & 0x02) != 0;
+    if (flags6 & 0x08) out.mirroring = Mirroring::FourScreen;
+    else if (flags6 & 0x01) out.mirroring = Mirroring::Vertical;
+    else out.mirroring = Mirroring::Horizontal;
+
+    out.mapper = static_cast<uint16_t>((flags7 & 0xF0) | (flags6 >> 4));
+    if ((flags7 & 0x0C) == 0x08) {
+        out.format = RomFormat::NES20;
+        out.mapper |= static_cast<uint16_t>((header[8] & 0x0F) << 8);
+        out.submapper = header[8] >> 4;
+        out.prgSize = Nes20RomSize(header[4], header[9] & 0x0F, 0x4000);
+        out.chrSize = Nes20RomSize(header[5], header[9] >> 4, 0x2000);
+        out.prgRamSize = Nes20RamSize(header[10] & 0x0F) + Nes20RamSize(header[10] >> 4);
+        out.chrRamSize = Nes20RamSize(header[11] & 0x0F) + Nes20RamSize(header[11] >> 4);
+    } else {
+        out.format = RomFormat::INES;
+        out.submapper = 0;
+        out.prgSize = uint32_t(header[4]) * 0x4000;
+        out.chrSize = uint32_t(header[5]) * 0x2000;
+        out.prgRamSize = (header[8] ? header[8] : 1) * 0x2000u;
+        out.chrRamSize = out.chrSize ? 0 : 0x2000;
+    }
+    return true;
+}
+
+std::vector<std::string> ListRomFiles(const std::string& directory) {
+    std::vector<std::string> paths;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, ec), endIt;
+         !ec && it != endIt; it.increment(ec)) {
+        if (it->is_regular_file(ec) && IsRomFile(it->path())) paths.push_back(it->path().generic_string());
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+bool RomIndex::Load(const std::string& indexPath) {
+    std::ifstream file(indexPath, std::ios::binary);
+    if (!file) return false;
+    std::vector<char> buf((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    size_t pos = 0;
+    auto take = [&](void* dst, size_t n) {
+        if (pos + n > buf.size()) return false;
+        std::memcpy(dst, buf.data() + pos, n);
+        pos += n;
+        return true;
+    };
+
+    char magic[8];
+    uint32_t version = 0, count = 0;
+    if (!take(magic, sizeof(magic)) || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0) return false;
+    if (!take(&version, sizeof(version)) || version != INDEX_VERSION) return false;
+    if (!take(&count, sizeof(count))) return false;
+    // Every entry takes at least a record, so a corrupt count cannot make
+    // the reserve below allocate more than the file could describe
+    if (count > (buf.size() - pos) / sizeof(IndexRecord)) return false;
+
+    std::vector<RomInfo> loaded;
+    loaded.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        IndexRecord rec;
+        if (!take(&rec, sizeof(rec)) || pos + rec.pathLen > buf.size()) return false;
+        RomInfo info;
+        info.path.assign(buf.data() + pos, rec.pathLen);
+        pos += rec.pathLen;
+        info.fileSize = rec.fileSize;
+        info.mtime = rec.mtime;
+        info.hash = rec.hash;
+        info.prgSize = rec.prgSize;
+        info.chrSize = rec.chrSize;
+        info.prgRamSize = rec.prgRamSize;
+        info.chrRamSize = rec.chrRamSize;
+        info.mapper = rec.mapper;
+        info.submapper = rec.submapper;
+        info.format = static_cast<RomFormat>(rec.format);
+        info.mirroring = static_cast<Mirroring>(rec.mirroring);
+        info.battery = (rec.flags & 1) != 0;
+        info.trainer = (rec.flags & 2) != 0;
+        std::memcpy(info.header, rec.header, sizeof(info.header));
+        loaded.push_back(std::move(info));
+    }
+    entries = std::move(loaded);
+    return true;
+}
+
+bool RomIndex::Save(const std::string& indexPath) const {
+    std::ofstream file(indexPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to write ROM index: " << indexPath << std::endl;
+        return false;
+    }
+    uint32_t version = INDEX_VERSION;
+    uint32_t count = static_cast<uint32_t>(entries.size());
+    file.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const RomInfo& info : entries) {
+        IndexRecord rec{};
+        rec.fileSize = info.fileSize;
+        rec.mtime = info.mtime;
+        rec.hash = info.hash;
+        rec.prgSize = info.prgSize;
+        rec.chrSize = info.chrSize;
+        rec.prgRamSize = info.prgRamSize;
+        rec.chrRamSize = info.chrRamSize;
+        rec.mapper = info.mapper;
+        rec.pathLen = static_cast<uint16_t>(std::min<size_t>(info.path.size(), 0xFFFF));
+        rec.submapper = info.submapper;
+        rec.format = static_cast<uint8_t>(info.format);
+        rec.mirroring = static_cast<uint8_t>(info.mirroring);
+        rec.flags = (info.battery ? 1 : 0) | (info.trainer ? 2 : 0);
+        std::memcpy(rec.header, info.header, sizeof(rec.header));
+        file.write(reinterpret_cast<const char*>(&rec), sizeof(rec));
+        file.write(info.path.data(), rec.pathLen);
+    }
+    return bool(file);
+}
+
+size_t RomIndex::Scan(const std::string& directory, unsigned threads) {
+    // Cached entries are matched by canonical path, so a rescan under another
+    // spelling of the same directory reuses them instead of rehashing
+    std::vector<std::string> canonical(entries.size());
+    std::unordered_map<std::string, size_t> byPath;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        canonical[i] = CanonicalPath(entries[i].path);
+        byPath[canonical[i]] = i;
+    }
+
+    std::vector<RomInfo> kept;
+    std::vector<RomInfo> stale;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, ec), endIt;
+         !ec && it != endIt; it.increment(ec)) {
+        if (!it->is_regular_file(ec) || !IsRomFile(it->path())) continue;
+        RomInfo info;
+        info.path = it->path().generic_string();
+        info.fileSize = it->file_size(ec);
+        info.mtime = FileMtime(it->path(), ec);
+        if (ec) { ec.clear(); continue; }
+
+        auto found = byPath.find(CanonicalPath(info.path));
+        if (found != byPath.end()) {
+            const RomInfo& cached = entries[found->second];
+            if (cached.fileSize == info.fileSize && cached.mtime == info.mtime) {
+                kept.push_back(cached);
+                continue;
+            }
+        }
+        stale.push_back(std::move(info));
+    }
+
+    // Hash new/changed files in parallel; each worker pulls the next file index
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(stale.size(), 1)));
+    std::atomic<size_t> next{0};
+    std::vector<uint8_t> ok(stale.size(), 0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < stale.size(); i = next++) {
+            ok[i] = HashRomFile(stale[i]) ? 1 : 0;
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+
+    // Keep entries outside the scanned directory untouched
+    std::string prefix = CanonicalPath(directory);
+    if (!prefix.empty() && prefix.back() != '/') prefix += '/';
+    std::vector<RomInfo> merged;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (canonical[i].compare(0, prefix.size(), prefix) != 0) merged.push_back(entries[i]);
+    }
+    for (RomInfo& info : kept) merged.push_back(std::move(info));
+    size_t hashed = 0;
+    for (size_t i = 0; i < stale.size(); ++i) {
+        if (!ok[i]) continue;
+        merged.push_back(std::move(stale[i]));
+        hashed++;
+    }
+    std::sort(merged.begin(), merged.end(), [](const RomInfo& a, const RomInfo& b) { return a.path < b.path; });
+    entries = std::move(merged);
+    return hashed;
+}
+
+const RomInfo* RomIndex::FindByHash(uint64_t hash) const {
+    for (const RomInfo& info : entries) {
+        if (info.hash == hash) return &info;
+    }
+    return nullptr;
+}
+
+const RomInfo* RomIndex::FindByPath(const std::string& path) const {
+    auto it = std::lower_bound(entries.begin(), entries.end(), path,
+                               [](const RomInfo& a, const std::string& p) { return a.path < p; });
+    if (it != entries.end() && it->path == path) return &*it;
+    return nullptr;
+}
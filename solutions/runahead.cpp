@@ -0,0 +1,14 @@
+#include "headers/runahead.h"
+#include "headers/cpu.h"
+
+void RunAhead::RunFrame(CPU& cpu, Bus& bus, u32& cycles) {
+    // Only the last run-ahead frame is ever shown
+    cpu.RunFrame(cycles, bus, frames <= 0);
+    if (frames <= 0) return;
+
+    Snapshot(cpu, bus, cycles, saved);
+    for (int i = 0; i < frames; ++i) {
+        cpu.RunFrame(cycles, bus, i == frames - 1);
+    }
+    Restore(cpu, bus, cycles, saved);
+}
@@ -0,0 +1,96 @@
+#include "headers/savestate.h"
+#include "headers/cpu.h"
+#include "headers/ppu.h"
+#include "headers/mapper.h"
+
+#include <algorithm>
+#include <cstring>
+
+void Snapshot(const CPU& cpu, const Bus& bus, u32 cycles, MachineState& out) {
+    out.magic = MachineState::MAGIC;
+    out.version = MachineState::VERSION;
+
+    CPUState& c = out.cpu;
+    c.cycles = cycles;
+    c.PC = cpu.PC;
+    c.SP = cpu.SP;
+    c.A = cpu.A;
+    c.X = cpu.X;
+    c.Y = cpu.Y;
+    c.P = cpu.P;
+    c.interrupt = cpu.Interrupt ? 1 : 0;
+    c.nmiRequested = cpu.NMIRequested ? 1 : 0;
+    c.prevNmiLine = cpu.prevNmiLine ? 1 : 0;
+    c.pad[0] = c.pad[1] = 0;
+
+    // Only the 2KB of internal RAM is state; the rest of the Mem image is never read back
+    BusState& b = out.bus;
+    std::memcpy(b.ram, bus.ram.Data, sizeof(b.ram));
+    if (bus.chrIsRam) {
+        size_t n = std::min(bus.chrRom.size(), sizeof(b.chrRam));
+        std::memcpy(b.chrRam, bus.chrRom.data(), n);
+        std::memset(b.chrRam + n, 0, sizeof(b.chrRam) - n);
+    } else {
+        std::memset(b.chrRam, 0, sizeof(b.chrRam));
+    }
+    b.oamDmaCycles = bus.oamDmaCycles;
+    b.oamDmaIndex = bus.oamDmaIndex;
+    b.irqEnable = bus.irqEnable ? 1 : 0;
+    b.nmiLine = bus.nmiLine ? 1 : 0;
+    b.mirrorVertical = bus.mirrorVertical ? 1 : 0;
+    b.chrIsRam = bus.chrIsRam ? 1 : 0;
+    b.oamDmaActive = bus.oamDmaActive ? 1 : 0;
+    b.oamDmaPage = bus.oamDmaPage;
+    b.oamDmaDummy = bus.oamDmaDummy ? 1 : 0;
+    b.pad[0] = b.pad[1] = b.pad[2] = 0;
+
+    bus.input.SaveState(out.input);
+
+    if (bus.ppu) bus.ppu->SaveState(out.ppu);
+    else std::memset(&out.ppu, 0, sizeof(out.ppu));
+
+    if (bus.mapper) {
+        bus.mapper->SaveState(out.mapper);
+    } else {
+        std::memset(&out.mapper, 0, sizeof(out.mapper));
+        out.mapper.mapperId = 0xFFFF;
+    }
+}
+
+bool Restore(CPU& cpu, Bus& bus, u32& cycles, const MachineState& state) {
+    if (state.magic != MachineState::MAGIC || state.version != MachineState::VERSION) return false;
+    uint16_t mapperId = bus.mapper ? static_cast<uint16_t>(bus.mapper->number) : 0xFFFF;
+    if (state.mapper.mapperId != mapperId) return false;
+
+    const CPUState& c = state.cpu;
+    cycles = c.cycles;
+    cpu.PC = c.PC;
+    cpu.SP = c.SP;
+    cpu.A = c.A;
+    cpu.X = c.X;
+    cpu.Y = c.Y;
+    cpu.P = c.P;
+    cpu.Interrupt = c.interrupt != 0;
+    cpu.NMIRequested = c.nmiRequested != 0;
+    cpu.prevNmiLine = c.prevNmiLine != 0;
+
+    const BusState& b = state.bus;
+    std::memcpy(bus.ram.Data, b.ram, sizeof(b.ram));
+    if (bus.chrIsRam) {
+        size_t n = std::min(bus.chrRom.size(), sizeof(b.chrRam));
+        std::memcpy(bus.chrRom.data(), b.chrRam, n);
+    }
+    bus.oamDmaCycles = b.oamDmaCycles;
+    bus.oamDmaIndex = b.oamDmaIndex;
+    bus.irqEnable = b.irqEnable != 0;
+    bus.nmiLine = b.nmiLine != 0;
+    bus.mirrorVertical = b.mirrorVertical != 0;
+    bus.oamDmaActive = b.oamDmaActive != 0;
+    bus.oamDmaPage = b.oamDmaPage;
+    bus.oamDmaDummy = b.oamDmaDummy != 0;
+
+    bus.input.LoadState(state.input);
+    if (bus.ppu) bus.ppu->LoadState(state.ppu);
+    if (bus.mapper) bus.mapper->LoadState(state.mapper);
+    return true;
+}
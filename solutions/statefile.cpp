@@ -0,0 +1,80 @@
+#include "headers/statefile.h"
+#include "headers/delta.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+bool SaveStateFile(const std::string& path, const MachineState& state, uint64_t romHash, bool compress) {
+    const uint8_t* raw = reinterpret_cast<const uint8_t*>(&state);
+    std::vector<uint8_t> packed;
+    if (compress) ZeroRleEncode(raw, sizeof(MachineState), packed);
+
+    StateFileHeader h{};
+    std::memcpy(h.magic, StateFileHeader::MAGIC, sizeof(h.magic));
+    h.version = StateFileHeader::VERSION;
+    h.stateVersion = MachineState::VERSION;
+    h.stateSize = sizeof(MachineState);
+    h.flags = compress ? StateFileHeader::FLAG_COMPRESSED : 0;
+    h.romHash = romHash;
+    h.mapperId = state.mapper.mapperId;
+    h.payloadSize = compress ? packed.size() : sizeof(MachineState);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to write state file: " << path << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    if (compress) file.write(reinterpret_cast<const char*>(packed.data()), packed.size());
+    else file.write(reinterpret_cast<const char*>(raw), sizeof(MachineState));
+    return bool(file);
+}
+
+bool StateFileView::Open(const std::string& path) {
+    header = nullptr;
+    if (!file.Open(path)) return false;
+    if (file.Size() < sizeof(StateFileHeader)) return false;
+    const StateFileHeader* h = reinterpret_cast<const StateFileHeader*>(file.Data());
+    if (std::memcmp(h->magic, StateFileHeader::MAGIC, sizeof(h->magic)) != 0) return false;
+    if (h->version != StateFileHeader::VERSION || h->stateVersion != MachineState::VERSION ||
+        h->stateSize != sizeof(MachineState)) {
+        std::cerr << "Incompatible state file version: " << path << std::endl;
+        return false;
+    }
+    bool compressed = (h->flags & StateFileHeader::FLAG_COMPRESSED) != 0;
+    if (file.Size() - sizeof(StateFileHeader) < h->payloadSize ||
+        (!compressed && h->payloadSize != sizeof(MachineState))) {
+        std::cerr << "Truncated state file: " << path << std::endl;
+        return false;
+    }
+    header = h;
+    return true;
+}
+
+const MachineState* StateFileView::State() const {
+    if (!header || IsCompressed()) return nullptr;
+    return reinterpret_cast<const MachineState*>(file.Data() + sizeof(StateFileHeader));
+}
+
+bool StateFileView::Decode(MachineState& out) const {
+    if (!header) return false;
+    const uint8_t* payload = file.Data() + sizeof(StateFileHeader);
+    if (!IsCompressed()) {
+        std::memcpy(&out, payload, sizeof(MachineState));
+        return true;
+    }
+    return ZeroRleDecode(payload, static_cast<size_t>(header->payloadSize),
+                         reinterpret_cast<uint8_t*>(&out), sizeof(MachineState));
+}
+
+bool LoadStateFile(const std::string& path, MachineState& out, uint64_t romHash) {
+    StateFileView view;
+    if (!view.Open(path)) return false;
+    if (romHash != 0 && view.Header()->romHash != romHash) {
+        std::cerr << "State file " << path << " belongs to a different ROM" << std::endl;
+        return false;
+    }
+    return view.Decode(out);
+}
@@ -0,0 +1,8 @@
+#include "headers/table.h"
+
+// Constant-initialized: no startup code and never written, so any number of
+// CPUs on any number of threads can dispatch through it
+const std::array<CPU::InstructionHandler, 256> CPU::instructionTable = BuildInstructionTable();
+
+static_assert(BuildInstructionTable()[0xA9] == &InstructionHandlers::LDA_IM_Handler,
+              "instruction table must be a compile-time constant");
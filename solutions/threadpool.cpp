@@ -0,0 +1,131 @@
+#include "headers/threadpool.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+ThreadPool::ThreadPool(size_t threads, bool pinToCores) {
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    if (threads == 0) threads = hw;
+    queues.reset(new Queue[threads]);
+    queueCount = threads;
+
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+#if defined(__linux__)
+        if (pinToCores) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(i % hw, &set);
+            pthread_setaffinity_np(workers.back().native_handle(), sizeof(set), &set);
+        }
+#else
+        (void)pinToCores;
+#endif
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers) t.join();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+    size_t n = queueCount;
+    if (n == 1 || count == 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t w = 0; w < n; ++w) {
+            std::lock_guard<std::mutex> q(queues[w].m);
+            queues[w].begin = count * w / n;
+            queues[w].end = count * (w + 1) / n;
+        }
+        remaining.store(count, std::memory_order_relaxed);
+        job = &fn;
+        ++generation;
+    }
+    wake.notify_all();
+
+    RunTasks(0, fn);
+
+    // Wait until every task has run and no worker still holds fn
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return remaining.load(std::memory_order_acquire) == 0 && activeWorkers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::WorkerLoop(size_t self) {
+    uint64_t seen = 0;
+    for (;;) {
+        const std::function<void(size_t)>* fn;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            fn = job;
+            if (!fn) continue;
+            ++activeWorkers;
+        }
+        RunTasks(self, *fn);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --activeWorkers;
+        }
+        finished.notify_all();
+    }
+}
+
+void ThreadPool::RunTasks(size_t self, const std::function<void(size_t)>& fn) {
+    size_t index;
+    while (Pop(self, index) || Steal(self, index)) {
+        fn(index);
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::Pop(size_t self, size_t& index) {
+    Queue& q = queues[self];
+    std::lock_guard<std::mutex> lock(q.m);
+    if (q.begin == q.end) return false;
+    index = q.begin++;
+    return true;
+}
+
+bool ThreadPool::Steal(size_t self, size_t& index) {
+    size_t n = queueCount;
+    // Take from the back of whichever queue has the most work left
+    size_t victim = self;
+    size_t most = 0;
+    for (size_t k = 1; k < n; ++k) {
+        size_t w = (self + k) % n;
+        Queue& q = queues[w];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (q.end - q.begin > most) {
+            most = q.end - q.begin;
+            victim = w;
+        }
+    }
+    if (victim == self) return false;
+    Queue& q = queues[victim];
+    std::lock_guard<std::mutex> lock(q.m);
+    if (q.begin == q.end) return false;
+    index = --q.end;
+    steals.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
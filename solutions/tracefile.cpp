@@ -0,0 +1,165 @@
+#include "headers/tracefile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+inline int HexVal(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return 10 + (c - 'a');
+    if (c >= 'A' && c <= 'F') return 10 + (c - 'A');
+    return -1;
+}
+
+inline bool HexByte(const char* p, const char* end, uint8_t& out) {
+    if (end - p < 2) return false;
+    int hi = HexVal(p[0]), lo = HexVal(p[1]);
+    if (hi < 0 || lo < 0) return false;
+    out = static_cast<uint8_t>(hi << 4 | lo);
+    return true;
+}
+
+// Find "tag" preceded by a space (or at the start) and parse the hex byte after it
+bool TaggedByte(const char* line, const char* end, const char* tag, uint8_t& out) {
+    size_t tagLen = std::strlen(tag);
+    for (const char* p = line; p + tagLen <= end; ++p) {
+        p = static_cast<const char*>(std::memchr(p, tag[0], size_t(end - p)));
+        if (!p || p + tagLen > end) return false;
+        if ((p == line || p[-1] == ' ') && std::memcmp(p, tag, tagLen) == 0) return HexByte(p + tagLen, end, out);
+    }
+    return false;
+}
+}
+
+bool ParseTraceLine(const char* line, size_t len, TraceRecord& out) {
+    const char* end = line + len;
+    uint8_t hi, lo;
+    if (!HexByte(line, end, hi) || !HexByte(line + 2, end, lo)) return false;
+    std::memset(&out, 0, sizeof(out));
+    out.pc = static_cast<uint16_t>(hi << 8 | lo);
+
+    // Instruction bytes: up to three hex pairs after the address
+    const char* p = line + 4;
+    while (p < end && *p == ' ') ++p;
+    while (out.length < 3 && HexByte(p, end, out.bytes[out.length]) && (p + 2 == end || p[2] == ' ')) {
+        ++out.length;
+        p += 3;
+    }
+    if (out.length == 0) return false;
+
+    if (!TaggedByte(p, end, "A:", out.a) || !TaggedByte(p, end, "X:", out.x) || !TaggedByte(p, end, "Y:", out.y) ||
+        !TaggedByte(p, end, "P:", out.p)) {
+        return false;
+    }
+    if (!TaggedByte(p, end, "SP:", out.sp) && !TaggedByte(p, end, "S:", out.sp)) return false;
+
+    for (const char* c = p; c + 4 <= end; ++c) {
+        if (std::memcmp(c, "CYC:", 4) != 0) continue;
+        c += 4;
+        while (c < end && *c == ' ') ++c;
+        uint64_t cycles = 0;
+        bool any = false;
+        for (; c < end && *c >= '0' && *c <= '9'; ++c, any = true) cycles = cycles * 10 + uint64_t(*c - '0');
+        if (any) {
+            out.cycles = static_cast<uint32_t>(cycles);
+            out.flags |= TraceRecord::FLAG_CYCLES;
+        }
+        break;
+    }
+    return true;
+}
+
+int64_t ConvertTraceLog(const std::string& textPath, const std::string& binPath) {
+    MappedFile text;
+    if (!text.Open(textPath)) {
+        std::cerr << "Failed to open trace log: " << textPath << std::endl;
+        return -1;
+    }
+    std::ofstream out(binPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to create trace file: " << binPath << std::endl;
+        return -1;
+    }
+    TraceFileHeader header{};
+    std::memcpy(header.magic, TraceFileHeader::MAGIC, sizeof(header.magic));
+    header.version = TraceFileHeader::VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Records are written in 64K batches
+    std::vector<TraceRecord> batch;
+    batch.reserve(65536);
+    const char* p = reinterpret_cast<const char*>(text.Data());
+    const char* end = p + text.Size();
+    uint64_t count = 0;
+    uint64_t line = 0, rejected = 0, firstRejected = 0;
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+        if (!eol) eol = end;
+        size_t len = size_t(eol - p);
+        if (len && p[len - 1] == '\r') --len;
+        ++line;
+        TraceRecord r;
+        if (ParseTraceLine(p, len, r)) {
+            batch.push_back(r);
+            if (batch.size() == batch.capacity()) {
+                out.write(reinterpret_cast<const char*>(batch.data()), batch.size() * sizeof(TraceRecord));
+                count += batch.size();
+                batch.clear();
+            }
+        } else if (len >= 4 && HexVal(p[0]) >= 0 && HexVal(p[1]) >= 0 && HexVal(p[2]) >= 0 && HexVal(p[3]) >= 0) {
+            // Starts with a PC but is not in a format we read: the records would misalign
+            if (!rejected) firstRejected = line;
+            ++rejected;
+        }
+        p = eol + 1;
+    }
+    out.write(reinterpret_cast<const char*>(batch.data()), batch.size() * sizeof(TraceRecord));
+    count += batch.size();
+
+    if (rejected) {
+        std::cerr << textPath << ": " << rejected << " lines with a PC could not be parsed (first at line "
+                  << firstRejected << ")" << std::endl;
+    }
+    if (count == 0) {
+        std::cerr << "No trace lines recognised in " << textPath << std::endl;
+        out.close();
+        std::remove(binPath.c_str());
+        return -1;
+    }
+
+    header.recordCount = count;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!out) {
+        std::cerr << "Failed to write trace file: " << binPath << std::endl;
+        return -1;
+    }
+    return static_cast<int64_t>(count);
+}
+
+void FormatTraceRecord(const TraceRecord& r, char* buf, size_t size) {
+    char bytes[10] = "        ";
+    for (int i = 0; i < r.length && i < 3; ++i) std::snprintf(bytes + i * 3, sizeof(bytes) - size_t(i) * 3, "%02X ", r.bytes[i]);
+    std::snprintf(buf, size, "%04X  %-9s A:%02X X:%02X Y:%02X P:%02X SP:%02X CYC:%u",
+                  r.pc, bytes, r.a, r.x, r.y, r.p, r.sp, r.cycles);
+}
+
+bool TraceFileView::Open(const std::string& path) {
+    records = nullptr;
+    count = 0;
+    if (!file.Open(path)) return false;
+    if (file.Size() < sizeof(TraceFileHeader)) return false;
+    const TraceFileHeader* header = reinterpret_cast<const TraceFileHeader*>(file.Data());
+    if (std::memcmp(header->magic, TraceFileHeader::MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TraceFileHeader::VERSION || header->recordSize != sizeof(TraceRecord) ||
+        header->recordCount > (file.Size() - sizeof(TraceFileHeader)) / sizeof(TraceRecord)) {
+        return false;
+    }
+    records = reinterpret_cast<const TraceRecord*>(file.Data() + sizeof(TraceFileHeader));
+    count = static_cast<size_t>(header->recordCount);
+    return true;
+}
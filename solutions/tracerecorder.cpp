@@ -0,0 +1,93 @@
+#include "headers/tracerecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+TraceRecorder::TraceRecorder(size_t capacity) {
+    size_t n = 1;
+    while (n < capacity) n <<= 1;
+    ring.resize(n);
+    mask = n - 1;
+}
+
+TraceRecorder::~TraceRecorder() {
+    Stop();
+}
+
+bool TraceRecorder::Start(const std::string& path) {
+    Stop();
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to create trace file: " << path << std::endl;
+        return false;
+    }
+    WriteHeader(0);
+
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    tailCache = 0;
+    stalls = 0;
+    failed = false;
+    stopping.store(false, std::memory_order_relaxed);
+    writer = std::thread(&TraceRecorder::WriterLoop, this);
+    return true;
+}
+
+bool TraceRecorder::Stop() {
+    if (!writer.joinable()) return false;
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+
+    // Record count goes into the header once everything is on disk
+    out.seekp(0);
+    WriteHeader(tail.load(std::memory_order_relaxed));
+    out.close();
+    if (failed || !out) {
+        std::cerr << "Failed to write trace file" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void TraceRecorder::WriteHeader(uint64_t count) {
+    TraceFileHeader header{};
+    std::memcpy(header.magic, TraceFileHeader::MAGIC, sizeof(header.magic));
+    header.version = TraceFileHeader::VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    header.recordCount = count;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void TraceRecorder::WaitForSpace(uint64_t h) {
+    // The cached tail is refreshed once per lap; only a ring that is still
+    // full after the refresh is a stall
+    tailCache = tail.load(std::memory_order_acquire);
+    if (h - tailCache >= ring.size()) ++stalls;
+    while (h - tailCache >= ring.size()) {
+        std::this_thread::yield();
+        tailCache = tail.load(std::memory_order_acquire);
+    }
+}
+
+void TraceRecorder::WriterLoop() {
+    for (;;) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+        if (h == t) {
+            // Stop is only requested after the producer is done, so an
+            // empty ring seen after the flag means everything is written
+            if (stopping.load(std::memory_order_acquire) && head.load(std::memory_order_acquire) == t) return;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+        size_t start = size_t(t & mask);
+        size_t n = std::min<size_t>({size_t(h - t), WRITE_BATCH, ring.size() - start});
+        if (!failed) {
+            out.write(reinterpret_cast<const char*>(&ring[start]), std::streamsize(n * sizeof(TraceRecord)));
+            failed = !out;
+        }
+        tail.store(t + n, std::memory_order_release);
+    }
+}
@@ -0,0 +1,302 @@
+#include "headers/tracestore.h"
+#include "headers/cpu.h"
+#include "headers/ppu.h"
+#include "headers/delta.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+constexpr size_t RECORD_SIZE = sizeof(TraceRecord);
+
+// Each record is predicted by the last record at the same PC (loops repeat
+// their register values and timing). The residual is the XOR with the
+// prediction, except pc (XOR with the previous instruction's fall-through
+// address, so the decoder learns pc first) and cycles (the change in
+// cycles-since-previous-instruction). Residuals are split into byte planes
+// so each field becomes long zero runs.
+constexpr size_t PREDICT_SLOTS = 4096;
+
+struct Predictor {
+    std::vector<TraceRecord> last = std::vector<TraceRecord>(PREDICT_SLOTS);
+    std::vector<uint32_t> lastStep = std::vector<uint32_t>(PREDICT_SLOTS);
+    uint32_t prevCycles = 0;
+    uint16_t nextPc = 0;
+};
+
+void EncodeRecords(const std::vector<TraceRecord>& records, std::vector<uint8_t>& out) {
+    size_t n = records.size();
+    std::vector<uint8_t> planes(n * RECORD_SIZE);
+    Predictor pred;
+    for (size_t i = 0; i < n; ++i) {
+        const TraceRecord& r = records[i];
+        size_t slot = r.pc & (PREDICT_SLOTS - 1);
+        uint32_t step = r.cycles - pred.prevCycles;
+        TraceRecord d;
+        XorBytes(reinterpret_cast<const uint8_t*>(&r), reinterpret_cast<const uint8_t*>(&pred.last[slot]),
+                 reinterpret_cast<uint8_t*>(&d), RECORD_SIZE);
+        d.cycles = step - pred.lastStep[slot];
+        d.pc = r.pc ^ pred.nextPc;
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&d);
+        for (size_t b = 0; b < RECORD_SIZE; ++b) planes[b * n + i] = bytes[b];
+        pred.last[slot] = r;
+        pred.lastStep[slot] = step;
+        pred.prevCycles = r.cycles;
+        pred.nextPc = uint16_t(r.pc + r.length);
+    }
+    ZeroRleEncode(planes.data(), planes.size(), out);
+}
+
+bool DecodeRecords(const uint8_t* in, size_t len, size_t n, std::vector<TraceRecord>& records) {
+    std::vector<uint8_t> planes(n * RECORD_SIZE);
+    if (!ZeroRleDecode(in, len, planes.data(), planes.size())) return false;
+    records.resize(n);
+    Predictor pred;
+    for (size_t i = 0; i < n; ++i) {
+        TraceRecord d;
+        uint8_t* bytes = reinterpret_cast<uint8_t*>(&d);
+        for (size_t b = 0; b < RECORD_SIZE; ++b) bytes[b] = planes[b * n + i];
+        uint16_t pc = d.pc ^ pred.nextPc;
+        size_t slot = pc & (PREDICT_SLOTS - 1);
+        TraceRecord& r = records[i];
+        XorBytes(bytes, reinterpret_cast<const uint8_t*>(&pred.last[slot]), reinterpret_cast<uint8_t*>(&r), RECORD_SIZE);
+        r.pc = pc;
+        uint32_t step = d.cycles + pred.lastStep[slot];
+        r.cycles = pred.prevCycles + step;
+        pred.last[slot] = r;
+        pred.lastStep[slot] = step;
+        pred.prevCycles = r.cycles;
+        pred.nextPc = uint16_t(r.pc + r.length);
+    }
+    return true;
+}
+
+// Frame of the instruction at offset i in a chunk
+uint64_t FrameAt(const TraceChunkIndex& idx, const std::vector<uint32_t>& frameStarts, uint32_t i) {
+    return idx.firstFrame + uint64_t(std::upper_bound(frameStarts.begin(), frameStarts.end(), i) - frameStarts.begin());
+}
+}
+
+TraceStoreWriter::~TraceStoreWriter() {
+    Close();
+}
+
+bool TraceStoreWriter::Open(const std::string& path) {
+    Close();
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to create trace store: " << path << std::endl;
+        return false;
+    }
+    TraceStoreHeader header{};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    bytesWritten = sizeof(header);
+    instructions = 0;
+    index.clear();
+    failed = false;
+    closing = false;
+    StartChunk();
+    encoder = std::thread(&TraceStoreWriter::EncoderLoop, this);
+    return true;
+}
+
+void TraceStoreWriter::Attach(CPU& c, Bus& b) {
+    cpu = &c;
+    bus = &b;
+    cpu->traceSink = this;
+    bus->AddTap(this);
+    frame = bus->ppu ? bus->ppu->frameCount : 0;
+    current.index.firstFrame = current.index.lastFrame = frame;
+}
+
+void TraceStoreWriter::Detach() {
+    if (cpu && cpu->traceSink == this) cpu->traceSink = nullptr;
+    if (bus) bus->RemoveTap(this);
+    cpu = nullptr;
+    bus = nullptr;
+}
+
+void TraceStoreWriter::StartChunk() {
+    current = Chunk{};
+    current.records.reserve(CHUNK_RECORDS);
+    current.index.firstInstruction = instructions;
+    current.index.firstFrame = current.index.lastFrame = frame;
+    current.index.pcMin = 0xFFFF;
+    current.index.pcMax = 0;
+}
+
+void TraceStoreWriter::OnInstruction(const TraceRecord& r) {
+    // A chunk is closed when the next instruction arrives, so writes made by
+    // its last instruction (and by interrupts after it) still land in it
+    if (current.records.size() == CHUNK_RECORDS) Submit();
+
+    uint64_t now = bus && bus->ppu ? bus->ppu->frameCount : frame;
+    TraceChunkIndex& idx = current.index;
+    if (now != frame) {
+        frame = now;
+        if (current.records.empty()) idx.firstFrame = frame;
+        else current.frameStarts.push_back(uint32_t(current.records.size()));
+        idx.lastFrame = frame;
+    }
+    idx.pcMin = std::min(idx.pcMin, r.pc);
+    idx.pcMax = std::max(idx.pcMax, r.pc);
+    idx.pcPages[r.pc >> 14] |= uint64_t(1) << ((r.pc >> 8) & 63);
+    current.records.push_back(r);
+    ++instructions;
+}
+
+void TraceStoreWriter::OnCPUWrite(uint16_t addr, uint8_t value) {
+    uint32_t at = current.records.empty() ? 0 : uint32_t(current.records.size() - 1);
+    current.writes.push_back({at, addr, value, 0});
+    uint16_t canonical = CanonicalAddr(addr);
+    current.index.writeBlocks[canonical >> 11] |= uint64_t(1) << ((canonical >> 5) & 63);
+}
+
+void TraceStoreWriter::Submit() {
+    current.index.count = uint32_t(current.records.size());
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        drained.wait(lock, [&] { return pending.size() < MAX_PENDING; });
+        pending.push_back(std::move(current));
+    }
+    ready.notify_one();
+    StartChunk();
+}
+
+void TraceStoreWriter::EncoderLoop() {
+    std::vector<uint8_t> blob;
+    for (;;) {
+        Chunk chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&] { return closing || !pending.empty(); });
+            if (pending.empty()) return;
+            chunk = std::move(pending.front());
+            pending.pop_front();
+        }
+        drained.notify_one();
+        blob.clear();
+        EncodeRecords(chunk.records, blob);
+        TraceChunkIndex idx = chunk.index;
+        idx.offset = bytesWritten;
+        idx.recordBytes = uint32_t(blob.size());
+        idx.writeCount = uint32_t(chunk.writes.size());
+        idx.frameStartCount = uint32_t(chunk.frameStarts.size());
+        const uint8_t* w = reinterpret_cast<const uint8_t*>(chunk.writes.data());
+        blob.insert(blob.end(), w, w + chunk.writes.size() * sizeof(TraceWrite));
+        const uint8_t* f = reinterpret_cast<const uint8_t*>(chunk.frameStarts.data());
+        blob.insert(blob.end(), f, f + chunk.frameStarts.size() * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(blob.data()), std::streamsize(blob.size()));
+        failed = failed || !out;
+        bytesWritten += blob.size();
+        std::lock_guard<std::mutex> lock(mutex);
+        index.push_back(idx);
+    }
+}
+
+bool TraceStoreWriter::Close() {
+    if (!encoder.joinable()) return false;
+    Detach();
+    if (!current.records.empty()) Submit();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    ready.notify_one();
+    encoder.join();
+
+    TraceStoreHeader header{};
+    std::memcpy(header.magic, TraceStoreHeader::MAGIC, sizeof(header.magic));
+    header.version = TraceStoreHeader::VERSION;
+    header.chunkRecords = CHUNK_RECORDS;
+    header.chunkCount = index.size();
+    header.indexOffset = bytesWritten;
+    header.instructions = instructions;
+    out.write(reinterpret_cast<const char*>(index.data()), std::streamsize(index.size() * sizeof(TraceChunkIndex)));
+    bytesWritten += index.size() * sizeof(TraceChunkIndex);
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (failed || !out) {
+        std::cerr << "Failed to write trace store" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool TraceStoreReader::Open(const std::string& path) {
+    header = nullptr;
+    index = nullptr;
+    count = 0;
+    if (!file.Open(path) || file.Size() < sizeof(TraceStoreHeader)) return false;
+    const TraceStoreHeader* h = reinterpret_cast<const TraceStoreHeader*>(file.Data());
+    if (std::memcmp(h->magic, TraceStoreHeader::MAGIC, sizeof(h->magic)) != 0 || h->version != TraceStoreHeader::VERSION ||
+        h->indexOffset > file.Size() || h->chunkCount > (file.Size() - h->indexOffset) / sizeof(TraceChunkIndex)) {
+        return false;
+    }
+    header = h;
+    index = reinterpret_cast<const TraceChunkIndex*>(file.Data() + h->indexOffset);
+    count = size_t(h->chunkCount);
+    return true;
+}
+
+bool TraceStoreReader::ReadChunk(size_t i, std::vector<TraceRecord>& records, std::vector<TraceWrite>& writes,
+                                 std::vector<uint32_t>& frameStarts) const {
+    if (i >= count) return false;
+    const TraceChunkIndex& idx = index[i];
+    size_t writeBytes = size_t(idx.writeCount) * sizeof(TraceWrite);
+    size_t frameBytes = size_t(idx.frameStartCount) * sizeof(uint32_t);
+    if (idx.offset + idx.recordBytes + writeBytes + frameBytes > header->indexOffset) return false;
+    const uint8_t* p = file.Data() + idx.offset;
+    if (!DecodeRecords(p, idx.recordBytes, idx.count, records)) return false;
+    p += idx.recordBytes;
+    writes.resize(idx.writeCount);
+    std::memcpy(writes.data(), p, writeBytes);
+    p += writeBytes;
+    frameStarts.resize(idx.frameStartCount);
+    std::memcpy(frameStarts.data(), p, frameBytes);
+    return true;
+}
+
+std::vector<TraceHit> TraceStoreReader::FindWrites(uint16_t addr, uint64_t firstFrame, uint64_t lastFrame, size_t limit) {
+    std::vector<TraceHit> hits;
+    uint16_t canonical = CanonicalAddr(addr);
+    std::vector<TraceRecord> records;
+    std::vector<TraceWrite> writes;
+    std::vector<uint32_t> frameStarts;
+    for (size_t i = 0; i < count && hits.size() < limit; ++i) {
+        const TraceChunkIndex& idx = index[i];
+        if (idx.lastFrame < firstFrame || idx.firstFrame > lastFrame || !idx.HasWriteBlock(canonical)) continue;
+        if (!ReadChunk(i, records, writes, frameStarts)) break;
+        ++decoded;
+        for (const TraceWrite& w : writes) {
+            if (CanonicalAddr(w.addr) != canonical || w.instruction >= records.size()) continue;
+            uint64_t f = FrameAt(idx, frameStarts, w.instruction);
+            if (f < firstFrame || f > lastFrame) continue;
+            hits.push_back({idx.firstInstruction + w.instruction, f, records[w.instruction], w.addr, w.value});
+            if (hits.size() == limit) break;
+        }
+    }
+    return hits;
+}
+
+bool TraceStoreReader::FindPC(uint16_t pc, uint64_t firstFrame, TraceHit& out) {
+    std::vector<TraceRecord> records;
+    std::vector<TraceWrite> writes;
+    std::vector<uint32_t> frameStarts;
+    for (size_t i = 0; i < count; ++i) {
+        const TraceChunkIndex& idx = index[i];
+        if (idx.lastFrame < firstFrame || pc < idx.pcMin || pc > idx.pcMax || !idx.HasPcPage(pc)) continue;
+        if (!ReadChunk(i, records, writes, frameStarts)) return false;
+        ++decoded;
+        for (uint32_t k = 0; k < records.size(); ++k) {
+            if (records[k].pc != pc) continue;
+            uint64_t f = FrameAt(idx, frameStarts, k);
+            if (f < firstFrame) continue;
+            out = {idx.firstInstruction + k, f, records[k]};
+            return true;
+        }
+    }
+    return false;
+}